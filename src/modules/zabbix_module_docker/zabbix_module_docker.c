@@ -30,8 +30,18 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <grp.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdarg.h>
 #include <jansson.h>
+#include "zabbix_module_docker_scan.h"
 
 #ifndef ZBX_MODULE_API_VERSION
 #       define ZBX_MODULE_API_VERSION   ZBX_MODULE_API_VERSION_ONE
@@ -44,9 +54,513 @@ struct inspect_result
 };
 struct timeval stimeout = { .tv_sec = 30, .tv_usec = 0 };
 
-char    *m_version = "v0.7.0";
+#define ZBX_DOCKER_SOCKET       "/var/run/docker.sock"
+#define ZBX_DOCKER_JSON_WS      " \t\r\n"
+
+// bump pointer arena of transient allocations of one item call, per agent process
+#define ZBX_DOCKER_ARENA_SIZE   65536   // bytes, the first block
+#define ZBX_DOCKER_ARENA_MAX    (16 * ZBX_DOCKER_ARENA_SIZE)    // bytes kept between calls
+
+typedef struct zbx_docker_arena_block
+{
+        struct zbx_docker_arena_block   *next;
+        size_t                          size;
+        size_t                          used;
+        char                            data[] __attribute__((aligned(16)));
+}
+zbx_docker_arena_block_t;
+
+// module self-instrumentation (docker.module.stats)
+#define ZBX_DOCKER_STATS_SLOTS          64      // agent processes with own counters, slot 0 is shared
+#define ZBX_DOCKER_STATS_KEYS           64      // >= number of item keys
+#define ZBX_DOCKER_STATS_BUCKETS        9       // latency histogram buckets, see stats_bucket_ms
+
+typedef struct
+{
+        zbx_uint64_t    count;
+        zbx_uint64_t    errors;
+        zbx_uint64_t    bytes;
+        zbx_uint64_t    latency_us;
+        zbx_uint64_t    histogram[ZBX_DOCKER_STATS_BUCKETS];
+}
+zbx_docker_counter_t;
+
+enum
+{
+        ZBX_DOCKER_ENDPOINT_PING,
+        ZBX_DOCKER_ENDPOINT_INFO,
+        ZBX_DOCKER_ENDPOINT_CONTAINERS,
+        ZBX_DOCKER_ENDPOINT_INSPECT,
+        ZBX_DOCKER_ENDPOINT_STATS,
+        ZBX_DOCKER_ENDPOINT_IMAGES,
+        ZBX_DOCKER_ENDPOINT_VOLUMES,
+        ZBX_DOCKER_ENDPOINT_OTHER,
+        ZBX_DOCKER_ENDPOINT_COUNT
+};
+
+enum
+{
+        ZBX_DOCKER_CACHE_API,
+        ZBX_DOCKER_CACHE_STORE,
+        ZBX_DOCKER_CACHE_CPU_LIMITS,
+        ZBX_DOCKER_CACHE_PERCPU,
+        ZBX_DOCKER_CACHE_BLKIO,
+        ZBX_DOCKER_CACHE_NETNS,
+        ZBX_DOCKER_CACHE_PATH,
+        ZBX_DOCKER_CACHE_DOCUMENT,
+        ZBX_DOCKER_CACHE_INFO,
+        ZBX_DOCKER_CACHE_CPU_USAGE,
+        ZBX_DOCKER_CACHE_NUMA,
+        ZBX_DOCKER_CACHE_COUNT
+};
+
+typedef struct
+{
+        pid_t                   pid;
+        zbx_docker_counter_t    keys[ZBX_DOCKER_STATS_KEYS];
+        zbx_docker_counter_t    endpoints[ZBX_DOCKER_ENDPOINT_COUNT];
+        zbx_uint64_t            cache_hits[ZBX_DOCKER_CACHE_COUNT];
+        zbx_uint64_t            cache_misses[ZBX_DOCKER_CACHE_COUNT];
+}
+zbx_docker_stats_t;
+
+// trace ring of recent Docker API queries (docker.module.trace)
+#define ZBX_DOCKER_TRACE_SIZE   256
+
+typedef struct
+{
+        zbx_uint64_t    seq;
+        time_t          clock;
+        pid_t           pid;
+        int             status;
+        int             error;
+        zbx_uint64_t    bytes;
+        zbx_uint64_t    latency_us;
+        char            request[128];
+}
+zbx_docker_trace_t;
+
+typedef struct
+{
+        zbx_uint64_t            next;
+        zbx_docker_trace_t      entries[ZBX_DOCKER_TRACE_SIZE];
+}
+zbx_docker_trace_ring_t;
+
+// columnar metric store of all containers (docker.summary, docker.top, docker.bulk)
+#define ZBX_DOCKER_STORE_TTL            1000000 // usec, store is refreshed at most once per TTL
+#define ZBX_DOCKER_STORE_SLOTS          64      // initial number of slots
+
+enum
+{
+        ZBX_DOCKER_COLUMN_RSS,
+        ZBX_DOCKER_COLUMN_CACHE,
+        ZBX_DOCKER_COLUMN_SWAP,
+        ZBX_DOCKER_COLUMN_CPU_USER,
+        ZBX_DOCKER_COLUMN_CPU_SYSTEM,
+        ZBX_DOCKER_COLUMN_BLKIO_READ,
+        ZBX_DOCKER_COLUMN_BLKIO_WRITE,
+        ZBX_DOCKER_COLUMN_COUNT
+};
+
+typedef struct
+{
+        int                     slots_num;      // highest used slot + 1
+        int                     slots_alloc;
+        int                     live_num;
+        char                    **ids;          // full container id, NULL - free slot
+        unsigned int            *seen;          // generation of the last enumeration with the container
+        zbx_uint64_t            *columns[ZBX_DOCKER_COLUMN_COUNT];
+        int                     *free_slots;
+        int                     free_num;
+        int                     *index;         // open addressing, container id -> slot + 1
+        int                     index_mask;
+        unsigned int            generation;
+        zbx_uint64_t            refreshed;
+        zbx_docker_scan_t       *scan;
+        double                  *pressure;      // ZBX_DOCKER_PRESSURE_COUNT values per slot, -1 - not available
+        int                     pressure_used;
+}
+zbx_docker_store_t;
+
+// Pressure Stall Information: <cpu|memory|io> x <some|full> x <avg10|avg60|avg300|total>
+#define ZBX_DOCKER_PRESSURE_COUNT       24
+
+// previous samples of cumulative counters for rate keys (docker.cpu.rate, ...)
+#define ZBX_DOCKER_RATE_SIZE            4096    // samples, power of 2
+#define ZBX_DOCKER_RATE_PROBES          16      // open addressing probe limit
+#define ZBX_DOCKER_RATE_MIN_INTERVAL    100000  // usec, faster calls return the previous rate
+#define ZBX_DOCKER_RATE_EXPIRE          3600    // sec, older samples are reused for new items
+
+typedef struct
+{
+        zbx_uint64_t    hash;           // key with parameters, 0 - free sample
+        pthread_mutex_t lock;           // robust, process shared
+        zbx_uint64_t    value;
+        zbx_uint64_t    time_us;        // CLOCK_MONOTONIC
+        double          rate;           // -1 - only the first sample is stored
+}
+zbx_docker_rate_t;
+
+// CPU entitlement of containers (docker.cpu.util), per agent process
+#define ZBX_DOCKER_LIMITS_SIZE          256     // direct mapped by container id hash
+
+typedef struct
+{
+        char            id[128];
+        ino_t           ino;            // cgroup directory, new inode after container restart
+        double          cpus;
+}
+zbx_docker_limits_t;
+
+// CPU time of containers (docker.cpu usage, usage_user, usage_system), per agent process
+#define ZBX_DOCKER_CPU_USAGE_SIZE       64      // direct mapped by container id hash
+#define ZBX_DOCKER_CPU_USAGE_TTL        1000000 // usec, all three counters of one interval are from one read
+
+enum
+{
+        ZBX_DOCKER_CPU_USAGE,
+        ZBX_DOCKER_CPU_USAGE_USER,
+        ZBX_DOCKER_CPU_USAGE_SYSTEM,
+        ZBX_DOCKER_CPU_USAGE_COUNT
+};
+
+typedef struct
+{
+        char            id[128];
+        zbx_uint64_t    time_us;
+        int             has[ZBX_DOCKER_CPU_USAGE_COUNT];
+        zbx_uint64_t    values[ZBX_DOCKER_CPU_USAGE_COUNT];     // ns
+}
+zbx_docker_cpu_usage_t;
+
+// per-CPU usage of containers (docker.cpu.percpu), per agent process
+#define ZBX_DOCKER_PERCPU_SIZE          64      // direct mapped by container id hash
+#define ZBX_DOCKER_PERCPU_TTL           1000000 // usec, all CPUs of one interval are from one read
+
+typedef struct
+{
+        char            id[128];
+        zbx_uint64_t    time_us;
+        int             values_num;
+        zbx_uint64_t    *values;        // ns
+}
+zbx_docker_percpu_t;
+
+// parsed blkio files (docker.dev), per agent process
+#define ZBX_DOCKER_BLKIO_SIZE           64      // direct mapped by file path hash
+#define ZBX_DOCKER_BLKIO_TTL            1000000 // usec, all devices and operations of one interval are from one parse
+#define ZBX_DOCKER_BLKDEV_SIZE          64      // device names, direct mapped by major:minor
+#define ZBX_DOCKER_BLKDEV_TTL           60      // sec
+
+typedef struct
+{
+        int             dev;            // 0 - line without device, e.g. Total
+        unsigned int    major;
+        unsigned int    minor;
+        char            op[24];         // Read, Write, ..., io.stat field, empty for single value files
+        zbx_uint64_t    value;
+}
+zbx_docker_blkio_value_t;
+
+typedef struct
+{
+        char                            *path;
+        zbx_uint64_t                    time_us;
+        int                             values_num;
+        int                             values_alloc;
+        zbx_docker_blkio_value_t        *values;
+}
+zbx_docker_blkio_t;
+
+typedef struct
+{
+        unsigned int    major;
+        unsigned int    minor;
+        time_t          time;
+        char            name[32];       // empty - unknown device
+}
+zbx_docker_blkdev_t;
+
+// protocol statistics of container network namespace (docker.netproto), per agent process
+#define ZBX_DOCKER_NETNS_SIZE           64      // direct mapped by container id hash
+#define ZBX_DOCKER_NETNS_TTL            1000000 // usec, all counters of one interval are from one read per file
+
+typedef struct
+{
+        char            proto[16];      // Tcp, TcpExt, ... (snmp, netstat), TCP, UDP, ... (sockstat)
+        char            name[48];
+        zbx_int64_t     value;
+}
+zbx_docker_netproto_value_t;
+
+// interface counters of /proc/<pid>/net/dev (docker.xnet, docker.net.discovery)
+#define ZBX_DOCKER_NETDEV_COUNT         16
+
+typedef struct
+{
+        char            name[32];
+        zbx_uint64_t    values[ZBX_DOCKER_NETDEV_COUNT];
+}
+zbx_docker_netif_t;
+
+typedef struct
+{
+        char                            id[128];
+        zbx_uint64_t                    time_us;
+        int                             values_num;
+        int                             values_alloc;
+        zbx_docker_netproto_value_t     *values;
+        int                             ifs_num;
+        int                             ifs_alloc;
+        zbx_docker_netif_t              *ifs;
+}
+zbx_docker_netns_t;
+
+// compiled JSON paths of docker.inspect and docker.stats items, per agent process
+#define ZBX_DOCKER_PATH_SIZE            256     // direct mapped by hash of item parameters
+
+enum
+{
+        ZBX_DOCKER_STEP_MEMBER,         // name, ["name"]
+        ZBX_DOCKER_STEP_INDEX,          // [N]
+        ZBX_DOCKER_STEP_FILTER          // [name=value], the first array object with matching member
+};
+
+typedef struct
+{
+        int             type;
+        int             index;
+        const char      *name;
+        const char      *value;
+}
+zbx_docker_path_step_t;
+
+typedef struct
+{
+        char                    *key;           // path parameters of the item, '\n' separated
+        char                    *buffer;        // names and values of steps
+        int                     steps_num;      // 0 - invalid path expression
+        zbx_docker_path_step_t  *steps;
+}
+zbx_docker_path_t;
+
+// inspect and stats documents of containers, per agent process
+#define ZBX_DOCKER_DOCUMENT_SIZE        64      // direct mapped by container id hash
+#define ZBX_DOCKER_DOCUMENT_TTL         1000000 // usec, all items of one interval are from one Docker API query
+#define ZBX_DOCKER_DOCUMENT_CGROUP      ZBX_DOCKER_ENDPOINT_COUNT       // stats document synthesised from cgroups
+
+typedef struct
+{
+        int             endpoint;
+        char            id[128];
+        zbx_uint64_t    time_us;
+        char            *body;
+}
+zbx_docker_document_t;
+
+// /info document shared by agent processes, refreshed by a thread of the agent main process (docker.info)
+#define ZBX_DOCKER_INFO_SIZE            (1024 * 1024)   // bytes, larger documents are not cached
+#define ZBX_DOCKER_INFO_TTL             30              // sec, default of ZBX_DOCKER_INFO_TTL
+
+typedef struct
+{
+        zbx_uint64_t    seq;            // odd - document is being written
+        zbx_uint64_t    time_us;        // time of the query, 0 - no document
+        zbx_uint64_t    used_us;        // the last item call, unused document is not refreshed
+        size_t          len;
+        char            data[ZBX_DOCKER_INFO_SIZE];
+}
+zbx_docker_info_t;
+
+// memory per NUMA node (docker.numa)
+#define ZBX_DOCKER_NUMA_NODES           64
+
+enum
+{
+        ZBX_DOCKER_NUMA_TOTAL,
+        ZBX_DOCKER_NUMA_FILE,
+        ZBX_DOCKER_NUMA_ANON,
+        ZBX_DOCKER_NUMA_METRICS
+};
+
+typedef struct
+{
+        zbx_uint64_t    nodes;          // mask of nodes in memory.numa_stat
+        zbx_uint64_t    local;          // mask of local nodes, see zbx_docker_numa_local()
+        zbx_uint64_t    values[ZBX_DOCKER_NUMA_NODES][ZBX_DOCKER_NUMA_METRICS];  // bytes
+}
+zbx_docker_numa_t;
+
+// parsed memory.numa_stat and local nodes of containers, per agent process
+#define ZBX_DOCKER_NUMA_SIZE            64      // direct mapped by container id hash
+#define ZBX_DOCKER_NUMA_TTL             1000000 // usec, all nodes and metrics of one interval are from one parse
+
+typedef struct
+{
+        char                    id[128];
+        zbx_uint64_t            time_us;
+        ino_t                   ino;    // cpuset cgroup directory, local nodes are re-read after container restart
+        zbx_docker_numa_t       numa;
+}
+zbx_docker_numa_cache_t;
+
+// background sampler of all containers (docker.cpu.peak, ...), ZBX_DOCKER_SAMPLER=<interval>
+#define ZBX_DOCKER_SAMPLER_CONTAINERS   256
+#define ZBX_DOCKER_SAMPLER_RING         300     // samples per container
+
+typedef struct
+{
+        zbx_uint64_t    time_us;        // CLOCK_MONOTONIC
+        double          cpu;            // % of CPU entitlement
+        double          throttled;      // % of throttled CFS periods
+        zbx_uint64_t    mem;            // bytes
+}
+zbx_docker_sample_t;
+
+// scheduler statistics of the container (docker.sched), ZBX_DOCKER_SCHED=<interval>
+typedef struct
+{
+        zbx_uint64_t    tasks;          // now
+        zbx_uint64_t    run_delay;      // ns waiting on run queue, counters are monotonic
+        zbx_uint64_t    timeslices;
+        zbx_uint64_t    voluntary;      // context switches
+        zbx_uint64_t    nonvoluntary;
+        double          wait;           // ms of run queue wait per timeslice in the last interval
+        double          delay;          // run queue wait in seconds per second in the last interval
+}
+zbx_docker_sched_t;
+
+typedef struct
+{
+        zbx_uint64_t            epoch;  // odd while the entry is being (re)assigned
+        char                    id[128];
+        zbx_uint64_t            seq;    // number of samples written
+        zbx_docker_sample_t     samples[ZBX_DOCKER_SAMPLER_RING];
+        zbx_uint64_t            sched_seq;      // odd while sched is being written
+        zbx_docker_sched_t      sched;
+}
+zbx_docker_sampler_entry_t;
+
+// OOM and memory pressure notifications (docker.mem.events), ZBX_DOCKER_EVENTS=1
+#define ZBX_DOCKER_EVENTS_CONTAINERS    256
+#define ZBX_DOCKER_EVENTS_RESCAN        5       // sec, new and removed containers
+#define ZBX_DOCKER_EVENTS_TRIGGER       "some 200000 2000000"
+
+enum
+{
+        ZBX_DOCKER_EVENT_OOM,
+        ZBX_DOCKER_EVENT_OOM_KILL,
+        ZBX_DOCKER_EVENT_HIGH,
+        ZBX_DOCKER_EVENT_MAX,
+        ZBX_DOCKER_EVENT_PRESSURE,
+        ZBX_DOCKER_EVENT_COUNT
+};
+
+typedef struct
+{
+        zbx_uint64_t    epoch;  // odd while the entry is being (re)assigned
+        char            id[128];
+        zbx_uint64_t    counters[ZBX_DOCKER_EVENT_COUNT];
+}
+zbx_docker_events_entry_t;
+
+// descriptors of the event thread: v1 - oom and pressure eventfd, v2 - memory.events and PSI trigger
+typedef struct
+{
+        int             fds[2];
+        unsigned int    generation;
+}
+zbx_docker_events_watch_t;
+
+// running containers tracked by inotify on the cgroup driver directory, per agent process
+#define ZBX_DOCKER_LIVE_RETRY           60      // sec, retry of failed inotify setup
+#define ZBX_DOCKER_LIVE_REMOVED         ((char *)&live)
+
+typedef struct
+{
+        pid_t           pid;
+        int             fd;
+        char            *dir;
+        char            **ids;          // open addressing, NULL - free, ZBX_DOCKER_LIVE_REMOVED - removed
+        int             ids_alloc;
+        int             ids_num;
+        int             removed_num;
+        time_t          failed;
+}
+zbx_docker_live_t;
+
+// formatting of debug messages is skipped if debug level is not active
+#if defined(ZBX_CHECK_LOG_LEVEL)
+#       define ZBX_DOCKER_DEBUG()       (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+#else
+#       define ZBX_DOCKER_DEBUG()       (SUCCEED == zabbix_check_log_level(LOG_LEVEL_DEBUG))
+#endif
+
+static const char       *netdev_metrics[ZBX_DOCKER_NETDEV_COUNT] = {"rx_bytes", "rx_packets", "rx_errs", "rx_drop",
+                "rx_fifo", "rx_frame", "rx_compressed", "rx_multicast", "tx_bytes", "tx_packets", "tx_errs", "tx_drop",
+                "tx_fifo", "tx_colls", "tx_carrier", "tx_compressed"};
+// netstat -i columns of docker.xnet available in /proc/<pid>/net/dev, index of netdev_metrics
+static const struct
+{
+        const char      *name;
+        int             index;
+}
+netdev_netstat[] = {{"RX-OK", 1}, {"RX-ERR", 2}, {"RX-DRP", 3}, {"RX-OVR", 4}, {"TX-OK", 9}, {"TX-ERR", 10},
+                {"TX-DRP", 11}, {"TX-OVR", 12}};
+static const char       *stats_endpoint_names[ZBX_DOCKER_ENDPOINT_COUNT] = {"/_ping", "/info", "/containers/json",
+                "/containers/{id}/json", "/containers/{id}/stats", "/images/json", "/volumes", "other"};
+static const char       *stats_cache_names[ZBX_DOCKER_CACHE_COUNT] = {"api_detect", "store", "cpu_limits", "percpu",
+                "blkio", "netns", "json_path", "document", "info", "cpu_usage", "numa"};
+static const int        stats_bucket_ms[ZBX_DOCKER_STATS_BUCKETS - 1] = {1, 5, 10, 50, 100, 500, 1000, 5000};
+static zbx_docker_stats_t       *stats = NULL, *stats_slot = NULL;
+static zbx_docker_trace_ring_t  *trace = NULL;
+static zbx_docker_arena_block_t *arena = NULL;
+static zbx_docker_rate_t        *rates = NULL;
+static zbx_docker_limits_t      limits[ZBX_DOCKER_LIMITS_SIZE];
+static zbx_docker_percpu_t      percpu[ZBX_DOCKER_PERCPU_SIZE];
+static zbx_docker_cpu_usage_t   cpu_usage_cache[ZBX_DOCKER_CPU_USAGE_SIZE];
+static zbx_docker_numa_cache_t  numa_cache[ZBX_DOCKER_NUMA_SIZE];
+static zbx_docker_blkio_t       blkio_cache[ZBX_DOCKER_BLKIO_SIZE];
+static zbx_docker_blkdev_t      blkdev_cache[ZBX_DOCKER_BLKDEV_SIZE];
+static zbx_docker_netns_t       netns_cache[ZBX_DOCKER_NETNS_SIZE];
+static zbx_docker_path_t        path_cache[ZBX_DOCKER_PATH_SIZE];
+static zbx_docker_document_t    document_cache[ZBX_DOCKER_DOCUMENT_SIZE];
+static zbx_docker_sampler_entry_t       *sampler = NULL;
+static int              sampler_interval = 0, sampler_stop = 0, sched_interval = 0, sched_pass;
+static pid_t            sampler_pid;
+static pthread_t        sampler_thread;
+static pthread_mutex_t  sampler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   sampler_cond;
+static zbx_docker_events_entry_t        *events;
+static int              events_enabled = 0, events_wake[2] = {-1, -1};
+static int              stats_cgroup = 0;       // docker.stats answered from cgroups (ZBX_DOCKER_STATS_CGROUP=1)
+static zbx_docker_info_t        *info_cache = NULL;
+static int              info_ttl = ZBX_DOCKER_INFO_TTL, info_stop = 0;
+static pid_t            info_pid;
+static pthread_t        info_thread;
+static pthread_mutex_t  info_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   info_cond;
+static unsigned int     events_generation;
+static pid_t            events_pid;
+static pthread_t        events_thread;
+static const char       *event_names[ZBX_DOCKER_EVENT_COUNT] = {"oom", "oom_kill", "high", "max", "pressure"};
+static zbx_docker_live_t        live = {.fd = -1};
+static pthread_mutex_t  live_lock = PTHREAD_MUTEX_INITIALIZER;
+static time_t           stats_start;
+static const char       *store_column_names[ZBX_DOCKER_COLUMN_COUNT] = {"rss", "cache", "swap", "cpu_user",
+                "cpu_system", "blkio_read", "blkio_write"};
+static zbx_docker_store_t       store;
+static const char       *pressure_resources[] = {"cpu", "memory", "io"};
+static const char       *pressure_types[] = {"some", "full"};
+static const char       *pressure_fields[] = {"avg10", "avg60", "avg300", "total"};
+
+char    *m_version = "v0.8.0";
 char    *stat_dir = NULL, *driver, *c_prefix = NULL, *c_suffix = NULL, *cpu_cgroup = NULL, *hostname = 0;
-static int item_timeout = 1, buffer_size = 1024, socket_api;
+char    *docker_socket = NULL, *rootfs = "";
+static int item_timeout = 1, buffer_size = 1024, socket_api, cgroup_v2 = 0;
+static long clk_tck = 100, cpu_online = 1, page_size = 4096;  // sysconf() values cached in zbx_module_init()
+static const char       *numa_metrics[ZBX_DOCKER_NUMA_METRICS] = {"total", "file", "anon"};
 int     zbx_module_docker_discovery(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_port_discovery(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_inspect(AGENT_REQUEST *request, AGENT_RESULT *result);
@@ -55,12 +569,60 @@ int     zbx_module_docker_istatus(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_vstatus(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_info(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_stats(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_stats_derived(AGENT_REQUEST *request, AGENT_RESULT *result);
+char    *zbx_docker_stats_cgroup(const char *container);
 int     zbx_module_docker_up(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_mem(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_cpu(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_net(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_netproto(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_net_discovery(AGENT_REQUEST *request, AGENT_RESULT *result);
 int     zbx_module_docker_dev(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_dev_discovery(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_numa(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_numa_bulk(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_dev_latency(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_docker_pressure_index(const char *resource, const char *type, const char *field);
 int     zbx_module_docker_modver(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_module_stats(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_module_trace(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_summary(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_top(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_bulk(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_cpu_rate(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_mem_rate(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_dev_rate(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_net_rate(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_cpu_util(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_cpu_throttled(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_cpu_percpu(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_cpu_peak(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_mem_peak(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_throttled_peak(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_sched(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_docker_stats_item(AGENT_REQUEST *request, AGENT_RESULT *result);
+unsigned int    zbx_docker_id_hash(const char *id);
+void    zbx_docker_stats_atfork();
+void    zbx_docker_store_free();
+void    zbx_docker_sampler_init();
+void    zbx_docker_sampler_uninit();
+int     zbx_docker_containers_enum(void (*callback)(const char *container, void *arg), void *arg);
+int     zbx_docker_container_live(const char *container);
+void    zbx_docker_live_prepare();
+void    zbx_docker_live_release();
+void    zbx_docker_live_reset();
+void    zbx_docker_live_atfork();
+void    zbx_docker_events_init();
+void    zbx_docker_events_uninit();
+void    zbx_docker_info_init();
+void    zbx_docker_info_uninit();
+int     zbx_module_docker_mem_events(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_docker_cpu_usage(const char *container, const char *metric, zbx_uint64_t *usage);
+int     zbx_docker_scan_read(zbx_docker_scan_t *scan, const char *path);
+void    zbx_docker_pressure_read(const char *container, double *values);
+int     zbx_module_docker_pressure(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_pressure_top(AGENT_REQUEST *request, AGENT_RESULT *result);
+int     zbx_module_docker_pressure_bulk(AGENT_REQUEST *request, AGENT_RESULT *result);
 
 static ZBX_METRIC keys[] =
 /*      KEY                     FLAG            FUNCTION                TEST PARAMETERS */
@@ -73,14 +635,42 @@ static ZBX_METRIC keys[] =
         {"docker.vstatus", CF_HAVEPARAMS, zbx_module_docker_vstatus, "status"},
         {"docker.info", CF_HAVEPARAMS,  zbx_module_docker_info, "full container id, info"},
         {"docker.stats",CF_HAVEPARAMS,  zbx_module_docker_stats,"full container id, parameter 1, <parameter 2>, <parameter 3>"},
+        {"docker.stats.derived", CF_HAVEPARAMS, zbx_module_docker_stats_derived, "full container id"},
         {"docker.up",   CF_HAVEPARAMS,  zbx_module_docker_up,   "full container id"},
         {"docker.mem",  CF_HAVEPARAMS,  zbx_module_docker_mem,  "full container id, memory metric name"},
         {"docker.cpu",  CF_HAVEPARAMS,  zbx_module_docker_cpu,  "full container id, cpu metric name"},
         {"docker.xnet", CF_HAVEPARAMS,  zbx_module_docker_net,  "full container id, interface, network metric name"},
-        {"docker.dev",  CF_HAVEPARAMS,  zbx_module_docker_dev,  "full container id, blkio file, blkio metric name"},
+        {"docker.netproto", CF_HAVEPARAMS,  zbx_module_docker_netproto,  "full container id, protocol, counter name"},
+        {"docker.net.discovery", CF_HAVEPARAMS,  zbx_module_docker_net_discovery,  "full container id"},
+        {"docker.dev",  CF_HAVEPARAMS,  zbx_module_docker_dev,  "full container id, blkio file, blkio metric name, <device>"},
+        {"docker.dev.discovery",  CF_HAVEPARAMS,  zbx_module_docker_dev_discovery,  "full container id, <blkio file>"},
+        {"docker.dev.latency",  CF_HAVEPARAMS,  zbx_module_docker_dev_latency,  "full container id, <await|svctm|wait|queued|pressure>, <read|write|total>, <device>"},
+        {"docker.cpu.rate",  CF_HAVEPARAMS,  zbx_module_docker_cpu_rate,  "full container id, cpu metric name"},
+        {"docker.cpu.util",  CF_HAVEPARAMS,  zbx_module_docker_cpu_util,  "full container id, <util|limit>"},
+        {"docker.cpu.throttled",  CF_HAVEPARAMS,  zbx_module_docker_cpu_throttled,  "full container id"},
+        {"docker.cpu.percpu",  CF_HAVEPARAMS,  zbx_module_docker_cpu_percpu,  "full container id, <cpu>"},
+        {"docker.cpu.peak",  CF_HAVEPARAMS,  zbx_module_docker_cpu_peak,  "full container id, <max|p95|avg|min|count>"},
+        {"docker.mem.peak",  CF_HAVEPARAMS,  zbx_module_docker_mem_peak,  "full container id, <max|p95|avg|min|count>"},
+        {"docker.cpu.throttled.peak",  CF_HAVEPARAMS,  zbx_module_docker_throttled_peak,  "full container id, <max|p95|avg|min|count>"},
+        {"docker.sched",  CF_HAVEPARAMS,  zbx_module_docker_sched,  "full container id, <wait|delay|run_delay|timeslices|voluntary|nonvoluntary|tasks>"},
+        {"docker.mem.rate",  CF_HAVEPARAMS,  zbx_module_docker_mem_rate,  "full container id, memory metric name"},
+        {"docker.dev.rate",  CF_HAVEPARAMS,  zbx_module_docker_dev_rate,  "full container id, blkio file, blkio metric name, <device>"},
+        {"docker.xnet.rate", CF_HAVEPARAMS,  zbx_module_docker_net_rate,  "full container id, interface, network metric name"},
+        {"docker.numa", CF_HAVEPARAMS,  zbx_module_docker_numa,  "full container id, <node|local|remote|all>, <total|file|anon|locality>"},
+        {"docker.mem.events", CF_HAVEPARAMS,  zbx_module_docker_mem_events,  "full container id, <oom|oom_kill|high|max|pressure>"},
+        {"docker.pressure", CF_HAVEPARAMS,  zbx_module_docker_pressure,  "full container id, cpu|memory|io, <some|full>, <avg10|avg60|avg300|total>"},
         {"docker.modver",  CF_HAVEPARAMS,  zbx_module_docker_modver},
+        {"docker.module.stats",  CF_HAVEPARAMS,  zbx_module_docker_module_stats},
+        {"docker.module.trace",  CF_HAVEPARAMS,  zbx_module_docker_module_trace, "<count>"},
+        {"docker.summary",  CF_HAVEPARAMS,  zbx_module_docker_summary, "metric, <sum|avg|min|max|count>"},
+        {"docker.top",  CF_HAVEPARAMS,  zbx_module_docker_top, "metric, <count>"},
+        {"docker.bulk",  CF_HAVEPARAMS,  zbx_module_docker_bulk},
+        {"docker.pressure.top",  CF_HAVEPARAMS,  zbx_module_docker_pressure_top, "cpu|memory|io, <some|full>, <avg10|avg60|avg300|total>, <count>"},
+        {"docker.pressure.bulk",  CF_HAVEPARAMS,  zbx_module_docker_pressure_bulk},
+        {"docker.numa.bulk",  CF_HAVEPARAMS,  zbx_module_docker_numa_bulk},
         {NULL}
 };
+static ZBX_METRIC item_list[sizeof(keys) / sizeof(keys[0])];
 
 /******************************************************************************
  *                                                                            *
@@ -126,1524 +716,7503 @@ void    zbx_module_item_timeout(int timeout)
 ZBX_METRIC      *zbx_module_item_list()
 {
         zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_item_list()");
-        return keys;
+        int     i;
+
+        // all keys are called through zbx_docker_stats_item(), which measures them
+        for (i = 0; NULL != keys[i].key; i++)
+        {
+            item_list[i] = keys[i];
+            item_list[i].function = zbx_docker_stats_item;
+        }
+        return item_list;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_socket_query                                   *
- *                                                                            *
- * Purpose: querying details via Docker socket API (permission is needed)      *
+ * Function: zbx_docker_stats_init                                            *
  *                                                                            *
- * Return value: empty string - function failed                               *
- *               string - response from Docker's socket API                   *
+ * Purpose: allocate counters of module self-instrumentation                  *
  *                                                                            *
- * Notes: https://docs.docker.com/reference/api/docker_remote_api/            *
- *        echo -e "GET /containers/json?all=1 HTTP/1.0\r\n" | \               *
- *        nc -U /var/run/docker.sock                                          *
+ * Notes: module is loaded before agent forks its collectors, so anonymous    *
+ *        shared mapping is shared by all agent processes; every process      *
+ *        updates its own slot and docker.module.stats sums all slots         *
  ******************************************************************************/
-const char*  zbx_module_docker_socket_query(char *query, int stream)
+void    zbx_docker_stats_init()
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_socket_query()");
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_stats_init()");
+        static zbx_docker_stats_t       local;
 
-        struct sockaddr_un address;
-        int sock, nbytes;
-        size_t addr_length;
-        char buffer[buffer_size+1];
-        char *response_substr, *response, *empty="", *message = NULL, *temp1, *temp2;
-        if ((sock = socket(PF_UNIX, SOCK_STREAM, 0)) < 0)
+        stats_start = time(NULL);
+        trace = mmap(NULL, sizeof(zbx_docker_trace_ring_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == trace)
         {
-            zabbix_log(LOG_LEVEL_WARNING, "Cannot create socket for docker's communication");
-            return empty;
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot allocate shared memory for Docker API trace: %s", zbx_strerror(errno));
+            trace = NULL;
         }
-        address.sun_family = AF_UNIX;
-        zbx_strlcpy(address.sun_path, "/var/run/docker.sock", strlen("/var/run/docker.sock")+1);
-        addr_length = sizeof(address.sun_family) + strlen(address.sun_path);
-        if (connect(sock, (struct sockaddr *) &address, addr_length))
+        stats = mmap(NULL, sizeof(zbx_docker_stats_t) * ZBX_DOCKER_STATS_SLOTS, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == stats)
         {
-            zabbix_log(LOG_LEVEL_WARNING, "Cannot connect to standard docker's socket /var/run/docker.sock");
-            return empty;
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot allocate shared memory for module statistics: %s, only"
+                    " statistics of the current process will be available", zbx_strerror(errno));
+            stats = stats_slot = &local;
+            return;
         }
+        stats_slot = NULL;
+        pthread_atfork(NULL, NULL, zbx_docker_stats_atfork);
+}
 
-        // socket input/output timeout
-        if (setsockopt (sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&stimeout, sizeof(stimeout)) < 0)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_atfork                                          *
+ *                                                                            *
+ * Purpose: forked agent process must claim its own counters slot             *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_stats_atfork()
+{
+        stats_slot = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_get_slot                                        *
+ *                                                                            *
+ * Purpose: get counters of the current process                               *
+ *                                                                            *
+ * Return value: counters slot, slot 0 is shared by processes which didn't    *
+ *               get own slot                                                 *
+ *                                                                            *
+ ******************************************************************************/
+zbx_docker_stats_t      *zbx_docker_stats_get_slot()
+{
+        int     i;
+        pid_t   pid = 0;
+
+        if (NULL != stats_slot)
         {
-            zabbix_log(LOG_LEVEL_WARNING, "Cannot set SO_RCVTIMEO socket timeout: %ld seconds", stimeout.tv_sec);
+            return stats_slot;
         }
-        if (setsockopt (sock, SOL_SOCKET, SO_SNDTIMEO, (char *)&stimeout, sizeof(stimeout)) < 0)
+        if (NULL == stats)
         {
-            zabbix_log(LOG_LEVEL_WARNING, "Cannot set SO_SNDTIMEO socket timeout: %ld seconds", stimeout.tv_sec);
+            return NULL;
         }
 
-        temp1 = string_replace(query, "\n", "");
-        temp2 = string_replace(temp1, "\r", "");
-        free(temp1);
-        zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket query: %s", temp2);
-        free(temp2);
-        write(sock, query, strlen(query));
-        message = realloc(NULL, 1);
-        if (message == NULL)
-        {
-            zabbix_log(LOG_LEVEL_WARNING, "Problem with allocating memory for Docker answer");
-            return empty;
-        }
-        strcat(message, "");
-        while ((nbytes = read(sock, buffer, buffer_size)) > 0 )
+        pid = getpid();
+        stats_slot = &stats[0];
+        for (i = 1; i < ZBX_DOCKER_STATS_SLOTS; i++)
         {
-            buffer[nbytes] = 0;
-            message = realloc(message, (strlen(message) + nbytes + 1));
-            if (message == NULL)
+            pid_t   expected = 0;
+
+            // slot of exited process (agent restarts its children) is reused
+            if (0 != stats[i].pid && 0 != kill(stats[i].pid, 0) && ESRCH == errno)
             {
-                zabbix_log(LOG_LEVEL_WARNING, "Problem with allocating memory");
-                return empty;
+                expected = stats[i].pid;
             }
-            strcat(message, buffer);
-            // wait only for first chunk of (stats) stream
-            if (stream == 1)
+            if (__atomic_compare_exchange_n(&stats[i].pid, &expected, pid, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
             {
-                if ((strstr(message, "}\n")) != NULL)
-                {
-                    break;
-                }
+                stats_slot = &stats[i];
+                break;
             }
         }
-        close(sock);
-        // remove http header
-        if ((response_substr = strstr(message, "\r\n\r\n")))
-        {
-            response_substr += 4;
-            size_t response_size = strlen(response_substr) + 1;
-            response = malloc(response_size);
-            zbx_strlcpy(response, response_substr, response_size);
-        } else {
-            response = malloc(5);
-            zbx_strlcpy(response, "[{}]", 5);
-        }
-        free(message);
-
-        temp1 = string_replace(response, "\n", "");
-        temp2 = string_replace(temp1, "\r", "");
-        free(temp1);
-        zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket response: %s", temp2);
-        free(temp2);
-        return response;
+        return stats_slot;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_docker_perm                                                  *
+ * Function: zbx_docker_arena_alloc                                           *
  *                                                                            *
- * Purpose: test if agent has docker permission (docker group membership)     *
+ * Purpose: allocate transient memory of the current item call                *
  *                                                                            *
- * Return value: ZBX_MODULE_OK - has docker perm                              *
- *               ZBX_MODULE_FAIL - has not docker perm                        *
+ * Return value: memory valid until zbx_docker_arena_reset(), it's not freed  *
  *                                                                            *
+ * Notes: only for item functions, background threads use malloc             *
  ******************************************************************************/
-int     zbx_docker_perm()
+void    *zbx_docker_arena_alloc(size_t size)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_perm()");
-        // I hope that zabbix user cannot be member of more than 10 groups
-        int j, ngroups = 10;
-        gid_t *groups;
-        struct group *gr;
-        groups = malloc(ngroups * sizeof (gid_t));
-        if (groups == NULL)
-        {
-            zabbix_log(LOG_LEVEL_WARNING, "Malloc error");
-            return 0;
-        }
+        zbx_docker_arena_block_t        *block;
+        size_t                          alloc;
+        void                            *ptr;
 
-        struct passwd *p = getpwuid(geteuid());
-        if (getgrouplist(p->pw_name, geteuid(), groups, &ngroups) == -1)
+        size = (size + 15) & ~(size_t)15;
+        if (NULL == arena || arena->size - arena->used < size)
         {
-             zabbix_log(LOG_LEVEL_WARNING, "getgrouplist() returned -1; ngroups = %d\n", ngroups);
-             free(groups);
-             return 0;
+                alloc = NULL == arena ? ZBX_DOCKER_ARENA_SIZE : arena->size * 2;
+                while (alloc < size)
+                        alloc *= 2;
+                if (NULL == (block = malloc(sizeof(zbx_docker_arena_block_t) + alloc)))
+                {
+                        zabbix_log(LOG_LEVEL_CRIT, "Cannot allocate %zu bytes of item arena", alloc);
+                        exit(EXIT_FAILURE);
+                }
+                block->next = arena;
+                block->size = alloc;
+                block->used = 0;
+                arena = block;
         }
+        ptr = arena->data + arena->used;
+        arena->used += size;
 
-        for (j = 0; j < ngroups; j++)
-        {
-               gr = getgrgid(groups[j]);
-               if (gr != NULL)
-               {
-                   if (strcmp(gr->gr_name, "docker") == 0)
-                   {
-                       zabbix_log(LOG_LEVEL_DEBUG, "zabbix agent user has docker perm");
-                       free(groups);
-                       return 1;
-                   }
-               }
-        }
-        free(groups);
-        return 0;
+        return ptr;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_docker_api_detect                                            *
+ * Function: zbx_docker_arena_strdup                                          *
  *                                                                            *
- * Purpose: the function is trying to test Docker API availability            *
+ * Purpose: copy string to the arena                                          *
  *                                                                            *
- * Return value: 0 - API not detected                                         *
- *               1 - API detected                                             *
+ ******************************************************************************/
+char    *zbx_docker_arena_strdup(const char *str)
+{
+        size_t  len = strlen(str) + 1;
+
+        return memcpy(zbx_docker_arena_alloc(len), str, len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_arena_dsprintf                                        *
+ *                                                                            *
+ * Purpose: formatted string in the arena                                     *
  *                                                                            *
  ******************************************************************************/
-int     zbx_docker_api_detect()
+char    *zbx_docker_arena_dsprintf(const char *fmt, ...)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_api_detect()");
-        // test root or docker permission
-        if (geteuid() != 0 && zbx_docker_perm() != 1 )
-        {
-            zabbix_log(LOG_LEVEL_DEBUG, "Additional permission of Zabbix Agent are not detected - only basic docker metrics are available");
-            socket_api = 0;
-            return socket_api;
-        } else {
-            // test Docker's socket connection
-            const char *echo = zbx_module_docker_socket_query("GET /_ping HTTP/1.0\r\n\n", 0);
-            if (strcmp(echo, "OK") == 0)
-            {
-                zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket works - extended docker metrics are available");
-                socket_api = 1;
-                return socket_api;
-            } else {
-                zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket doesn't work - only basic docker metrics are available");
-                socket_api = 0;
-                return socket_api;
-            }
-            free((void*) echo);
-        }
+        va_list args;
+        char    *str;
+        int     len;
+
+        va_start(args, fmt);
+        len = vsnprintf(NULL, 0, fmt, args);
+        va_end(args);
+
+        str = zbx_docker_arena_alloc((size_t)len + 1);
+        va_start(args, fmt);
+        vsnprintf(str, (size_t)len + 1, fmt, args);
+        va_end(args);
+
+        return str;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_inspect_exec                                   *
- *                                                                            *
- * Purpose: container inspection                                              *
+ * Function: zbx_docker_arena_reset                                           *
  *                                                                            *
- * Return value: inspect_result structure                                     *
+ * Purpose: release all transient memory of the item call                     *
  *                                                                            *
+ * Notes: blocks of a call which did not fit into one block are merged, so    *
+ *        the next call of the same size does not allocate at all; one large  *
+ *        call (e.g. huge docker.info) does not keep more than                *
+ *        ZBX_DOCKER_ARENA_MAX, the arena shrinks to the default size then    *
  ******************************************************************************/
-struct inspect_result     zbx_module_docker_inspect_exec(const char *container, const char *param1, const char *param2, const char *param3)
+void    zbx_docker_arena_reset()
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_inspect_exec()");
-        struct inspect_result iresult;
+        zbx_docker_arena_block_t        *block;
+        size_t                          total = 0;
+
+        if (NULL == arena)
+                return;
 
-        if (socket_api == 0 && zbx_docker_api_detect() == 0)
+        if (NULL == arena->next && ZBX_DOCKER_ARENA_MAX >= arena->size)
         {
-            zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not available");
-            iresult.value = zbx_strdup(NULL, "Docker's socket API is not available");
-            iresult.return_code = SYSINFO_RET_FAIL;
-            return iresult;
+                arena->used = 0;
+                return;
         }
 
-        if (container == NULL || param1 == NULL)
+        while (NULL != arena)
         {
-                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  (container != NULL) + (param1 != NULL));
-                iresult.value = zbx_strdup(NULL, "Invalid number of parameters");
-                iresult.return_code = SYSINFO_RET_FAIL;
-                return iresult;
+                block = arena;
+                arena = arena->next;
+                total += block->size;
+                free(block);
         }
-
-        char    *query;
-        // skip leading '/' in case of human name or short container id
-        if (container[0] == '/')
+        if (ZBX_DOCKER_ARENA_MAX < total)
+                total = ZBX_DOCKER_ARENA_SIZE;
+        if (NULL != (arena = malloc(sizeof(zbx_docker_arena_block_t) + total)))
         {
-            container++;
+                arena->next = NULL;
+                arena->size = total;
+                arena->used = 0;
         }
+}
 
-        size_t s_size = strlen("GET /containers/ /json HTTP/1.0\r\n\n") + strlen(container);
-        query = malloc(s_size);
-        zbx_strlcpy(query, "GET /containers/", s_size);
-        zbx_strlcat(query, container, s_size);
-        zbx_strlcat(query, "/json HTTP/1.0\r\n\n", s_size);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_time                                            *
+ *                                                                            *
+ * Purpose: monotonic time for latency measurement                            *
+ *                                                                            *
+ * Return value: time in microseconds                                         *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t    zbx_docker_stats_time()
+{
+        struct timespec ts;
 
-        const char *answer = zbx_module_docker_socket_query(query, 0);
-        free(query);
-        if(strcmp(answer, "") == 0)
-        {
-            zabbix_log(LOG_LEVEL_DEBUG, "docker.inspect is not available at the moment - some problem with Docker's socket API");
-            iresult.value = zbx_strdup(NULL, "docker.inspect is not available at the moment - some problem with Docker's socket API");
-            iresult.return_code = SYSINFO_RET_FAIL;
-            return iresult;
-        }
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (zbx_uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 
-        json_t *jp_data = json_loads(answer, 0, NULL);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_add                                             *
+ *                                                                            *
+ * Purpose: count one measured operation                                      *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_stats_add(zbx_docker_counter_t *counter, int error, zbx_uint64_t bytes, zbx_uint64_t latency_us)
+{
+        int     bucket;
 
-        if (param1 != NULL)
+        for (bucket = 0; bucket < ZBX_DOCKER_STATS_BUCKETS - 1; bucket++)
         {
-            // 1st level - plain value search
-            json_t *jp_data2 = json_object_get(jp_data, param1);
-            if (!json_is_string(jp_data2))
-            {
-                // 1st level - json object search
-                if (NULL == jp_data2)
-                {
-                    free((void*) answer);
-                    json_decref(jp_data);
-                    zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s] item in the received JSON object", param1);
-                    iresult.value = zbx_dsprintf(NULL, "Cannot find the [%s] item in the received JSON object", param1);
-                    iresult.return_code = SYSINFO_RET_FAIL;
-                    return iresult;
-                } else {
-                    // 2nd level
-                    zabbix_log(LOG_LEVEL_DEBUG, "Item [%s] found in the received JSON object", param1);
-                    if (param2 != NULL)
-                    {
-                        json_t *jp_data3 = json_object_get(jp_data2, param2);
-                        if (!json_is_string(jp_data3))
-                        {
-                            if (NULL == jp_data3)
-                            {
-                                free((void*) answer);
-                                json_decref(jp_data);
-                                zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s] item in the received JSON object", param1, param2);
-                                iresult.value = zbx_dsprintf(NULL, "Cannot find the [%s][%s] item in the received JSON object", param1, param2);
-                                iresult.return_code = SYSINFO_RET_FAIL;
-                                return iresult;
-                            } else {
-                                if (param3 == NULL)
-                                {
-                                    free((void*) answer);
-                                    char *values = json_dumps(jp_data3, 0);
-                                    zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s] found in the received JSON object: %s", param1, param2, values);
-                                    iresult.value = values;
-                                    iresult.return_code = SYSINFO_RET_OK;
-                                    return iresult;
-                                } else {
-                                    // find item in array - selector is param3
-                                    json_t *element;
-                                    size_t index;
-                                    json_array_foreach(jp_data3, index, element)
-   	                                {
-                                       if (json_is_string(element))
-                                       {
-                                           const char *value = json_string_value(element);
-                                           zabbix_log(LOG_LEVEL_DEBUG, "Array item: %s", value);
-
-                                           const char    *arg4 = param3;
-                                           char *tofree, *string, *selector;
-                                           tofree = string = strdup(arg4);
-
-                                           // hacking: Marathon MESOS_TASK_ID, Chronos - mesos_task_id
-                                           // docker.inspect[cid,Config,Env,MESOS_TASK_ID=|mesos_task_id=]
-                                           while ((selector = strsep(&string, "|")) != NULL) {
-                                               // if start of value match with array selector return without selector
-                                               if (strncmp(value, selector, strlen(selector)) == 0)
-                                               {
-                                                    // remove selector from returned value
-                                                    value += strlen(selector);
-
-                                                    zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s][%s] found in the received JSON object: %s", param1, param2, selector, value);
-                                                    iresult.value = zbx_strdup(NULL, value);
-                                                    iresult.return_code = SYSINFO_RET_OK;
-                                                    free((void*) answer);
-                                                    free((void*) tofree);
-                                                    return iresult;
-                                               }
-                                           }
-                                           free(tofree);
-                                       } else {
-                                           free((void*) answer);
-                                           zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s][%s] item in the received JSON object (non standard JSON array)", param1, param2, param3);
-                                           iresult.value = zbx_dsprintf(NULL, "Cannot find the [%s][%s][%s] item in the received JSON object (non standard JSON array)", param1, param2, param3);
-                                           iresult.return_code = SYSINFO_RET_FAIL;
-                                           return iresult;
-                                       }
-                                    }
-                                    free((void*) answer);
-                                    json_decref(jp_data);
-                                    zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s][%s] item in the received JSON object (selector - param3 doesn't match any value)", param1, param2, param3);
-                                    iresult.value = zbx_dsprintf(NULL, "Cannot find the [%s][%s][%s] item in the received JSON object (selector - param3 doesn't match any value)", param1, param2, param3);
-                                    iresult.return_code = SYSINFO_RET_FAIL;
-                                    return iresult;
-                                }
-                            }
-                        } else {
-                            // 3rd level
-                            zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s] found in the received JSON object", param1, param2);
-                            if (param3 != NULL)
-                            {
-                                json_t *jp_data4 = json_object_get(jp_data3, param3);
-                                if (!json_is_string(jp_data4))
-                                {
-                                    free((void*) answer);
-                                    zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s][%s] item in the received JSON object", param1, param2, param3);
-                                    iresult.value = zbx_dsprintf(NULL, "Cannot find the [%s][%s][%s] item in the received JSON object", param1, param2, param3);
-                                    iresult.return_code = SYSINFO_RET_FAIL;
-                                    return iresult;
-                                } else {
-                                    free((void*) answer);
-                                    const char *api_value3 = json_string_value(jp_data4);
-                                    zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s][%s] found in the received JSON object: %s", param1, param2, param3, api_value3);
-                                    iresult.value = zbx_strdup(NULL, api_value3);
-                                    iresult.return_code = SYSINFO_RET_OK;
-                                    json_decref(jp_data);
-                                    return iresult;
-                                }
-                            } else {
-                                free((void*) answer);
-                                const char *api_value2 = json_string_value(jp_data3);
-                                zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s] found in the received JSON object: %s", param1, param2, api_value2);
-                                iresult.value = zbx_strdup(NULL, api_value2);
-                                iresult.return_code = SYSINFO_RET_OK;
-                                json_decref(jp_data);
-                                return iresult;
-                            }
-                        }
-                    } else {
-                        free((void*) answer);
-                        json_decref(jp_data);
-                        zabbix_log(LOG_LEVEL_WARNING, "Item [%s] found in the received JSON object, but it's not plain value object", param1);
-                        iresult.value = zbx_dsprintf(NULL, "Can find the [%s] item in the received JSON object, but it's not plain value object", param1);
-                        iresult.return_code = SYSINFO_RET_FAIL;
-                        return iresult;
-                    }
-                }
-            } else {
-                free((void*) answer);
-                const char *api_value = json_string_value(jp_data2);
-                zabbix_log(LOG_LEVEL_DEBUG, "Item [%s] found in the received JSON object: %s", param1, api_value);
-                iresult.value = zbx_strdup(NULL, api_value);
-                iresult.return_code = SYSINFO_RET_OK;
-                json_decref(jp_data);
-                return iresult;
-            }
+            if (latency_us < (zbx_uint64_t)stats_bucket_ms[bucket] * 1000)
+                break;
         }
-        free((void*) answer);
-        json_decref(jp_data);
-        iresult.value = zbx_strdup(NULL, "");
-        iresult.return_code = SYSINFO_RET_OK;
-        return iresult;
+        __atomic_fetch_add(&counter->count, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counter->errors, 0 != error, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counter->bytes, bytes, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counter->latency_us, latency_us, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counter->histogram[bucket], 1, __ATOMIC_RELAXED);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function:  zbx_module_docker_port_discovery                                *
- *                                                                            *
- * Purpose: published container port discovery                                *
+ * Function: zbx_docker_stats_cache                                           *
  *                                                                            *
- * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
- *                                 as not supported by zabbix                 *
- *               SYSINFO_RET_OK - success                                     *
+ * Purpose: count cache hit or miss                                           *
  *                                                                            *
  ******************************************************************************/
-int zbx_module_docker_port_discovery(AGENT_REQUEST * request, AGENT_RESULT * result) {
-  zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_discover_ports()");
+void    zbx_docker_stats_cache(int cache, int hit)
+{
+        zbx_docker_stats_t      *slot;
 
-  if (2 < request->nparam || 0 == request->nparam) {
-    zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d", request->nparam);
-    SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters"));
-    return SYSINFO_RET_FAIL;
-  }
+        if (NULL == (slot = zbx_docker_stats_get_slot()))
+            return;
 
-  char * container;
-  container = get_rparam(request, 0);
+        __atomic_fetch_add(0 != hit ? &slot->cache_hits[cache] : &slot->cache_misses[cache], 1, __ATOMIC_RELAXED);
+}
 
-  struct inspect_result iresult;
-  iresult = zbx_module_docker_inspect_exec(container, "HostConfig", "PortBindings", NULL);
-  if (iresult.return_code == SYSINFO_RET_FAIL) {
-    zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec FAIL: %s", iresult.value);
-    free(iresult.value);
-    return SYSINFO_RET_FAIL;
-  }
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_endpoint                                        *
+ *                                                                            *
+ * Purpose: classify Docker API query by endpoint                             *
+ *                                                                            *
+ * Return value: endpoint index                                               *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_stats_endpoint(const char *query)
+{
+        const char      *path = strchr(query, ' '), *end;
+        size_t          len;
+
+        if (NULL == path)
+            return ZBX_DOCKER_ENDPOINT_OTHER;
+        path++;
+        len = strcspn(path, "? ");
+
+        if (0 == strncmp(path, "/_ping", len) && len == strlen("/_ping"))
+            return ZBX_DOCKER_ENDPOINT_PING;
+        if (0 == strncmp(path, "/info", len) && len == strlen("/info"))
+            return ZBX_DOCKER_ENDPOINT_INFO;
+        if (0 == strncmp(path, "/images/json", len) && len == strlen("/images/json"))
+            return ZBX_DOCKER_ENDPOINT_IMAGES;
+        if (0 == strncmp(path, "/volumes", len) && len == strlen("/volumes"))
+            return ZBX_DOCKER_ENDPOINT_VOLUMES;
+        if (0 != strncmp(path, "/containers/", strlen("/containers/")))
+            return ZBX_DOCKER_ENDPOINT_OTHER;
+        if (0 == strncmp(path, "/containers/json", len) && len == strlen("/containers/json"))
+            return ZBX_DOCKER_ENDPOINT_CONTAINERS;
+        for (end = path + len; end > path && '/' != *(end - 1); end--)
+            ;
+        if (0 == strncmp(end, "json", path + len - end) && path + len - end == 4)
+            return ZBX_DOCKER_ENDPOINT_INSPECT;
+        if (0 == strncmp(end, "stats", path + len - end) && path + len - end == 5)
+            return ZBX_DOCKER_ENDPOINT_STATS;
+        return ZBX_DOCKER_ENDPOINT_OTHER;
+}
 
-  // now parse the value we get back from zbx_module_docker_inspect_exec()
-  json_t *jp_data = json_loads(iresult.value, 0, NULL);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_socket                                          *
+ *                                                                            *
+ * Purpose: count one Docker API round-trip and record it in the trace ring   *
+ *                                                                            *
+ * Parameters: query - HTTP request, only request line is recorded            *
+ *             status - HTTP status code, 0 if there is no HTTP response      *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_stats_socket(const char *query, int endpoint, int error, int status, zbx_uint64_t bytes,
+                zbx_uint64_t start)
+{
+        zbx_docker_stats_t      *slot;
+        zbx_docker_trace_t      *entry;
+        zbx_uint64_t            latency_us = zbx_docker_stats_time() - start, seq;
 
-  char container_port[6];
-  int port_len;
-  const char
-    *proto = NULL,
-    *request_proto = NULL;
+        if (NULL != (slot = zbx_docker_stats_get_slot()))
+        {
+            zbx_docker_stats_add(&slot->endpoints[endpoint], error, bytes, latency_us);
+        }
 
-  json_t *a = json_array();
+        if (NULL == trace)
+            return;
+
+        // seqlock: entry seq is 0 while entry is being written
+        seq = __atomic_add_fetch(&trace->next, 1, __ATOMIC_RELAXED);
+        entry = &trace->entries[(seq - 1) % ZBX_DOCKER_TRACE_SIZE];
+        __atomic_store_n(&entry->seq, 0, __ATOMIC_RELAXED);
+        // entry data must not be stored before the seq reset
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        entry->clock = time(NULL);
+        entry->pid = getpid();
+        entry->status = status;
+        entry->error = error;
+        entry->bytes = bytes;
+        entry->latency_us = latency_us;
+        zbx_strlcpy(entry->request, query, MIN(sizeof(entry->request), strcspn(query, "\r\n") + 1));
+        __atomic_store_n(&entry->seq, seq, __ATOMIC_RELEASE);
+}
 
-  if (1 < request->nparam) {
-    request_proto = get_rparam(request, 1);
-  }
-  const char *buf;
-  json_t *p;
-  json_object_foreach(jp_data, buf, p) {
-    // Split "12345/tcp" specifier
-    proto = strstr(buf, "/") + 1;
-    port_len = proto - buf;
-    zbx_strlcpy(container_port, buf, port_len);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_item                                            *
+ *                                                                            *
+ * Purpose: measure call of item key function and release its transient      *
+ *          memory (arena)                                                    *
+ *                                                                            *
+ * Return value: return value of item key function                            *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_stats_item(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        int                     i, ret;
+        zbx_uint64_t            start;
+        zbx_docker_stats_t      *slot;
 
-    if (NULL != request_proto && '\0' != *request_proto && 0 != strcmp(request_proto, proto)) {
-      continue;
-    }
+        for (i = 0; NULL != keys[i].key && 0 != strcmp(keys[i].key, request->key); i++)
+            ;
+        if (NULL == keys[i].key)
+        {
+            SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported item key: %s", request->key));
+            return SYSINFO_RET_FAIL;
+        }
 
-    // Open list of HostIP/HostPort dicts
-    json_t *jp_obj = json_array_get(p, 0);
-    if (NULL == jp_obj) {
-      //zabbix_log(LOG_LEVEL_DEBUG, "zbx_json_brackets_open FAIL: %s", zbx_json_strerror());
-      continue;
-    }
+        start = zbx_docker_stats_time();
+        ret = keys[i].function(request, result);
+        zbx_docker_arena_reset();
 
-    // Lookup HostPort value
-    const char *host_port = json_string_value(json_object_get(jp_obj, "HostPort"));
-    if (NULL == host_port) {
-      //zabbix_log(LOG_LEVEL_DEBUG, "zbx_json_value_by_name FAIL: %s", zbx_json_strerror());
-      continue;
-    }
+        if (NULL != (slot = zbx_docker_stats_get_slot()) && i < ZBX_DOCKER_STATS_KEYS)
+        {
+            zbx_docker_stats_add(&slot->keys[i], SYSINFO_RET_OK != ret, 0, zbx_docker_stats_time() - start);
+        }
+        return ret;
+}
 
-    json_t *o = json_object();
-    json_object_set_new(o, "{#HOSTPORT}", json_string(host_port));
-    json_object_set_new(o, "{#CONTAINERPORT}", json_string(container_port));
-    json_object_set_new(o, "{#PROTO}", json_string(proto));
-    json_array_append_new(a, o);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_rate_init                                             *
+ *                                                                            *
+ * Purpose: allocate samples of rate keys                                     *
+ *                                                                            *
+ * Notes: samples are in shared memory, so the rate is correct regardless of  *
+ *        which agent process serves the item                                 *
+ ******************************************************************************/
+void    zbx_docker_rate_init()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_rate_init()");
+        pthread_mutexattr_t     attr;
+        int                     i;
 
-  }
-  json_t *j = json_object();
-  json_object_set_new(j, "data", a);
-  SET_STR_RESULT(result, json_dumps(j, 0));
-  json_decref(j);
+        rates = mmap(NULL, sizeof(zbx_docker_rate_t) * ZBX_DOCKER_RATE_SIZE, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == rates)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot allocate shared memory for rate samples: %s", zbx_strerror(errno));
+            rates = NULL;
+            return;
+        }
 
-  return SYSINFO_RET_OK;
+        // lock of a sample must be released when the agent process holding it dies
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        for (i = 0; i < ZBX_DOCKER_RATE_SIZE; i++)
+                pthread_mutex_init(&rates[i].lock, &attr);
+        pthread_mutexattr_destroy(&attr);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_get_fci                                        *
+ * Function: zbx_docker_rate_hash                                             *
  *                                                                            *
- * Purpose: get full container ID, if container name is specified             *
+ * Purpose: 64-bit FNV-1a hash of item key with parameters                    *
  *                                                                            *
- * Return value: empty string - function failed                               *
- *               string - full container ID                                   *
  ******************************************************************************/
-char*  zbx_module_docker_get_fci(char *fci)
+zbx_uint64_t    zbx_docker_rate_hash(AGENT_REQUEST *request)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_get_fci()");
+        zbx_uint64_t    hash = __UINT64_C(0xcbf29ce484222325);
+        const char      *p;
+        int             i;
 
-        // if first character is '/', then detect fci
-        if (fci[0] != '/')
+        for (i = -1; i < request->nparam; i++)
         {
-            zabbix_log(LOG_LEVEL_DEBUG, "Original full container id will be used");
-            return zbx_strdup(NULL, fci);
+                for (p = -1 == i ? request->key : get_rparam(request, i); NULL != p && '\0' != *p; p++)
+                        hash = (hash ^ (unsigned char)*p) * __UINT64_C(0x100000001b3);
+                // parameter separator
+                hash = (hash ^ 0xff) * __UINT64_C(0x100000001b3);
         }
 
-        // Docker API query - docker.inspect[fci,Id]
-        zabbix_log(LOG_LEVEL_DEBUG, "Translating container name to fci by using docker.inspect");
-        // TODO dynamic iresult
-        struct inspect_result iresult;
-        iresult = zbx_module_docker_inspect_exec(fci, "Id", NULL, NULL);
-        if (iresult.return_code == SYSINFO_RET_OK) {
-            zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec OK: %s", iresult.value);
-            return iresult.value;
-        } else {
-            zabbix_log(LOG_LEVEL_DEBUG, "Default fci will be used, because zbx_module_docker_inspect_exec FAIL: %s", iresult.value);
-            free(iresult.value);
-            return zbx_strdup(NULL, fci);
-        }
+        return 0 == hash ? 1 : hash;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_docker_dir_detect                                            *
+ * Function: zbx_docker_rate_get                                              *
  *                                                                            *
- * Purpose: it should find metric folder - it depends on docker version       *
- *            or execution environment                                        *
+ * Purpose: find and lock sample of the item, free or expired sample is       *
+ *          taken for new item                                                *
  *                                                                            *
- * Return value: SYSINFO_RET_FAIL - stat folder was not found                 *
- *               SYSINFO_RET_OK - stat folder was found                       *
+ * Return value: locked sample, NULL - all probed samples are used            *
  *                                                                            *
  ******************************************************************************/
-int     zbx_docker_dir_detect()
+zbx_docker_rate_t       *zbx_docker_rate_get(zbx_uint64_t hash, zbx_uint64_t now)
 {
-        // TODO logic should be changed for all lxc/docker/systemd container support
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_dir_detect()");
-
-        char *drivers[] = {
-            "docker/",        // Non-systemd Docker: docker -d -e native
-            "system.slice/",  // Systemd Docker
-            "lxc/",           // Non-systemd LXC: docker -d -e lxc
-            "libvirt/lxc/",   // Legacy libvirt-lxc
-            // TODO pos = cgroup.find("-lxc\\x2");     // Systemd libvirt-lxc
-            // TODO pos = cgroup.find(".libvirt-lxc"); // Non-systemd libvirt-lxc
-            NULL
-        }, **tdriver;
-        char path[512];
-        const char *mounts_regex = "^[^[:blank:]]+[[:blank:]]+(/[^[:blank:]]+/)[^[:blank:]]+[[:blank:]]+cgroup[[:blank:]]+.*$";
-        FILE *fp;
-        DIR  *dir;
-
-        if ((fp = fopen("/proc/mounts", "r")) == NULL)
-        {
-            zabbix_log(LOG_LEVEL_WARNING, "Cannot open /proc/mounts: %s", zbx_strerror(errno));
-            return SYSINFO_RET_FAIL;
-        }
+        zbx_docker_rate_t       *sample;
+        int                     i, err;
 
-        while (fgets(path, 512, fp) != NULL)
+        for (i = 0; i < ZBX_DOCKER_RATE_PROBES; i++)
         {
-            if ((strstr(path, "cpuset cgroup")) != NULL)
-            {
-                if (SUCCEED != zbx_regexp_sub(path, mounts_regex, "\\1", &stat_dir) || NULL == stat_dir)
+                sample = &rates[(hash + i) & (ZBX_DOCKER_RATE_SIZE - 1)];
+                if (0 != (err = pthread_mutex_lock(&sample->lock)))
                 {
-                    continue;
+                        if (EOWNERDEAD != err)
+                                continue;
+                        // the owner died while updating the sample, so the previous value is not trusted
+                        zabbix_log(LOG_LEVEL_DEBUG, "Recovered rate sample lock of dead process");
+                        pthread_mutex_consistent(&sample->lock);
+                        sample->time_us = 0;
                 }
-                zabbix_log(LOG_LEVEL_DEBUG, "Detected docker stat directory: %s", stat_dir);
 
-                pclose(fp);
+                if (hash == sample->hash)
+                        return sample;
 
-                char *cgroup = "cpuset/";
-                tdriver = drivers;
-                size_t  ddir_size;
-                char    *ddir;
-                while (*tdriver != NULL)
-                {
-                    ddir_size = strlen(cgroup) + strlen(stat_dir) + strlen(*tdriver) + 1;
-                    ddir = malloc(ddir_size);
-                    zbx_strlcpy(ddir, stat_dir, ddir_size);
-                    zbx_strlcat(ddir, cgroup, ddir_size);
-                    zbx_strlcat(ddir, *tdriver, ddir_size);
-                    if (NULL != (dir = opendir(ddir)))
-                    {
-                        closedir(dir);
-                        free(ddir);
-                        driver = *tdriver;
-                        zabbix_log(LOG_LEVEL_DEBUG, "Detected used docker driver dir: %s", driver);
-                        // systemd docker
-                        if (strcmp(driver, "system.slice/") == 0)
-                        {
-                            zabbix_log(LOG_LEVEL_DEBUG, "Detected systemd docker - prefix/suffix will be used");
-                            c_prefix = "docker-";
-                            c_suffix = ".scope";
-                        }
-                        // detect cpu_cgroup - JoinController cpu,cpuacct
-                        cgroup = "cpu,cpuacct/";
-                        ddir_size = strlen(cgroup) + strlen(stat_dir) + 1;
-                        ddir = malloc(ddir_size);
-                        zbx_strlcpy(ddir, stat_dir, ddir_size);
-                        zbx_strlcat(ddir, cgroup, ddir_size);
-                        if (NULL != (dir = opendir(ddir)))
-                        {
-                            closedir(dir);
-                            cpu_cgroup = "cpu,cpuacct/";
-                            zabbix_log(LOG_LEVEL_DEBUG, "Detected JoinController cpu,cpuacct");
-                        } else {
-                            cpu_cgroup = "cpuacct/";
-                        }
-                        free(ddir);
-                        return SYSINFO_RET_OK;
-                    }
-                    tdriver++;
-                    free(ddir);
+                if (0 == sample->hash || now - sample->time_us > (zbx_uint64_t)ZBX_DOCKER_RATE_EXPIRE * 1000000)
+                {
+                        sample->hash = hash;
+                        sample->time_us = 0;
+                        return sample;
                 }
-                driver = "";
-                zabbix_log(LOG_LEVEL_DEBUG, "Cannot detect used docker driver");
-                return SYSINFO_RET_FAIL;
-            }
+                pthread_mutex_unlock(&sample->lock);
         }
-        pclose(fp);
-        zabbix_log(LOG_LEVEL_DEBUG, "Cannot detect docker stat directory");
-        return SYSINFO_RET_FAIL;
+
+        return NULL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_up                                             *
+ * Function: zbx_docker_rate_sample                                           *
  *                                                                            *
- * Purpose: check if container is running                                     *
+ * Purpose: store new sample of cumulative counter and calculate per second   *
+ *          rate since the previous sample                                    *
  *                                                                            *
- * Return value: 1 - is running, 0 - is not running                           *
+ * Parameters: hash - counter identification, see zbx_docker_rate_hash()     *
+ *             value - current counter value                                  *
+ *             rate - per second rate                                         *
+ *             result - item result, message is set on failure unless set     *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - no free sample or the first sample        *
+ *               SYSINFO_RET_OK - success                                     *
  *                                                                            *
+ * Notes: the first sample (also after the sample was taken by another item)  *
+ *        is only stored, as by "Change per second" preprocessing of Zabbix;  *
+ *        lower value than the previous one means counter reset (e.g.         *
+ *        container restart), so the counter is expected to start from 0      *
+ *        within the interval                                                 *
  ******************************************************************************/
-int     zbx_module_docker_up(AGENT_REQUEST *request, AGENT_RESULT *result)
+int     zbx_docker_rate_sample(zbx_uint64_t hash, zbx_uint64_t value, double *rate, AGENT_RESULT *result)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_up()");
-        char    *container;
-
-        if (1 != request->nparam)
-        {
-                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
-                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
-                return SYSINFO_RET_FAIL;
-        }
+        zbx_docker_rate_t       *sample;
+        zbx_uint64_t            now = zbx_docker_stats_time();
+        int                     ret = SYSINFO_RET_OK;
 
-        if (stat_dir == NULL || driver == NULL)
+        if (NULL == rates || NULL == (sample = zbx_docker_rate_get(hash, now)))
         {
-                zabbix_log(LOG_LEVEL_DEBUG, "docker.up check is not available at the moment - no stat directory");
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.up check is not available at the moment - no stat directory"));
+                if (!ISSET_MSG(result))
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "Rate samples are not available - shared memory is full or missing"));
                 return SYSINFO_RET_FAIL;
         }
 
-        if(cpu_cgroup == NULL)
+        if (0 == sample->time_us)
         {
-                if (zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
-                {
-                    zabbix_log(LOG_LEVEL_DEBUG, "docker.up check is not available at the moment - no cpu_cgroup directory");
-                    SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.up check is not available at the moment - no cpu_cgroup directory"));
-                    return SYSINFO_RET_FAIL;
-                }
-        }
-
-        container = zbx_module_docker_get_fci(get_rparam(request, 0));
-        char    *stat_file = "/cpuacct.stat";
-        char    *cgroup = cpu_cgroup;
-        size_t  filename_size = strlen(cgroup) + strlen(container) + strlen(stat_dir) + strlen(driver) + strlen(stat_file) + 2;
-        if (strstr(container, ".") == NULL) {
-            if (c_prefix != NULL)
-            {
-                filename_size += strlen(c_prefix);
-            }
-            if (c_suffix != NULL)
-            {
-                filename_size += strlen(c_suffix);
-            }
+                ret = SYSINFO_RET_FAIL;
         }
-        char    *filename = malloc(filename_size);
-        zbx_strlcpy(filename, stat_dir, filename_size);
-        zbx_strlcat(filename, cgroup, filename_size);
-        zbx_strlcat(filename, driver, filename_size);
-        if (strstr(container, ".") == NULL && c_prefix != NULL)
+        else if (now - sample->time_us < ZBX_DOCKER_RATE_MIN_INTERVAL)
         {
-            zbx_strlcat(filename, c_prefix, filename_size);
+                // sample is not updated, so the next rate covers a longer interval, no rate after the first sample
+                *rate = sample->rate;
+                pthread_mutex_unlock(&sample->lock);
+                if (0 <= *rate)
+                        return SYSINFO_RET_OK;
+                if (!ISSET_MSG(result))
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "Rate is not available yet, the first sample is stored"));
+                return SYSINFO_RET_FAIL;
         }
-        zbx_strlcat(filename, container, filename_size);
-        if (strstr(container, ".") == NULL && c_suffix != NULL)
+        else if (value >= sample->value)
         {
-            zbx_strlcat(filename, c_suffix, filename_size);
+                *rate = (double)(value - sample->value) * 1000000 / (now - sample->time_us);
         }
-        free(container);
-        zbx_strlcat(filename, stat_file, filename_size);
-        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
-        FILE    *file;
-        if (NULL == (file = fopen(filename, "r")))
+        else
         {
-                zabbix_log(LOG_LEVEL_DEBUG, "Cannot open metric file: '%s', container doesn't run", filename);
-                free(filename);
-                SET_UI64_RESULT(result, 0);
-                return SYSINFO_RET_OK;
+                zabbix_log(LOG_LEVEL_DEBUG, "Counter reset: " ZBX_FS_UI64 " -> " ZBX_FS_UI64, sample->value, value);
+                *rate = (double)value * 1000000 / (now - sample->time_us);
         }
-        zbx_fclose(file);
-        zabbix_log(LOG_LEVEL_DEBUG, "Can open metric file: '%s', container is running", filename);
-        free(filename);
-        SET_UI64_RESULT(result, 1);
-        return SYSINFO_RET_OK;
+        sample->value = value;
+        sample->time_us = now;
+        sample->rate = SYSINFO_RET_OK == ret ? *rate : -1;
+        pthread_mutex_unlock(&sample->lock);
+
+        if (SYSINFO_RET_OK != ret && !ISSET_MSG(result))
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Rate is not available yet, the first sample is stored"));
+
+        return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_dev                                            *
+ * Function: zbx_docker_rate                                                  *
  *                                                                            *
- * Purpose: container device blkio metrics                                    *
+ * Purpose: per second rate of cumulative counter returned by item function   *
+ *                                                                            *
+ * Parameters: request - rate item request, parameters are passed to function *
+ *             result - rate result                                           *
+ *             function - item function of cumulative counter                 *
  *                                                                            *
  * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
  *                                 as not supported by zabbix                 *
  *               SYSINFO_RET_OK - success                                     *
  *                                                                            *
- * Notes: https://www.kernel.org/doc/Documentation/cgroups/blkio-controller.txt
  ******************************************************************************/
-int     zbx_module_docker_dev(AGENT_REQUEST *request, AGENT_RESULT *result)
+int     zbx_docker_rate(AGENT_REQUEST *request, AGENT_RESULT *result, int (*function)(AGENT_REQUEST *, AGENT_RESULT *))
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_dev()");
-        char    *container, *metric;
-        int     ret = SYSINFO_RET_FAIL;
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_rate()");
+        AGENT_RESULT    counter;
+        double          rate;           // -1 - only the first sample is stored
 
-        if (3 != request->nparam)
+        memset(&counter, 0, sizeof(counter));
+        if (SYSINFO_RET_OK != function(request, &counter))
         {
-                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
-                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                SET_MSG_RESULT(result, ISSET_MSG(&counter) ? counter.msg : zbx_strdup(NULL, "Cannot obtain counter value"));
                 return SYSINFO_RET_FAIL;
         }
-
-        if (stat_dir == NULL || driver == NULL)
+        if (!ISSET_UI64(&counter))
         {
-                zabbix_log(LOG_LEVEL_DEBUG, "docker.dev metrics are not available at the moment - no stat directory");
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.dev metrics are not available at the moment - no stat directory"));
+                free(counter.msg);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Counter value is not unsigned integer"));
                 return SYSINFO_RET_FAIL;
         }
 
-        container = zbx_module_docker_get_fci(get_rparam(request, 0));
-        char    *arg2 = get_rparam(request, 1);
-        char    *stat_file = malloc(strlen(arg2) + 2);
-        zbx_strlcpy(stat_file, "/", strlen(arg2) + 2);
-        zbx_strlcat(stat_file, get_rparam(request, 1), strlen(arg2) + 2);
-        metric = get_rparam(request, 2);
-
-        char    *cgroup = "blkio/";
-        size_t  filename_size = strlen(cgroup) + strlen(container) + strlen(stat_dir) + strlen(driver) + strlen(stat_file) + 2;
-        if (strstr(container, ".") == NULL) {
-            if (c_prefix != NULL)
-            {
-                filename_size += strlen(c_prefix);
-            }
-            if (c_suffix != NULL)
-            {
-                filename_size += strlen(c_suffix);
-            }
-        }
-        char    *filename = malloc(filename_size);
-        zbx_strlcpy(filename, stat_dir, filename_size);
-        zbx_strlcat(filename, cgroup, filename_size);
-        zbx_strlcat(filename, driver, filename_size);
-        if (strstr(container, ".") == NULL && c_prefix != NULL)
-        {
-            zbx_strlcat(filename, c_prefix, filename_size);
-        }
-        zbx_strlcat(filename, container, filename_size);
-        if (strstr(container, ".") == NULL && c_suffix != NULL)
-        {
-            zbx_strlcat(filename, c_suffix, filename_size);
-        }
-        zbx_strlcat(filename, stat_file, filename_size);
-        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
-        FILE    *file;
-        if (NULL == (file = fopen(filename, "r")))
-        {
-                zabbix_log(LOG_LEVEL_ERR, "Cannot open metric file: '%s'", filename);
-                free(container);
-                free(stat_file);
-                free(filename);
-                SET_MSG_RESULT(result, strdup("Cannot open stat file, maybe CONFIG_DEBUG_BLK_CGROUP is not enabled"));
+        if (SYSINFO_RET_OK != zbx_docker_rate_sample(zbx_docker_rate_hash(request), counter.ui64, &rate, result))
                 return SYSINFO_RET_FAIL;
-        }
 
-        char    line[MAX_STRING_LEN];
-        char    *metric2 = malloc(strlen(metric)+3);
-        memcpy(metric2, metric, strlen(metric));
-        memcpy(metric2 + strlen(metric), " ", 2);
-        zbx_uint64_t    value = 0;
-        zabbix_log(LOG_LEVEL_DEBUG, "Looking metric %s in blkio file", metric);
-        while (NULL != fgets(line, sizeof(line), file))
-        {
-                if (0 != strncmp(line, metric2, strlen(metric2)))
-                        continue;
-                if (1 != sscanf(line, "%*s " ZBX_FS_UI64, &value))
-                {
-                     // maybe per blk device metric, e.g. '8:0 Read'
-                     if (1 != sscanf(line, "%*s %*s " ZBX_FS_UI64, &value))
-                     {
-                         zabbix_log(LOG_LEVEL_ERR, "sscanf failed for matched metric line");
-                         break;
-                     }
-                }
-                zabbix_log(LOG_LEVEL_DEBUG, "Id: %s; stat file: %s, metric: %s; value: %lu", container, stat_file, metric, value);
-                SET_UI64_RESULT(result, value);
-                ret = SYSINFO_RET_OK;
-                break;
-        }
-        zbx_fclose(file);
+        SET_DBL_RESULT(result, rate);
+        return SYSINFO_RET_OK;
+}
 
-        free(container);
-        free(stat_file);
-        free(filename);
-        free(metric2);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_cpu_rate                                       *
+ *                                                                            *
+ * Purpose: per second rate of docker.cpu counter                             *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_cpu_rate(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        return zbx_docker_rate(request, result, zbx_module_docker_cpu);
+}
 
-        if (SYSINFO_RET_FAIL == ret)
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find a line with requested metric in blkio file"));
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_mem_rate                                       *
+ *                                                                            *
+ * Purpose: per second rate of docker.mem counter, e.g. pgfault               *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_mem_rate(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        return zbx_docker_rate(request, result, zbx_module_docker_mem);
+}
 
-        return ret;
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_dev_rate                                       *
+ *                                                                            *
+ * Purpose: per second rate of docker.dev counter                             *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_dev_rate(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        return zbx_docker_rate(request, result, zbx_module_docker_dev);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_mem                                            *
+ * Function: zbx_module_docker_net_rate                                       *
  *                                                                            *
- * Purpose: container memory metrics                                          *
+ * Purpose: per second rate of docker.xnet counter                            *
  *                                                                            *
- * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
- *                                 as not supported by zabbix                 *
- *               SYSINFO_RET_OK - success                                     *
+ ******************************************************************************/
+int     zbx_module_docker_net_rate(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        return zbx_docker_rate(request, result, zbx_module_docker_net);
+}
+
+/******************************************************************************
  *                                                                            *
- * Notes: https://www.kernel.org/doc/Documentation/cgroups/memory.txt         *
+ * Function: zbx_docker_socket_read                                           *
+ *                                                                            *
+ * Purpose: querying details via Docker socket API (permission is needed)      *
+ *                                                                            *
+ * Return value: NULL - function failed                                       *
+ *               string - response body, it must be freed by caller           *
+ *                                                                            *
+ * Notes: the arena is not used, so background threads can query the API     *
+ *        https://docs.docker.com/reference/api/docker_remote_api/            *
+ *        echo -e "GET /containers/json?all=1 HTTP/1.0\r\n" | \               *
+ *        nc -U /var/run/docker.sock                                          *
+ *        socket path can be changed by DOCKER_HOST=unix:///path/docker.sock  *
  ******************************************************************************/
-int     zbx_module_docker_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
+char    *zbx_docker_socket_read(char *query, int stream)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_mem()");
-        char    *container, *metric;
-        int     ret = SYSINFO_RET_FAIL;
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_socket_read()");
 
-        if (2 != request->nparam)
+        struct sockaddr_un address;
+        int sock, nbytes;
+        size_t addr_length;
+        char buffer[buffer_size+1];
+        char *response_substr, *message = NULL, *temp1, *temp2;
+        zbx_uint64_t start = zbx_docker_stats_time(), bytes = 0, message_alloc;
+        int endpoint = zbx_docker_stats_endpoint(query), status;
+        if ((sock = socket(PF_UNIX, SOCK_STREAM, 0)) < 0)
         {
-                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
-                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
-                return SYSINFO_RET_FAIL;
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot create socket for docker's communication");
+            zbx_docker_stats_socket(query, endpoint, 1, 0, bytes, start);
+            return NULL;
         }
-
-        if (stat_dir == NULL || driver == NULL)
+        address.sun_family = AF_UNIX;
+        zbx_strlcpy(address.sun_path, docker_socket, sizeof(address.sun_path));
+        addr_length = sizeof(address.sun_family) + strlen(address.sun_path);
+        if (connect(sock, (struct sockaddr *) &address, addr_length))
         {
-                zabbix_log(LOG_LEVEL_DEBUG, "docker.mem metrics are not available at the moment - no stat directory");
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.mem metrics are not available at the moment - no stat directory"));
-                return SYSINFO_RET_FAIL;
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot connect to docker's socket %s: %s", docker_socket, zbx_strerror(errno));
+            close(sock);
+            zbx_docker_stats_socket(query, endpoint, 1, 0, bytes, start);
+            return NULL;
         }
 
-        container = zbx_module_docker_get_fci(get_rparam(request, 0));
-        metric = get_rparam(request, 1);
-        char    *stat_file = "/memory.stat";
-        char    *cgroup = "memory/";
-        size_t  filename_size = strlen(cgroup) + strlen(container) + strlen(stat_dir) + strlen(driver) + strlen(stat_file) + 2;
+        // socket input/output timeout
+        if (setsockopt (sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&stimeout, sizeof(stimeout)) < 0)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot set SO_RCVTIMEO socket timeout: %ld seconds", stimeout.tv_sec);
+        }
+        if (setsockopt (sock, SOL_SOCKET, SO_SNDTIMEO, (char *)&stimeout, sizeof(stimeout)) < 0)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot set SO_SNDTIMEO socket timeout: %ld seconds", stimeout.tv_sec);
+        }
 
-        if (strstr(container, ".") == NULL) {
-            if (c_prefix != NULL)
+        // copies without line breaks are made only for debug log
+        if (ZBX_DOCKER_DEBUG())
+        {
+            temp1 = string_replace(query, "\n", "");
+            temp2 = string_replace(temp1, "\r", "");
+            free(temp1);
+            zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket query: %s", temp2);
+            free(temp2);
+        }
+        write(sock, query, strlen(query));
+        message_alloc = 4 * buffer_size;
+        message = realloc(NULL, message_alloc);
+        if (message == NULL)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Problem with allocating memory for Docker answer");
+            close(sock);
+            zbx_docker_stats_socket(query, endpoint, 1, 0, bytes, start);
+            return NULL;
+        }
+        *message = '\0';
+        while ((nbytes = read(sock, buffer, buffer_size)) > 0 )
+        {
+            buffer[nbytes] = 0;
+            // buffer grows geometrically, not per chunk
+            if (bytes + nbytes + 1 > message_alloc)
             {
-                filename_size += strlen(c_prefix);
+                while (bytes + nbytes + 1 > message_alloc)
+                    message_alloc *= 2;
+                if (NULL == (temp1 = realloc(message, message_alloc)))
+                {
+                    zabbix_log(LOG_LEVEL_WARNING, "Problem with allocating memory");
+                    free(message);
+                    close(sock);
+                    zbx_docker_stats_socket(query, endpoint, 1, 0, bytes, start);
+                    return NULL;
+                }
+                message = temp1;
             }
-            if (c_suffix != NULL)
+            memcpy(message + bytes, buffer, nbytes + 1);
+            bytes += nbytes;
+            // wait only for first chunk of (stats) stream
+            if (stream == 1)
             {
-                filename_size += strlen(c_suffix);
+                if ((strstr(message, "}\n")) != NULL)
+                {
+                    break;
+                }
             }
         }
-
-        char    *filename = malloc(filename_size);
-        zbx_strlcpy(filename, stat_dir, filename_size);
-        zbx_strlcat(filename, cgroup, filename_size);
-        zbx_strlcat(filename, driver, filename_size);
-        if (strstr(container, ".") == NULL && c_prefix != NULL)
-        {
-            zbx_strlcat(filename, c_prefix, filename_size);
-        }
-        zbx_strlcat(filename, container, filename_size);
-        if (strstr(container, ".") == NULL && c_suffix != NULL)
+        close(sock);
+        if (1 != sscanf(message, "HTTP/%*s %d", &status))
         {
-            zbx_strlcat(filename, c_suffix, filename_size);
+            status = 0;
         }
-        zbx_strlcat(filename, stat_file, filename_size);
-        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
-        FILE    *file;
-        if (NULL == (file = fopen(filename, "r")))
+        response_substr = strstr(message, "\r\n\r\n");
+        zbx_docker_stats_socket(query, endpoint, NULL == response_substr, status, bytes, start);
+        // remove http header
+        if (NULL != response_substr)
         {
-                zabbix_log(LOG_LEVEL_ERR, "Cannot open metric file: '%s'", filename);
-                free(container);
-                free(filename);
-                SET_MSG_RESULT(result, strdup("Cannot open memory.stat file"));
-                return SYSINFO_RET_FAIL;
+            response_substr += 4;
+            memmove(message, response_substr, strlen(response_substr) + 1);
+        } else {
+            message = zbx_strdup(message, "[{}]");
         }
 
-        char    line[MAX_STRING_LEN];
-        char    *metric2 = malloc(strlen(metric)+3);
-        memcpy(metric2, metric, strlen(metric));
-        memcpy(metric2 + strlen(metric), " ", 2);
-        zbx_uint64_t    value = 0;
-        zabbix_log(LOG_LEVEL_DEBUG, "Looking metric %s in memory.stat file", metric);
-        while (NULL != fgets(line, sizeof(line), file))
+        if (ZBX_DOCKER_DEBUG())
         {
-                if (0 != strncmp(line, metric2, strlen(metric2)))
-                        continue;
-                if (1 != sscanf(line, "%*s " ZBX_FS_UI64, &value))
-                {
-                        zabbix_log(LOG_LEVEL_ERR, "sscanf failed for matched metric line");
-                        continue;
-                }
-                zabbix_log(LOG_LEVEL_DEBUG, "Id: %s; metric: %s; value: %lu", container, metric, value);
-                SET_UI64_RESULT(result, value);
-                ret = SYSINFO_RET_OK;
-                break;
+            temp1 = string_replace(message, "\n", "");
+            temp2 = string_replace(temp1, "\r", "");
+            free(temp1);
+            zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket response: %s", temp2);
+            free(temp2);
         }
-        zbx_fclose(file);
-
-        free(container);
-        free(filename);
-        free(metric2);
-
-        if (SYSINFO_RET_FAIL == ret)
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find a line with requested metric in memory.stat file"));
-
-        return ret;
+        return message;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_cpu                                            *
+ * Function: zbx_module_docker_socket_query                                   *
  *                                                                            *
- * Purpose: container CPU metrics                                             *
+ * Purpose: querying details via Docker socket API (permission is needed)      *
  *                                                                            *
- * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
- *                                 as not supported by zabbix                 *
- *               SYSINFO_RET_OK - success                                     *
+ * Return value: empty string - function failed                               *
+ *               string - response from Docker's socket API in the arena,     *
+ *                        it's released after the item call                   *
  *                                                                            *
- * Notes: https://www.kernel.org/doc/Documentation/cgroups/cpuacct.txt        *
  ******************************************************************************/
-int     zbx_module_docker_cpu(AGENT_REQUEST *request, AGENT_RESULT *result)
+const char*  zbx_module_docker_socket_query(char *query, int stream)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_cpu()");
-
-        char    *container, *metric;
-        int     ret = SYSINFO_RET_FAIL;
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_socket_query()");
+        char    *message, *response;
 
-        if (2 != request->nparam)
+        if (NULL == (message = zbx_docker_socket_read(query, stream)))
         {
-                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
-                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
-                return SYSINFO_RET_FAIL;
+            return "";
         }
+        response = zbx_docker_arena_strdup(message);
+        free(message);
 
-        if (stat_dir == NULL || driver == NULL)
-        {
-                zabbix_log(LOG_LEVEL_DEBUG, "docker.cpu metrics are not available at the moment - no stat directory");
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.cpu metrics are not available at the moment - no stat directory"));
-                return SYSINFO_RET_FAIL;
-        }
+        return response;
+}
 
-        if(cpu_cgroup == NULL)
-        {
-                if (zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
-                {
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_perm                                                  *
+ *                                                                            *
+ * Purpose: test if agent has docker permission (docker group membership)     *
+ *                                                                            *
+ * Return value: ZBX_MODULE_OK - has docker perm                              *
+ *               ZBX_MODULE_FAIL - has not docker perm                        *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_perm()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_perm()");
+        // I hope that zabbix user cannot be member of more than 10 groups
+        int j, ngroups = 10;
+        gid_t *groups;
+        struct group *gr;
+        groups = malloc(ngroups * sizeof (gid_t));
+        if (groups == NULL)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Malloc error");
+            return 0;
+        }
+
+        struct passwd *p = getpwuid(geteuid());
+        if (getgrouplist(p->pw_name, geteuid(), groups, &ngroups) == -1)
+        {
+             zabbix_log(LOG_LEVEL_WARNING, "getgrouplist() returned -1; ngroups = %d\n", ngroups);
+             free(groups);
+             return 0;
+        }
+
+        for (j = 0; j < ngroups; j++)
+        {
+               gr = getgrgid(groups[j]);
+               if (gr != NULL)
+               {
+                   if (strcmp(gr->gr_name, "docker") == 0)
+                   {
+                       zabbix_log(LOG_LEVEL_DEBUG, "zabbix agent user has docker perm");
+                       free(groups);
+                       return 1;
+                   }
+               }
+        }
+        free(groups);
+        return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_api_detect                                            *
+ *                                                                            *
+ * Purpose: the function is trying to test Docker API availability            *
+ *                                                                            *
+ * Return value: 0 - API not detected                                         *
+ *               1 - API detected                                             *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_api_detect()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_api_detect()");
+        // test root or docker permission - custom socket (e.g. rootless Docker)
+        // doesn't need to be owned by docker group, so just try to connect
+        if (geteuid() != 0 && strcmp(docker_socket, ZBX_DOCKER_SOCKET) == 0 && zbx_docker_perm() != 1 )
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "Additional permission of Zabbix Agent are not detected - only basic docker metrics are available");
+            socket_api = 0;
+            return socket_api;
+        } else {
+            // test Docker's socket connection
+            const char *echo = zbx_module_docker_socket_query("GET /_ping HTTP/1.0\r\n\n", 0);
+            if (strcmp(echo, "OK") == 0)
+            {
+                zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket works - extended docker metrics are available");
+                socket_api = 1;
+                return socket_api;
+            } else {
+                zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket doesn't work - only basic docker metrics are available");
+                socket_api = 0;
+                return socket_api;
+            }
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_api_available                                         *
+ *                                                                            *
+ * Purpose: use detected Docker API availability or detect it again          *
+ *                                                                            *
+ * Return value: 0 - API not available                                        *
+ *               1 - API available                                            *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_api_available()
+{
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_API, socket_api);
+        if (socket_api == 1)
+        {
+            return socket_api;
+        }
+        return zbx_docker_api_detect();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_json_skip                                             *
+ *                                                                            *
+ * Purpose: skip one JSON value without parsing it                            *
+ *                                                                            *
+ * Parameters: p - start of the value                                         *
+ *                                                                            *
+ * Return value: position after the value, NULL - malformed JSON              *
+ *                                                                            *
+ * Notes: objects and arrays are skipped by depth, strings by jumps to the    *
+ *        next quote or backslash                                             *
+ ******************************************************************************/
+const char      *zbx_docker_json_skip(const char *p)
+{
+        int     depth = 0;
+
+        do
+        {
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                switch (*p)
+                {
+                        case '"':
+                                for (p++;; p += 2)
+                                {
+                                        p += strcspn(p, "\"\\");
+                                        if ('"' == *p)
+                                                break;
+                                        if ('\0' == *p || '\0' == p[1])
+                                                return NULL;
+                                }
+                                p++;
+                                break;
+                        case '{':
+                        case '[':
+                                depth++;
+                                p++;
+                                break;
+                        case '}':
+                        case ']':
+                        case ',':
+                        case ':':
+                                if (0 == depth)
+                                        return NULL;
+                                if (',' != *p && ':' != *p)
+                                        depth--;
+                                p++;
+                                break;
+                        case '\0':
+                                return NULL;
+                        default:
+                                // number, true, false or null
+                                p += strcspn(p, ",:]}" ZBX_DOCKER_JSON_WS);
+                }
+        }
+        while (0 < depth);
+
+        return p;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_json_member                                           *
+ *                                                                            *
+ * Purpose: find member of JSON object, other members are only skipped        *
+ *                                                                            *
+ * Parameters: p - JSON object                                                *
+ *             name - member name                                             *
+ *                                                                            *
+ * Return value: start of the member value, NULL - not found or p is not an   *
+ *               object                                                       *
+ *                                                                            *
+ * Notes: names are compared as raw bytes, escaped names do not match         *
+ ******************************************************************************/
+const char      *zbx_docker_json_member(const char *p, const char *name)
+{
+        const char      *key;
+        size_t          len = strlen(name);
+        int             match;
+
+        p += strspn(p, ZBX_DOCKER_JSON_WS);
+        if ('{' != *p++)
+                return NULL;
+
+        while (1)
+        {
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                if ('"' != *p)
+                        return NULL;
+                key = p + 1;
+                if (NULL == (p = zbx_docker_json_skip(p)))
+                        return NULL;
+                match = ((size_t)(p - key - 1) == len && 0 == memcmp(key, name, len));
+
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                if (':' != *p++)
+                        return NULL;
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                if (1 == match)
+                        return p;
+
+                if (NULL == (p = zbx_docker_json_skip(p)))
+                        return NULL;
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                if (',' != *p++)
+                        return NULL;
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_json_text                                             *
+ *                                                                            *
+ * Purpose: copy JSON string or scalar value to the arena                     *
+ *                                                                            *
+ * Parameters: p - start of the value                                         *
+ *                                                                            *
+ * Return value: unescaped string, text of number/true/false/null, NULL -     *
+ *               malformed JSON                                               *
+ *                                                                            *
+ ******************************************************************************/
+char    *zbx_docker_json_text(const char *p)
+{
+        const char      *end;
+        char            *text, *out;
+        unsigned int    c, low;
+
+        if (NULL == (end = zbx_docker_json_skip(p)))
+                return NULL;
+
+        if ('"' != *p)
+        {
+                text = zbx_docker_arena_alloc(end - p + 1);
+                memcpy(text, p, end - p);
+                text[end - p] = '\0';
+                return text;
+        }
+
+        // plain strings are copied, escaped are decoded, output is not longer than input
+        out = text = zbx_docker_arena_alloc(end - p);
+        for (p++, end--; p < end; p++)
+        {
+                if ('\\' != *p)
+                {
+                        *out++ = *p;
+                        continue;
+                }
+                switch (*++p)
+                {
+                        case 'b': *out++ = '\b'; break;
+                        case 'f': *out++ = '\f'; break;
+                        case 'n': *out++ = '\n'; break;
+                        case 'r': *out++ = '\r'; break;
+                        case 't': *out++ = '\t'; break;
+                        case 'u':
+                                if (end - p < 5 || 1 != sscanf(p + 1, "%4x", &c))
+                                        return NULL;
+                                p += 4;
+                                // surrogate pair
+                                if (0xd800 <= c && 0xdc00 > c && end - p > 6 && '\\' == p[1] && 'u' == p[2] &&
+                                                1 == sscanf(p + 3, "%4x", &low) && 0xdc00 <= low && 0xe000 > low)
+                                {
+                                        c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                                        p += 6;
+                                }
+                                if (0x80 > c)
+                                        *out++ = c;
+                                else if (0x800 > c)
+                                {
+                                        *out++ = 0xc0 | (c >> 6);
+                                        *out++ = 0x80 | (c & 0x3f);
+                                }
+                                else if (0x10000 > c)
+                                {
+                                        *out++ = 0xe0 | (c >> 12);
+                                        *out++ = 0x80 | ((c >> 6) & 0x3f);
+                                        *out++ = 0x80 | (c & 0x3f);
+                                }
+                                else
+                                {
+                                        *out++ = 0xf0 | (c >> 18);
+                                        *out++ = 0x80 | ((c >> 12) & 0x3f);
+                                        *out++ = 0x80 | ((c >> 6) & 0x3f);
+                                        *out++ = 0x80 | (c & 0x3f);
+                                }
+                                break;
+                        default:
+                                // \" \\ \/
+                                *out++ = *p;
+                }
+        }
+        *out = '\0';
+
+        return text;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_json_dump                                             *
+ *                                                                            *
+ * Purpose: normalized text of JSON object or array value in the arena        *
+ *                                                                            *
+ * Parameters: p - start of the value                                         *
+ *                                                                            *
+ * Return value: json_dumps() text, NULL - malformed JSON                     *
+ *                                                                            *
+ * Notes: only the subtree is parsed                                          *
+ ******************************************************************************/
+char    *zbx_docker_json_dump(const char *p)
+{
+        const char      *end;
+        json_t          *jp_data;
+        char            *dump, *text;
+
+        if (NULL == (end = zbx_docker_json_skip(p)) || NULL == (jp_data = json_loadb(p, end - p, 0, NULL)))
+                return NULL;
+
+        dump = json_dumps(jp_data, JSON_ENCODE_ANY);
+        json_decref(jp_data);
+        if (NULL == dump)
+                return NULL;
+        text = zbx_docker_arena_strdup(dump);
+        free(dump);
+
+        return text;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_json_next                                             *
+ *                                                                            *
+ * Purpose: iterate values of JSON array or object                            *
+ *                                                                            *
+ * Parameters: parent - JSON array or object                                  *
+ *             value - previous value, NULL - get the first value             *
+ *                                                                            *
+ * Return value: start of the next value, NULL - no more values or malformed  *
+ *               JSON                                                         *
+ *                                                                            *
+ * Notes: member names of objects are skipped                                 *
+ ******************************************************************************/
+const char      *zbx_docker_json_next(const char *parent, const char *value)
+{
+        const char      *p;
+
+        parent += strspn(parent, ZBX_DOCKER_JSON_WS);
+        if ('{' != *parent && '[' != *parent)
+                return NULL;
+
+        if (NULL == value)
+        {
+                p = parent + 1;
+        }
+        else
+        {
+                if (NULL == (p = zbx_docker_json_skip(value)))
+                        return NULL;
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                if (',' != *p++)
+                        return NULL;
+        }
+        p += strspn(p, ZBX_DOCKER_JSON_WS);
+
+        if ('{' == *parent)
+        {
+                if ('"' != *p || NULL == (p = zbx_docker_json_skip(p)))
+                        return NULL;
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                if (':' != *p++)
+                        return NULL;
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+        }
+
+        return '}' == *p || ']' == *p || '\0' == *p ? NULL : p;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_json_uint64                                           *
+ *                                                                            *
+ * Purpose: unsigned integer member of JSON object                            *
+ *                                                                            *
+ * Parameters: p - JSON object, NULL is accepted                              *
+ *             name - member name                                             *
+ *             value - [OUT] member value                                     *
+ *                                                                            *
+ * Return value: SUCCEED, FAIL - member is not found or not a number          *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_json_uint64(const char *p, const char *name, zbx_uint64_t *value)
+{
+        if (NULL == p || NULL == (p = zbx_docker_json_member(p, name)) || '0' > *p || '9' < *p)
+                return FAIL;
+
+        *value = strtoull(p, NULL, 10);
+        return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_path_parse                                            *
+ *                                                                            *
+ * Purpose: compile path expression to steps                                  *
+ *                                                                            *
+ * Parameters: path - compiled path, steps are appended                       *
+ *             p - path expression, e.g. NetworkSettings.Networks.bridge.     *
+ *                 IPAddress, blkio_stats.io_service_bytes_recursive[0].value *
+ *             out - buffer for names and values of steps, strlen(p) + 1      *
+ *                                                                            *
+ * Return value: SUCCEED - expression is compiled, FAIL - invalid expression  *
+ *                                                                            *
+ * Notes: steps are .name, [N] (array index), [name=value] (the first array   *
+ *        object with member of the value) and ["name"] (member name with     *
+ *        '.' or '[', e.g. label)                                             *
+ ******************************************************************************/
+int     zbx_docker_path_parse(zbx_docker_path_t *path, const char *p, char *out)
+{
+        zbx_docker_path_step_t  *step;
+        const char              *end, *equal;
+        char                    *number_end;
+        size_t                  len;
+
+        do
+        {
+                path->steps = realloc(path->steps, sizeof(zbx_docker_path_step_t) * (path->steps_num + 1));
+                step = &path->steps[path->steps_num++];
+                memset(step, 0, sizeof(zbx_docker_path_step_t));
+
+                if ('[' != *p)
+                {
+                        if (0 == (len = strcspn(p, ".[")))
+                                return FAIL;
+                        step->type = ZBX_DOCKER_STEP_MEMBER;
+                        step->name = out;
+                        end = p + len;
+                }
+                else if ('"' == p[1])
+                {
+                        if (NULL == (end = strchr(p + 2, '"')) || ']' != end[1])
+                                return FAIL;
+                        step->type = ZBX_DOCKER_STEP_MEMBER;
+                        step->name = out;
+                        len = end - p - 2;
+                        p += 2;
+                        end += 2;
+                }
+                else if ('0' <= p[1] && '9' >= p[1])
+                {
+                        step->type = ZBX_DOCKER_STEP_INDEX;
+                        step->index = (int)strtol(p + 1, &number_end, 10);
+                        if (']' != *number_end)
+                                return FAIL;
+                        p = number_end + 1;
+                        len = 0;
+                        end = p;
+                }
+                else
+                {
+                        if (NULL == (end = strchr(p, ']')) || NULL == (equal = memchr(p, '=', end - p)) ||
+                                        equal == p + 1)
+                        {
+                                return FAIL;
+                        }
+                        step->type = ZBX_DOCKER_STEP_FILTER;
+                        step->name = out;
+                        memcpy(out, p + 1, equal - p - 1);
+                        out += equal - p - 1;
+                        *out++ = '\0';
+
+                        // value may be quoted
+                        p = equal + 1;
+                        len = end - p;
+                        if (2 <= len && '"' == *p && '"' == p[len - 1])
+                        {
+                                p++;
+                                len -= 2;
+                        }
+                        step->value = out;
+                        end++;
+                }
+
+                memcpy(out, p, len);
+                out += len;
+                *out++ = '\0';
+
+                p = end;
+                if ('.' == *p)
+                {
+                        if ('\0' == *++p)
+                                return FAIL;
+                }
+                else if ('\0' != *p && '[' != *p)
+                        return FAIL;
+        }
+        while ('\0' != *p);
+
+        return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_path_get                                              *
+ *                                                                            *
+ * Purpose: get compiled JSON path of the item, every distinct item key is    *
+ *          compiled only once per agent process                              *
+ *                                                                            *
+ * Parameters: request - item key                                             *
+ *             first - index of the first path parameter                      *
+ *                                                                            *
+ * Return value: compiled path, NULL - invalid path expression                *
+ *                                                                            *
+ * Notes: single parameter with '.' or '[' is a path expression, otherwise    *
+ *        every parameter is a member name (legacy par1,par2,par3 keys)       *
+ ******************************************************************************/
+zbx_docker_path_t       *zbx_docker_path_get(AGENT_REQUEST *request, int first)
+{
+        zbx_docker_path_t       *entry;
+        char                    *key, *out;
+        const char              *param;
+        int                     i, ret = SUCCEED;
+
+        key = zbx_docker_arena_strdup(get_rparam(request, first));
+        for (i = first + 1; i < request->nparam; i++)
+                key = zbx_docker_arena_dsprintf("%s\n%s", key, get_rparam(request, i));
+
+        entry = &path_cache[zbx_docker_id_hash(key) & (ZBX_DOCKER_PATH_SIZE - 1)];
+        if (NULL != entry->key && 0 == strcmp(entry->key, key))
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_PATH, 1);
+                return 0 == entry->steps_num ? NULL : entry;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_PATH, 0);
+
+        entry->key = zbx_strdup(entry->key, key);
+        entry->buffer = zbx_strdup(entry->buffer, key);
+        entry->steps_num = 0;
+
+        param = get_rparam(request, first);
+        if (first + 1 == request->nparam && NULL != strpbrk(param, ".["))
+        {
+                ret = zbx_docker_path_parse(entry, param, entry->buffer);
+        }
+        else
+        {
+                entry->steps = realloc(entry->steps, sizeof(zbx_docker_path_step_t) * (request->nparam - first));
+                for (out = entry->buffer, i = first; i < request->nparam; i++)
+                {
+                        entry->steps[entry->steps_num].type = ZBX_DOCKER_STEP_MEMBER;
+                        entry->steps[entry->steps_num++].name = out;
+                        out += strcspn(out, "\n");
+                        *out++ = '\0';
+                }
+        }
+
+        if (SUCCEED != ret)
+        {
+                zabbix_log(LOG_LEVEL_WARNING, "Invalid JSON path expression: %s", param);
+                entry->steps_num = 0;
+                return NULL;
+        }
+
+        return entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_path_eval                                             *
+ *                                                                            *
+ * Purpose: find value of compiled JSON path in the document                  *
+ *                                                                            *
+ * Parameters: path - compiled path                                           *
+ *             p - JSON document                                              *
+ *                                                                            *
+ * Return value: start of the value, NULL - not found                         *
+ *                                                                            *
+ * Notes: only the path is tokenized, other values are skipped                *
+ ******************************************************************************/
+const char      *zbx_docker_path_eval(const zbx_docker_path_t *path, const char *p)
+{
+        const zbx_docker_path_step_t    *step;
+        const char                      *element, *member;
+        char                            *text;
+        int                             i, n;
+
+        for (i = 0; NULL != p && i < path->steps_num; i++)
+        {
+                step = &path->steps[i];
+                if (ZBX_DOCKER_STEP_MEMBER == step->type)
+                {
+                        p = zbx_docker_json_member(p, step->name);
+                        continue;
+                }
+
+                p += strspn(p, ZBX_DOCKER_JSON_WS);
+                if ('[' != *p)
+                        return NULL;
+                for (n = 0, element = p + 1;; n++)
+                {
+                        element += strspn(element, ZBX_DOCKER_JSON_WS);
+                        if (']' == *element)
+                                return NULL;
+                        if (ZBX_DOCKER_STEP_INDEX == step->type ? n == step->index :
+                                        NULL != (member = zbx_docker_json_member(element, step->name)) &&
+                                        NULL != (text = zbx_docker_json_text(member)) &&
+                                        0 == strcmp(text, step->value))
+                        {
+                                break;
+                        }
+                        if (NULL == (element = zbx_docker_json_skip(element)))
+                                return NULL;
+                        element += strspn(element, ZBX_DOCKER_JSON_WS);
+                        if (',' != *element++)
+                                return NULL;
+                }
+                p = element;
+        }
+
+        return p;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_document_get                                          *
+ *                                                                            *
+ * Purpose: get inspect or stats document of the container, Docker API is     *
+ *          queried at most once per ZBX_DOCKER_DOCUMENT_TTL for all items    *
+ *                                                                            *
+ * Parameters: endpoint - ZBX_DOCKER_ENDPOINT_INSPECT,                        *
+ *                        ZBX_DOCKER_ENDPOINT_STATS or                        *
+ *                        ZBX_DOCKER_DOCUMENT_CGROUP                          *
+ *             container - container id or name without leading '/'          *
+ *                                                                            *
+ * Return value: JSON document, NULL - Docker API query failed               *
+ *                                                                            *
+ ******************************************************************************/
+const char      *zbx_docker_document_get(int endpoint, const char *container)
+{
+        zbx_docker_document_t   *entry;
+        zbx_uint64_t            now = zbx_docker_stats_time();
+        const char              *answer;
+
+        entry = &document_cache[(zbx_docker_id_hash(container) + endpoint) & (ZBX_DOCKER_DOCUMENT_SIZE - 1)];
+        if (0 != entry->time_us && now - entry->time_us < ZBX_DOCKER_DOCUMENT_TTL && endpoint == entry->endpoint &&
+                        0 == strcmp(entry->id, container))
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_DOCUMENT, 1);
+                return entry->body;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_DOCUMENT, 0);
+
+        if (ZBX_DOCKER_DOCUMENT_CGROUP == endpoint)
+        {
+                if (NULL == (answer = zbx_docker_stats_cgroup(container)))
+                        return NULL;
+        }
+        else if (ZBX_DOCKER_ENDPOINT_STATS == endpoint)
+        {
+                // stats output is stream
+                answer = zbx_module_docker_socket_query(zbx_docker_arena_dsprintf(
+                                "GET /containers/%s/stats HTTP/1.0\r\n\n", container), 1);
+        }
+        else
+        {
+                answer = zbx_module_docker_socket_query(zbx_docker_arena_dsprintf(
+                                "GET /containers/%s/json HTTP/1.0\r\n\n", container), 0);
+        }
+        if ('\0' == *answer)
+                return NULL;
+        if (strlen(container) >= sizeof(entry->id))
+                return answer;
+
+        entry->endpoint = endpoint;
+        zbx_strlcpy(entry->id, container, sizeof(entry->id));
+        entry->body = zbx_strdup(entry->body, answer);
+        entry->time_us = now;
+
+        return entry->body;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_path_result                                           *
+ *                                                                            *
+ * Purpose: set item result to value of compiled JSON path in the document    *
+ *                                                                            *
+ * Parameters: request - item key                                             *
+ *             result - item result                                           *
+ *             path - compiled path of the item                               *
+ *             document - JSON document                                       *
+ *             first - index of the first path parameter                      *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: strings are returned unquoted, numbers and booleans as text,        *
+ *        objects and arrays as JSON                                          *
+ ******************************************************************************/
+int     zbx_docker_path_result(AGENT_REQUEST *request, AGENT_RESULT *result, const zbx_docker_path_t *path,
+                const char *document, int first)
+{
+        const char      *value;
+        char            *label, *text;
+        int             i;
+
+        // [par1][par2]... or [path expression] in messages
+        label = "";
+        for (i = first; i < request->nparam; i++)
+                label = zbx_docker_arena_dsprintf("%s[%s]", label, get_rparam(request, i));
+
+        if (NULL == (value = zbx_docker_path_eval(path, document)))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot find the %s item in the received JSON object", label);
+            SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot find the %s item in the received JSON object", label));
+            return SYSINFO_RET_FAIL;
+        }
+
+        if (NULL == (text = '{' == *value || '[' == *value ? zbx_docker_json_dump(value) : zbx_docker_json_text(value)))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot parse the %s item in the received JSON object", label);
+            SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot parse the %s item in the received JSON object", label));
+            return SYSINFO_RET_FAIL;
+        }
+
+        zabbix_log(LOG_LEVEL_DEBUG, "Item %s found in the received JSON object: %s", label, text);
+        SET_STR_RESULT(result, zbx_strdup(NULL, text));
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_path_item                                             *
+ *                                                                            *
+ * Purpose: value of JSON path in inspect or stats document of the container  *
+ *                                                                            *
+ * Parameters: request - item key, container id is the 1st parameter, path    *
+ *                       is the 2nd and next parameters                       *
+ *             endpoint - ZBX_DOCKER_ENDPOINT_INSPECT or                      *
+ *                        ZBX_DOCKER_ENDPOINT_STATS                           *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_path_item(AGENT_REQUEST *request, AGENT_RESULT *result, int endpoint)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_path_item()");
+        zbx_docker_path_t       *path;
+        const char              *document;
+        char                    *container;
+
+        if (zbx_docker_api_available() == 0)
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not available");
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "Docker's socket API is not available"));
+            return SYSINFO_RET_FAIL;
+        }
+
+        if (2 > request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (NULL == (path = zbx_docker_path_get(request, 1)))
+        {
+                SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid JSON path expression: %s", get_rparam(request, 1)));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = get_rparam(request, 0);
+        // skip leading '/' in case of human name or short container id
+        if (container[0] == '/')
+        {
+            container++;
+        }
+
+        // common stats paths are answered from cgroups, other paths, unknown containers and values missing
+        // in the cgroup document (e.g. networks without readable /proc/<pid>) by Docker API
+        document = NULL;
+        if (ZBX_DOCKER_ENDPOINT_STATS == endpoint && 1 == stats_cgroup &&
+                ZBX_DOCKER_STEP_MEMBER == path->steps[0].type && (0 == strcmp(path->steps[0].name, "memory_stats") ||
+                0 == strcmp(path->steps[0].name, "cpu_stats") || 0 == strcmp(path->steps[0].name, "blkio_stats") ||
+                0 == strcmp(path->steps[0].name, "pids_stats") || 0 == strcmp(path->steps[0].name, "networks")))
+        {
+            document = zbx_docker_document_get(ZBX_DOCKER_DOCUMENT_CGROUP, container);
+            if (NULL != document && NULL == zbx_docker_path_eval(path, document))
+                document = NULL;
+        }
+
+        if (NULL == document && NULL == (document = zbx_docker_document_get(endpoint, container)))
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "%s is not available at the moment - some problem with Docker's socket API", request->key);
+            SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s is not available at the moment - some problem with Docker's socket API", request->key));
+            return SYSINFO_RET_FAIL;
+        }
+
+        return zbx_docker_path_result(request, result, path, document, 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_inspect_exec                                   *
+ *                                                                            *
+ * Purpose: container inspection                                              *
+ *                                                                            *
+ * Return value: inspect_result structure, value is in the arena             *
+ *                                                                            *
+ ******************************************************************************/
+struct inspect_result     zbx_module_docker_inspect_exec(const char *container, const char *param1, const char *param2, const char *param3)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_inspect_exec()");
+        struct inspect_result iresult;
+
+        if (zbx_docker_api_available() == 0)
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not available");
+            iresult.value = zbx_docker_arena_strdup("Docker's socket API is not available");
+            iresult.return_code = SYSINFO_RET_FAIL;
+            return iresult;
+        }
+
+        if (container == NULL || param1 == NULL)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  (container != NULL) + (param1 != NULL));
+                iresult.value = zbx_docker_arena_strdup("Invalid number of parameters");
+                iresult.return_code = SYSINFO_RET_FAIL;
+                return iresult;
+        }
+
+        // skip leading '/' in case of human name or short container id
+        if (container[0] == '/')
+        {
+            container++;
+        }
+
+        const char *answer = zbx_docker_document_get(ZBX_DOCKER_ENDPOINT_INSPECT, container);
+        if (NULL == answer)
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "docker.inspect is not available at the moment - some problem with Docker's socket API");
+            iresult.value = zbx_docker_arena_strdup("docker.inspect is not available at the moment - some problem with Docker's socket API");
+            iresult.return_code = SYSINFO_RET_FAIL;
+            return iresult;
+        }
+
+        // only the requested path is tokenized, DOM is built only for a requested subtree
+        const char *jp_data2, *jp_data3, *jp_data4, *element, *next;
+        char *value;
+
+        if (NULL == (jp_data2 = zbx_docker_json_member(answer, param1)))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s] item in the received JSON object", param1);
+            iresult.value = zbx_docker_arena_dsprintf("Cannot find the [%s] item in the received JSON object", param1);
+            iresult.return_code = SYSINFO_RET_FAIL;
+            return iresult;
+        }
+
+        if (param2 == NULL)
+        {
+            // 1st level - plain value
+            if ('{' == *jp_data2 || '[' == *jp_data2 || NULL == (value = zbx_docker_json_text(jp_data2)))
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Item [%s] found in the received JSON object, but it's not plain value object", param1);
+                iresult.value = zbx_docker_arena_dsprintf("Can find the [%s] item in the received JSON object, but it's not plain value object", param1);
+                iresult.return_code = SYSINFO_RET_FAIL;
+                return iresult;
+            }
+            zabbix_log(LOG_LEVEL_DEBUG, "Item [%s] found in the received JSON object: %s", param1, value);
+            iresult.value = value;
+            iresult.return_code = SYSINFO_RET_OK;
+            return iresult;
+        }
+
+        // 2nd level
+        zabbix_log(LOG_LEVEL_DEBUG, "Item [%s] found in the received JSON object", param1);
+        if (NULL == (jp_data3 = zbx_docker_json_member(jp_data2, param2)))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s] item in the received JSON object", param1, param2);
+            iresult.value = zbx_docker_arena_dsprintf("Cannot find the [%s][%s] item in the received JSON object", param1, param2);
+            iresult.return_code = SYSINFO_RET_FAIL;
+            return iresult;
+        }
+
+        if (param3 == NULL)
+        {
+            // plain value or whole subtree
+            value = '{' == *jp_data3 || '[' == *jp_data3 ? zbx_docker_json_dump(jp_data3) : zbx_docker_json_text(jp_data3);
+            if (NULL == value)
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Cannot parse the [%s][%s] item in the received JSON object", param1, param2);
+                iresult.value = zbx_docker_arena_dsprintf("Cannot parse the [%s][%s] item in the received JSON object", param1, param2);
+                iresult.return_code = SYSINFO_RET_FAIL;
+                return iresult;
+            }
+            zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s] found in the received JSON object: %s", param1, param2, value);
+            iresult.value = value;
+            iresult.return_code = SYSINFO_RET_OK;
+            return iresult;
+        }
+
+        if ('[' != *jp_data3)
+        {
+            // 3rd level
+            if (NULL == (jp_data4 = zbx_docker_json_member(jp_data3, param3)) || '"' != *jp_data4 ||
+                    NULL == (value = zbx_docker_json_text(jp_data4)))
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s][%s] item in the received JSON object", param1, param2, param3);
+                iresult.value = zbx_docker_arena_dsprintf("Cannot find the [%s][%s][%s] item in the received JSON object", param1, param2, param3);
+                iresult.return_code = SYSINFO_RET_FAIL;
+                return iresult;
+            }
+            zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s][%s] found in the received JSON object: %s", param1, param2, param3, value);
+            iresult.value = value;
+            iresult.return_code = SYSINFO_RET_OK;
+            return iresult;
+        }
+
+        // find item in array - selector is param3
+        for (element = jp_data3 + 1; ; element = next + 1)
+        {
+            element += strspn(element, ZBX_DOCKER_JSON_WS);
+            if (']' == *element)
+                break;
+            if ('"' != *element || NULL == (value = zbx_docker_json_text(element)))
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s][%s] item in the received JSON object (non standard JSON array)", param1, param2, param3);
+                iresult.value = zbx_docker_arena_dsprintf("Cannot find the [%s][%s][%s] item in the received JSON object (non standard JSON array)", param1, param2, param3);
+                iresult.return_code = SYSINFO_RET_FAIL;
+                return iresult;
+            }
+            zabbix_log(LOG_LEVEL_DEBUG, "Array item: %s", value);
+
+            char *string, *selector;
+            string = zbx_docker_arena_strdup(param3);
+
+            // hacking: Marathon MESOS_TASK_ID, Chronos - mesos_task_id
+            // docker.inspect[cid,Config,Env,MESOS_TASK_ID=|mesos_task_id=]
+            while ((selector = strsep(&string, "|")) != NULL) {
+                // if start of value match with array selector return without selector
+                if (strncmp(value, selector, strlen(selector)) == 0)
+                {
+                    // remove selector from returned value
+                    value += strlen(selector);
+
+                    zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s][%s] found in the received JSON object: %s", param1, param2, selector, value);
+                    iresult.value = value;
+                    iresult.return_code = SYSINFO_RET_OK;
+                    return iresult;
+                }
+            }
+
+            // malformed element - no pointer arithmetic on NULL
+            if (NULL == (next = zbx_docker_json_skip(element)))
+                break;
+            next += strspn(next, ZBX_DOCKER_JSON_WS);
+            if (',' != *next)
+                break;
+        }
+        zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s][%s] item in the received JSON object (selector - param3 doesn't match any value)", param1, param2, param3);
+        iresult.value = zbx_docker_arena_dsprintf("Cannot find the [%s][%s][%s] item in the received JSON object (selector - param3 doesn't match any value)", param1, param2, param3);
+        iresult.return_code = SYSINFO_RET_FAIL;
+        return iresult;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function:  zbx_module_docker_port_discovery                                *
+ *                                                                            *
+ * Purpose: published container port discovery                                *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int zbx_module_docker_port_discovery(AGENT_REQUEST * request, AGENT_RESULT * result) {
+  zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_discover_ports()");
+
+  if (2 < request->nparam || 0 == request->nparam) {
+    zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d", request->nparam);
+    SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters"));
+    return SYSINFO_RET_FAIL;
+  }
+
+  char * container;
+  container = get_rparam(request, 0);
+
+  struct inspect_result iresult;
+  iresult = zbx_module_docker_inspect_exec(container, "HostConfig", "PortBindings", NULL);
+  if (iresult.return_code == SYSINFO_RET_FAIL) {
+    zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec FAIL: %s", iresult.value);
+    SET_MSG_RESULT(result, zbx_strdup(NULL, iresult.value));
+    return SYSINFO_RET_FAIL;
+  }
+
+  // now parse the value we get back from zbx_module_docker_inspect_exec()
+  json_t *jp_data = json_loads(iresult.value, 0, NULL);
+
+  char container_port[6];
+  int port_len;
+  const char
+    *proto = NULL,
+    *request_proto = NULL;
+
+  json_t *a = json_array();
+
+  if (1 < request->nparam) {
+    request_proto = get_rparam(request, 1);
+  }
+  const char *buf;
+  json_t *p;
+  json_object_foreach(jp_data, buf, p) {
+    // Split "12345/tcp" specifier
+    proto = strstr(buf, "/") + 1;
+    port_len = proto - buf;
+    zbx_strlcpy(container_port, buf, port_len);
+
+    if (NULL != request_proto && '\0' != *request_proto && 0 != strcmp(request_proto, proto)) {
+      continue;
+    }
+
+    // Open list of HostIP/HostPort dicts
+    json_t *jp_obj = json_array_get(p, 0);
+    if (NULL == jp_obj) {
+      //zabbix_log(LOG_LEVEL_DEBUG, "zbx_json_brackets_open FAIL: %s", zbx_json_strerror());
+      continue;
+    }
+
+    // Lookup HostPort value
+    const char *host_port = json_string_value(json_object_get(jp_obj, "HostPort"));
+    if (NULL == host_port) {
+      //zabbix_log(LOG_LEVEL_DEBUG, "zbx_json_value_by_name FAIL: %s", zbx_json_strerror());
+      continue;
+    }
+
+    json_t *o = json_object();
+    json_object_set_new(o, "{#HOSTPORT}", json_string(host_port));
+    json_object_set_new(o, "{#CONTAINERPORT}", json_string(container_port));
+    json_object_set_new(o, "{#PROTO}", json_string(proto));
+    json_array_append_new(a, o);
+
+  }
+  json_t *j = json_object();
+  json_object_set_new(j, "data", a);
+  SET_STR_RESULT(result, json_dumps(j, 0));
+  json_decref(j);
+  json_decref(jp_data);
+
+  return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_get_fci                                        *
+ *                                                                            *
+ * Purpose: get full container ID, if container name is specified             *
+ *                                                                            *
+ * Return value: empty string - function failed                               *
+ *               string - full container ID in the arena                      *
+ ******************************************************************************/
+char*  zbx_module_docker_get_fci(char *fci)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_get_fci()");
+
+        // if first character is '/', then detect fci
+        if (fci[0] != '/')
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "Original full container id will be used");
+            return zbx_docker_arena_strdup(fci);
+        }
+
+        // Docker API query - docker.inspect[fci,Id]
+        zabbix_log(LOG_LEVEL_DEBUG, "Translating container name to fci by using docker.inspect");
+        // TODO dynamic iresult
+        struct inspect_result iresult;
+        iresult = zbx_module_docker_inspect_exec(fci, "Id", NULL, NULL);
+        if (iresult.return_code == SYSINFO_RET_OK) {
+            zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec OK: %s", iresult.value);
+            return iresult.value;
+        } else {
+            zabbix_log(LOG_LEVEL_DEBUG, "Default fci will be used, because zbx_module_docker_inspect_exec FAIL: %s", iresult.value);
+            return zbx_docker_arena_strdup(fci);
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_dir_detect                                            *
+ *                                                                            *
+ * Purpose: it should find metric folder - it depends on docker version       *
+ *            or execution environment                                        *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - stat folder was not found                 *
+ *               SYSINFO_RET_OK - stat folder was found                       *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_dir_detect()
+{
+        // TODO logic should be changed for all lxc/docker/systemd container support
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_dir_detect()");
+
+        char *drivers[] = {
+            "docker/",        // Non-systemd Docker: docker -d -e native
+            "system.slice/",  // Systemd Docker
+            "lxc/",           // Non-systemd LXC: docker -d -e lxc
+            "libvirt/lxc/",   // Legacy libvirt-lxc
+            // TODO pos = cgroup.find("-lxc\\x2");     // Systemd libvirt-lxc
+            // TODO pos = cgroup.find(".libvirt-lxc"); // Non-systemd libvirt-lxc
+            NULL
+        }, **tdriver;
+        char path[512], unified[512] = "", fstype[32], *mounts, *mount_dir = NULL;
+        const char *mounts_regex = "^[^[:blank:]]+[[:blank:]]+(/[^[:blank:]]+/)[^[:blank:]]+[[:blank:]]+cgroup[[:blank:]]+.*$";
+        char *cgroup = "cpuset/";
+        FILE *fp;
+        DIR  *dir;
+
+        cgroup_v2 = 0;
+        mounts = zbx_dsprintf(NULL, "%s/proc/mounts", rootfs);
+        if ((fp = fopen(mounts, "r")) == NULL)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot open %s: %s", mounts, zbx_strerror(errno));
+            free(mounts);
+            return SYSINFO_RET_FAIL;
+        }
+        free(mounts);
+
+        while (fgets(path, 512, fp) != NULL)
+        {
+            if ((strstr(path, "cpuset cgroup")) != NULL)
+            {
+                if (SUCCEED != zbx_regexp_sub(path, mounts_regex, "\\1", &mount_dir) || NULL == mount_dir)
+                {
+                    continue;
+                }
+                break;
+            }
+            // cgroup v2 (unified hierarchy) is used only if there is no cgroup v1 cpuset
+            if ('\0' == *unified && (2 != sscanf(path, "%*s %511s %31s", unified, fstype) ||
+                    0 != strcmp(fstype, "cgroup2")))
+            {
+                *unified = '\0';
+            }
+        }
+        zbx_fclose(fp);
+
+        if (NULL == mount_dir)
+        {
+            if ('\0' == *unified)
+            {
+                zabbix_log(LOG_LEVEL_DEBUG, "Cannot detect docker stat directory");
+                return SYSINFO_RET_FAIL;
+            }
+            zabbix_log(LOG_LEVEL_DEBUG, "Detected cgroup v2 (unified hierarchy): %s", unified);
+            cgroup_v2 = 1;
+            cgroup = "";
+            mount_dir = zbx_dsprintf(NULL, "%s/", unified);
+        }
+        free(stat_dir);
+        stat_dir = zbx_dsprintf(NULL, "%s%s", rootfs, mount_dir);
+        free(mount_dir);
+        zabbix_log(LOG_LEVEL_DEBUG, "Detected docker stat directory: %s", stat_dir);
+
+        tdriver = drivers;
+        size_t  ddir_size;
+        char    *ddir;
+        while (*tdriver != NULL)
+        {
+            ddir_size = strlen(cgroup) + strlen(stat_dir) + strlen(*tdriver) + 1;
+            ddir = malloc(ddir_size);
+            zbx_strlcpy(ddir, stat_dir, ddir_size);
+            zbx_strlcat(ddir, cgroup, ddir_size);
+            zbx_strlcat(ddir, *tdriver, ddir_size);
+            if (NULL != (dir = opendir(ddir)))
+            {
+                closedir(dir);
+                free(ddir);
+                driver = *tdriver;
+                zabbix_log(LOG_LEVEL_DEBUG, "Detected used docker driver dir: %s", driver);
+                // systemd docker
+                if (strcmp(driver, "system.slice/") == 0)
+                {
+                    zabbix_log(LOG_LEVEL_DEBUG, "Detected systemd docker - prefix/suffix will be used");
+                    c_prefix = "docker-";
+                    c_suffix = ".scope";
+                }
+                // cgroup v2 - all controllers are in the container directory
+                if (1 == cgroup_v2)
+                {
+                    cpu_cgroup = "";
+                    return SYSINFO_RET_OK;
+                }
+                // detect cpu_cgroup - JoinController cpu,cpuacct
+                cgroup = "cpu,cpuacct/";
+                ddir_size = strlen(cgroup) + strlen(stat_dir) + 1;
+                ddir = malloc(ddir_size);
+                zbx_strlcpy(ddir, stat_dir, ddir_size);
+                zbx_strlcat(ddir, cgroup, ddir_size);
+                if (NULL != (dir = opendir(ddir)))
+                {
+                    closedir(dir);
+                    cpu_cgroup = "cpu,cpuacct/";
+                    zabbix_log(LOG_LEVEL_DEBUG, "Detected JoinController cpu,cpuacct");
+                } else {
+                    cpu_cgroup = "cpuacct/";
+                }
+                free(ddir);
+                return SYSINFO_RET_OK;
+            }
+            tdriver++;
+            free(ddir);
+        }
+        driver = "";
+        zabbix_log(LOG_LEVEL_DEBUG, "Cannot detect used docker driver");
+        return SYSINFO_RET_FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cgroup_path                                           *
+ *                                                                            *
+ * Purpose: build path of container cgroup pseudo-file                        *
+ *                                                                            *
+ * Parameters: cgroup - cgroup v1 controller directory, e.g. "memory/"        *
+ *             container - full container id or cgroup directory name         *
+ *             file - pseudo-file with leading '/', e.g. "/memory.stat"       *
+ *                                                                            *
+ * Return value: path of pseudo-file, it must be freed by caller              *
+ *                                                                            *
+ * Notes: controller directory is not used for cgroup v2, where all           *
+ *        controllers share one (unified) hierarchy                           *
+ ******************************************************************************/
+char    *zbx_docker_cgroup_path(const char *cgroup, const char *container, const char *file)
+{
+        const char *prefix = "", *suffix = "";
+
+        // systemd docker: docker-<fci>.scope, unless cgroup directory name is used
+        if (strstr(container, ".") == NULL)
+        {
+            if (c_prefix != NULL)
+            {
+                prefix = c_prefix;
+            }
+            if (c_suffix != NULL)
+            {
+                suffix = c_suffix;
+            }
+        }
+
+        return zbx_dsprintf(NULL, "%s%s%s%s%s%s%s", stat_dir, 1 == cgroup_v2 ? "" : cgroup, driver, prefix, container, suffix, file);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_id_hash                                               *
+ *                                                                            *
+ * Purpose: FNV-1a hash of container id                                       *
+ *                                                                            *
+ ******************************************************************************/
+unsigned int    zbx_docker_id_hash(const char *id)
+{
+        unsigned int    hash = 0x811c9dc5U;
+
+        for (; '\0' != *id; id++)
+                hash = (hash ^ (unsigned char)*id) * 0x01000193U;
+
+        return hash;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_read_file                                             *
+ *                                                                            *
+ * Purpose: read short pseudo-file (single value, e.g. cpu.max) by one read() *
+ *                                                                            *
+ * Return value: length of the content, -1 - file cannot be read              *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_read_file(const char *filename, char *buffer, size_t size)
+{
+        int     fd;
+        ssize_t n;
+
+        if (-1 == (fd = open(filename, O_RDONLY | O_CLOEXEC)))
+                return -1;
+        n = read(fd, buffer, size - 1);
+        close(fd);
+        if (0 > n)
+                return -1;
+        buffer[n] = '\0';
+
+        return (int)n;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_up                                             *
+ *                                                                            *
+ * Purpose: check if container is running                                     *
+ *                                                                            *
+ * Return value: 1 - is running, 0 - is not running                           *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_up(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_up()");
+        char    *container;
+
+        if (1 != request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL)
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "docker.up check is not available at the moment - no stat directory");
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.up check is not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if(cpu_cgroup == NULL)
+        {
+                if (zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
+                {
+                    zabbix_log(LOG_LEVEL_DEBUG, "docker.up check is not available at the moment - no cpu_cgroup directory");
+                    SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.up check is not available at the moment - no cpu_cgroup directory"));
+                    return SYSINFO_RET_FAIL;
+                }
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+
+        // answer from the live set, metric file is opened only if container tracking is not available
+        int     running = zbx_docker_container_live(container);
+        if (-1 != running)
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Container %s is %s", container, 1 == running ? "running" : "not running");
+                SET_UI64_RESULT(result, running);
+                return SYSINFO_RET_OK;
+        }
+
+        char    *stat_file = 1 == cgroup_v2 ? "/cpu.stat" : "/cpuacct.stat";
+        char    *filename = zbx_docker_cgroup_path(cpu_cgroup, container, stat_file);
+        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
+        FILE    *file;
+        if (NULL == (file = fopen(filename, "r")))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Cannot open metric file: '%s', container doesn't run", filename);
+                free(filename);
+                SET_UI64_RESULT(result, 0);
+                return SYSINFO_RET_OK;
+        }
+        zbx_fclose(file);
+        zabbix_log(LOG_LEVEL_DEBUG, "Can open metric file: '%s', container is running", filename);
+        free(filename);
+        SET_UI64_RESULT(result, 1);
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_blkio_parse                                           *
+ *                                                                            *
+ * Purpose: parse all device/operation values of blkio file                   *
+ *                                                                            *
+ * Parameters: blkio - parsed values                                          *
+ *             buffer - file content                                          *
+ *                                                                            *
+ * Notes: v1 '8:0 Read 1', '8:0 1' (single value files, e.g. blkio.sectors)  *
+ *        and 'Total 1'; v2 io.stat '8:0 rbytes=1 wbytes=2 ...'               *
+ ******************************************************************************/
+void    zbx_docker_blkio_parse(zbx_docker_blkio_t *blkio, char *buffer)
+{
+        zbx_docker_blkio_value_t        value;
+        char                            *line, *token, *eq, *end, *saveptr_line, *saveptr;
+        int                             dev;
+
+        blkio->values_num = 0;
+        for (line = strtok_r(buffer, "\n", &saveptr_line); NULL != line; line = strtok_r(NULL, "\n", &saveptr_line))
+        {
+                if (NULL == (token = strtok_r(line, " ", &saveptr)))
+                        continue;
+
+                memset(&value, 0, sizeof(value));
+                dev = (2 == sscanf(token, "%u:%u", &value.major, &value.minor));
+                if (1 == dev && NULL == (token = strtok_r(NULL, " ", &saveptr)))
+                        continue;
+
+                for (; NULL != token; token = strtok_r(NULL, " ", &saveptr))
+                {
+                        value.dev = dev;
+                        if (NULL != (eq = strchr(token, '=')))
+                        {
+                                // io.stat field
+                                zbx_strlcpy(value.op, token, MIN(sizeof(value.op), (size_t)(eq - token) + 1));
+                                token = eq + 1;
+                        }
+                        else if ('0' > *token || '9' < *token)
+                        {
+                                // operation name, the value is the next token
+                                zbx_strlcpy(value.op, token, sizeof(value.op));
+                                if (NULL == (token = strtok_r(NULL, " ", &saveptr)))
+                                        break;
+                        }
+
+                        value.value = strtoull(token, &end, 10);
+                        if (end == token)
+                                continue;
+
+                        if (blkio->values_num == blkio->values_alloc)
+                        {
+                                blkio->values_alloc = 0 == blkio->values_alloc ? 16 : blkio->values_alloc * 2;
+                                blkio->values = realloc(blkio->values, sizeof(zbx_docker_blkio_value_t) *
+                                                blkio->values_alloc);
+                        }
+                        blkio->values[blkio->values_num++] = value;
+                        value.op[0] = '\0';
+                }
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_blkio_get                                             *
+ *                                                                            *
+ * Purpose: get parsed blkio file, the file is read and parsed at most once   *
+ *          per ZBX_DOCKER_BLKIO_TTL for all devices and operations           *
+ *                                                                            *
+ * Return value: cached values, NULL - file cannot be read                    *
+ *                                                                            *
+ ******************************************************************************/
+zbx_docker_blkio_t      *zbx_docker_blkio_get(const char *filename)
+{
+        zbx_docker_blkio_t      *entry = &blkio_cache[zbx_docker_id_hash(filename) & (ZBX_DOCKER_BLKIO_SIZE - 1)];
+        zbx_uint64_t            now = zbx_docker_stats_time();
+        char                    *buffer = NULL;
+        int                     fd;
+        size_t                  len = 0, alloc = 0;
+        ssize_t                 n;
+
+        if (0 != entry->time_us && now - entry->time_us < ZBX_DOCKER_BLKIO_TTL && 0 == strcmp(entry->path, filename))
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_BLKIO, 1);
+                return entry;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_BLKIO, 0);
+
+        if (-1 == (fd = open(filename, O_RDONLY | O_CLOEXEC)))
+                return NULL;
+
+        // per-device files grow with number of devices
+        do
+        {
+                if (alloc - len < MAX_STRING_LEN)
+                {
+                        alloc += 4 * MAX_STRING_LEN;
+                        buffer = realloc(buffer, alloc);
+                }
+                n = read(fd, buffer + len, alloc - len - 1);
+                len += 0 < n ? (size_t)n : 0;
+        }
+        while (0 < n);
+        close(fd);
+
+        if (0 > n)
+        {
+                free(buffer);
+                return NULL;
+        }
+        buffer[len] = '\0';
+
+        zbx_docker_blkio_parse(entry, buffer);
+        free(buffer);
+        entry->path = zbx_strdup(entry->path, filename);
+        entry->time_us = now;
+
+        return entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_blkdev_name                                           *
+ *                                                                            *
+ * Purpose: get block device name of major:minor from /sys/dev/block          *
+ *                                                                            *
+ * Return value: device name (e.g. sda), NULL - unknown device                *
+ *                                                                            *
+ * Notes: names are cached for ZBX_DOCKER_BLKDEV_TTL seconds                  *
+ ******************************************************************************/
+const char      *zbx_docker_blkdev_name(unsigned int major, unsigned int minor)
+{
+        zbx_docker_blkdev_t     *entry = &blkdev_cache[(major * 256 + minor) & (ZBX_DOCKER_BLKDEV_SIZE - 1)];
+        time_t                  now = time(NULL);
+        char                    path[MAX_STRING_LEN], link[MAX_STRING_LEN], *name;
+        ssize_t                 len;
+
+        if (0 != entry->time && now - entry->time < ZBX_DOCKER_BLKDEV_TTL && major == entry->major &&
+                        minor == entry->minor)
+        {
+                return '\0' == entry->name[0] ? NULL : entry->name;
+        }
+
+        // /sys/dev/block/8:0 -> ../../devices/pci0000:00/.../block/sda
+        zbx_snprintf(path, sizeof(path), "%s/sys/dev/block/%u:%u", rootfs, major, minor);
+        entry->name[0] = '\0';
+        if (0 < (len = readlink(path, link, sizeof(link) - 1)))
+        {
+                link[len] = '\0';
+                name = strrchr(link, '/');
+                zbx_strlcpy(entry->name, NULL == name ? link : name + 1, sizeof(entry->name));
+        }
+        entry->major = major;
+        entry->minor = minor;
+        entry->time = now;
+
+        return '\0' == entry->name[0] ? NULL : entry->name;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_blkio_value                                           *
+ *                                                                            *
+ * Purpose: get value of parsed blkio file                                    *
+ *                                                                            *
+ * Parameters: blkio - parsed values                                          *
+ *             device - NULL - line without device (e.g. Total), 'total' -    *
+ *                      sum of all devices, '<major>:<minor>' or device name  *
+ *             op - operation/field, empty for single value files             *
+ *             value - result                                                 *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - value was not found                       *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_blkio_value(const zbx_docker_blkio_t *blkio, const char *device, const char *op,
+                zbx_uint64_t *value)
+{
+        const zbx_docker_blkio_value_t  *v;
+        const char                      *name;
+        unsigned int                    major = 0, minor = 0;
+        int                             i, total = 0, by_name = 0, ret = SYSINFO_RET_FAIL;
+
+        if (NULL != device)
+        {
+                if (0 == strcmp(device, "total"))
+                        total = 1;
+                else if (2 != sscanf(device, "%u:%u", &major, &minor))
+                        by_name = 1;
+        }
+
+        for (*value = 0, i = 0; i < blkio->values_num; i++)
+        {
+                v = &blkio->values[i];
+                if (0 != strcmp(v->op, op) || (NULL == device) == v->dev)
+                        continue;
+                if (0 == total && NULL != device)
+                {
+                        if (1 == by_name)
+                        {
+                                if (NULL == (name = zbx_docker_blkdev_name(v->major, v->minor)) ||
+                                                0 != strcmp(name, device))
+                                        continue;
+                        }
+                        else if (v->major != major || v->minor != minor)
+                                continue;
+                }
+
+                *value += v->value;
+                ret = SYSINFO_RET_OK;
+                if (0 == total)
+                        break;
+        }
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_dev                                            *
+ *                                                                            *
+ * Purpose: container device blkio metrics                                    *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: https://www.kernel.org/doc/Documentation/cgroups/blkio-controller.txt
+ *        docker.dev[cid,file,metric,<device>], device is 'total',            *
+ *        '<major>:<minor>' or device name; without device the metric is      *
+ *        '<major>:<minor> <operation>' or line without device (e.g. Total),  *
+ *        other operations are summed over all devices                        *
+ ******************************************************************************/
+int     zbx_module_docker_dev(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_dev()");
+        zbx_docker_blkio_t      *blkio;
+        zbx_uint64_t            value;
+        char                    *container, *metric, *device, *op, *dev = NULL;
+        int                     ret = SYSINFO_RET_FAIL;
+
+        if (3 > request->nparam || 4 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL)
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "docker.dev metrics are not available at the moment - no stat directory");
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.dev metrics are not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (0 == zbx_docker_container_live(container))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Container %s is not running", container);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not running"));
+                return SYSINFO_RET_FAIL;
+        }
+        char    *stat_file = zbx_dsprintf(NULL, "/%s", get_rparam(request, 1));
+        metric = get_rparam(request, 2);
+        device = get_rparam(request, 3);
+
+        char    *filename = zbx_docker_cgroup_path("blkio/", container, stat_file);
+        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
+        if (NULL == (blkio = zbx_docker_blkio_get(filename)))
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Cannot open metric file: '%s'", filename);
+                free(stat_file);
+                free(filename);
+                SET_MSG_RESULT(result, strdup("Cannot open stat file, maybe CONFIG_DEBUG_BLK_CGROUP is not enabled"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        zabbix_log(LOG_LEVEL_DEBUG, "Looking metric %s in blkio file", metric);
+        if (NULL != device && '\0' != *device)
+        {
+                ret = zbx_docker_blkio_value(blkio, device, metric, &value);
+        }
+        else if (NULL != (op = strchr(metric, ' ')))
+        {
+                // '<major>:<minor> <operation>'
+                dev = zbx_dsprintf(NULL, "%.*s", (int)(op - metric), metric);
+                ret = zbx_docker_blkio_value(blkio, dev, op + 1, &value);
+        }
+        else if (NULL != strchr(metric, ':'))
+        {
+                // '<major>:<minor>' of single value file
+                ret = zbx_docker_blkio_value(blkio, metric, "", &value);
+        }
+        else if (SYSINFO_RET_OK != (ret = zbx_docker_blkio_value(blkio, NULL, metric, &value)))
+        {
+                ret = zbx_docker_blkio_value(blkio, "total", metric, &value);
+        }
+
+        if (SYSINFO_RET_OK == ret)
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Id: %s; stat file: %s, metric: %s; value: " ZBX_FS_UI64, container, stat_file,
+                                metric, value);
+                SET_UI64_RESULT(result, value);
+        }
+
+        free(stat_file);
+        free(filename);
+        free(dev);
+
+        if (SYSINFO_RET_FAIL == ret)
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find a line with requested metric in blkio file"));
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_dev_discovery                                  *
+ *                                                                            *
+ * Purpose: block devices of the container                                    *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: docker.dev.discovery[cid,<file>], devices with values in the blkio  *
+ *        file, default blkio.throttle.io_service_bytes (v1) or io.stat (v2)  *
+ *        {"data":[{"{#DEVMAJMIN}":"8:0","{#DEVNAME}":"sda"},...]}            *
+ ******************************************************************************/
+int     zbx_module_docker_dev_discovery(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_dev_discovery()");
+        zbx_docker_blkio_t      *blkio;
+        char                    *container, *file, *filename, majmin[32];
+        const char              *name;
+        int                     i, j;
+
+        if (1 > request->nparam || 2 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL || (cpu_cgroup == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.dev.discovery is not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        file = get_rparam(request, 1);
+        if (NULL == file || '\0' == *file)
+                file = 1 == cgroup_v2 ? "io.stat" : "blkio.throttle.io_service_bytes";
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        filename = zbx_dsprintf(NULL, "/%s", file);
+        file = zbx_docker_cgroup_path("blkio/", container, filename);
+        free(filename);
+        blkio = zbx_docker_blkio_get(file);
+        free(file);
+        if (NULL == blkio)
+        {
+                SET_MSG_RESULT(result, strdup("Cannot open stat file, maybe CONFIG_DEBUG_BLK_CGROUP is not enabled"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        json_t *a = json_array();
+        for (i = 0; i < blkio->values_num; i++)
+        {
+                if (0 == blkio->values[i].dev)
+                        continue;
+                // values of one device are adjacent, device is listed once
+                for (j = 0; j < i && (blkio->values[j].major != blkio->values[i].major ||
+                                blkio->values[j].minor != blkio->values[i].minor); j++)
+                        ;
+                if (j < i)
+                        continue;
+
+                json_t *o = json_object();
+                zbx_snprintf(majmin, sizeof(majmin), "%u:%u", blkio->values[i].major, blkio->values[i].minor);
+                json_object_set_new(o, "{#DEVMAJMIN}", json_string(majmin));
+                name = zbx_docker_blkdev_name(blkio->values[i].major, blkio->values[i].minor);
+                json_object_set_new(o, "{#DEVNAME}", json_string(NULL == name ? majmin : name));
+                json_array_append_new(a, o);
+        }
+
+        json_t *j_data = json_object();
+        json_object_set_new(j_data, "data", a);
+        SET_STR_RESULT(result, json_dumps(j_data, 0));
+        json_decref(j_data);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_blkio_file_value                                      *
+ *                                                                            *
+ * Purpose: get value of blkio file of the container                          *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - file cannot be read or value was not      *
+ *                                  found                                     *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_blkio_file_value(const char *container, const char *file, const char *device, const char *op,
+                zbx_uint64_t *value)
+{
+        zbx_docker_blkio_t      *blkio;
+        char                    *filename = zbx_docker_cgroup_path("blkio/", container, file);
+
+        blkio = zbx_docker_blkio_get(filename);
+        free(filename);
+
+        return NULL == blkio ? SYSINFO_RET_FAIL : zbx_docker_blkio_value(blkio, device, op, value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_dev_latency                                    *
+ *                                                                            *
+ * Purpose: container block I/O latency and queue                             *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: docker.dev.latency[cid,<await|svctm|wait|queued|pressure>,          *
+ *        <read|write|total>,<device>]                                        *
+ *        v1 - average ms per operation since the previous call from          *
+ *        blkio.io_service_time, blkio.io_wait_time and blkio.io_serviced     *
+ *        (CFQ/BFQ scheduler), queued operations from blkio.io_queued         *
+ *        v2 - await is avg_lat of io.stat (io.latency target must be set),   *
+ *        pressure is io.pressure some avg10 (% of time)                      *
+ ******************************************************************************/
+int     zbx_module_docker_dev_latency(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_dev_latency()");
+        char            *container, *metric, *op, *device;
+        zbx_uint64_t    ios, service = 0, wait = 0, hash;
+        double          ios_rate, service_rate = 0, wait_rate = 0;
+        int             ret = SYSINFO_RET_FAIL;
+
+        if (1 > request->nparam || 4 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL || (cpu_cgroup == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.dev.latency is not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        metric = get_rparam(request, 1);
+        if (NULL == metric || '\0' == *metric)
+                metric = "await";
+        op = get_rparam(request, 2);
+        if (NULL == op || '\0' == *op || 0 == strcmp(op, "total"))
+                op = "Total";
+        else if (0 == strcmp(op, "read"))
+                op = "Read";
+        else if (0 == strcmp(op, "write"))
+                op = "Write";
+        else
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+        device = get_rparam(request, 3);
+        if (NULL == device || '\0' == *device)
+                device = "total";
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+
+        if (0 == strcmp(metric, "pressure"))
+        {
+                double  values[ZBX_DOCKER_PRESSURE_COUNT];
+
+                if (NULL == cpu_cgroup && SYSINFO_RET_FAIL == zbx_docker_dir_detect())
+                {
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.dev.latency is not available at the moment - no cpu_cgroup directory"));
+                        return SYSINFO_RET_FAIL;
+                }
+                zbx_docker_pressure_read(container, values);
+                if (0 > values[zbx_docker_pressure_index("io", "some", "avg10")])
+                {
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read io.pressure file"));
+                        return SYSINFO_RET_FAIL;
+                }
+                SET_DBL_RESULT(result, values[zbx_docker_pressure_index("io", "some", "avg10")]);
+                return SYSINFO_RET_OK;
+        }
+
+        if (1 == cgroup_v2)
+        {
+                zbx_docker_blkio_t      *blkio;
+                zbx_uint64_t            lat, lat_sum = 0;
+                int                     devices = 0, i;
+                char                    *filename;
+
+                if (0 != strcmp(metric, "await"))
+                {
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "Metric is not available on cgroup v2, use await or pressure"));
+                        return SYSINFO_RET_FAIL;
+                }
+
+                // io.latency: '8:0 rbytes=... depth=1 avg_lat=500 win=100', avg_lat in usec, reads and writes
+                filename = zbx_docker_cgroup_path("", container, "/io.stat");
+                blkio = zbx_docker_blkio_get(filename);
+                free(filename);
+                if (NULL != blkio && 0 == strcmp(device, "total"))
+                {
+                        for (i = 0; i < blkio->values_num; i++)
+                        {
+                                if (1 == blkio->values[i].dev && 0 == strcmp(blkio->values[i].op, "avg_lat"))
+                                {
+                                        lat_sum += blkio->values[i].value;
+                                        devices++;
+                                }
+                        }
+                        ret = 0 < devices ? SYSINFO_RET_OK : SYSINFO_RET_FAIL;
+                        lat = 0 < devices ? lat_sum / devices : 0;
+                }
+                else if (NULL != blkio)
+                        ret = zbx_docker_blkio_value(blkio, device, "avg_lat", &lat);
+
+                if (SYSINFO_RET_OK != ret)
+                {
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find avg_lat in io.stat file, io.latency target is not set"));
+                        return SYSINFO_RET_FAIL;
+                }
+                SET_DBL_RESULT(result, (double)lat / 1000);
+                return SYSINFO_RET_OK;
+        }
+
+        if (0 == strcmp(metric, "queued"))
+        {
+                ret = zbx_docker_blkio_file_value(container, "/blkio.io_queued", device, op, &ios);
+                if (SYSINFO_RET_OK != ret)
+                {
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find requested value in blkio.io_queued file"));
+                        return SYSINFO_RET_FAIL;
+                }
+                SET_UI64_RESULT(result, ios);
+                return SYSINFO_RET_OK;
+        }
+
+        if (0 != strcmp(metric, "await") && 0 != strcmp(metric, "svctm") && 0 != strcmp(metric, "wait"))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        // ns of all completed operations, they are available only with CFQ/BFQ I/O scheduler
+        if (SYSINFO_RET_OK == (ret = zbx_docker_blkio_file_value(container, "/blkio.io_serviced", device, op, &ios)) &&
+                        0 != strcmp(metric, "wait"))
+        {
+                ret = zbx_docker_blkio_file_value(container, "/blkio.io_service_time", device, op, &service);
+        }
+        if (SYSINFO_RET_OK == ret && 0 != strcmp(metric, "svctm"))
+                ret = zbx_docker_blkio_file_value(container, "/blkio.io_wait_time", device, op, &wait);
+
+        if (SYSINFO_RET_OK != ret)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find requested value in blkio.io_serviced/io_service_time/io_wait_time files, maybe CFQ or BFQ scheduler is not used"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        // all counters are sampled at the same time, so they cover the same interval, all are stored on failure
+        hash = zbx_docker_rate_hash(request);
+        ret = zbx_docker_rate_sample(hash, ios, &ios_rate, result);
+        if (SYSINFO_RET_OK != zbx_docker_rate_sample(hash ^ __UINT64_C(0x9e3779b97f4a7c15), service, &service_rate,
+                        result))
+        {
+                ret = SYSINFO_RET_FAIL;
+        }
+        if (SYSINFO_RET_OK != zbx_docker_rate_sample(hash ^ __UINT64_C(0x7f4a7c159e3779b9), wait, &wait_rate, result))
+                ret = SYSINFO_RET_FAIL;
+        if (SYSINFO_RET_OK != ret)
+                return SYSINFO_RET_FAIL;
+
+        SET_DBL_RESULT(result, 0 < ios_rate ? (service_rate + wait_rate) / ios_rate / 1000000 : 0);
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_mem_metric_v2                                         *
+ *                                                                            *
+ * Purpose: translate cgroup v1 memory.stat metric name to cgroup v2 name     *
+ *                                                                            *
+ * Return value: cgroup v2 memory.stat metric name                            *
+ *                                                                            *
+ * Notes: v2 memory.stat is always hierarchical, so total_ prefix is removed  *
+ *        https://www.kernel.org/doc/Documentation/admin-guide/cgroup-v2.rst  *
+ ******************************************************************************/
+char    *zbx_docker_mem_metric_v2(char *metric)
+{
+        char *aliases[][2] = {
+            {"rss", "anon"},
+            {"cache", "file"},
+            {"mapped_file", "file_mapped"},
+            {"dirty", "file_dirty"},
+            {"writeback", "file_writeback"},
+            {"rss_huge", "anon_thp"},
+            {NULL, NULL}
+        };
+        int i;
+
+        if (strncmp(metric, "total_", strlen("total_")) == 0)
+        {
+            metric += strlen("total_");
+        }
+        for (i = 0; aliases[i][0] != NULL; i++)
+        {
+            if (strcmp(metric, aliases[i][0]) == 0)
+            {
+                return aliases[i][1];
+            }
+        }
+        return metric;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_read                                             *
+ *                                                                            *
+ * Purpose: zbx_docker_scan_file() which logs files too big for the scanner   *
+ *                                                                            *
+ * Parameters: scan - [OUT] scanned lines                                     *
+ *             path - [IN] stat file path                                     *
+ *                                                                            *
+ * Return value: number of lines, -1 - file cannot be read or is too big      *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_scan_read(zbx_docker_scan_t *scan, const char *path)
+{
+        int     ret;
+
+        if (0 > (ret = zbx_docker_scan_file(scan, path)) && EFBIG == errno)
+                zabbix_log(LOG_LEVEL_WARNING, "Cannot scan %s: file is bigger than %d bytes or %d lines",
+                                path, ZBX_DOCKER_SCAN_SIZE - 1, ZBX_DOCKER_SCAN_LINES);
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_mem                                            *
+ *                                                                            *
+ * Purpose: container memory metrics                                          *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: https://www.kernel.org/doc/Documentation/cgroups/memory.txt         *
+ ******************************************************************************/
+int     zbx_module_docker_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_mem()");
+        char    *container, *metric;
+        int     ret = SYSINFO_RET_FAIL;
+
+        if (2 != request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL)
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "docker.mem metrics are not available at the moment - no stat directory");
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.mem metrics are not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (0 == zbx_docker_container_live(container))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Container %s is not running", container);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not running"));
+                return SYSINFO_RET_FAIL;
+        }
+        metric = get_rparam(request, 1);
+        if (1 == cgroup_v2)
+        {
+            metric = zbx_docker_mem_metric_v2(metric);
+        }
+        char    *filename = zbx_docker_cgroup_path("memory/", container, "/memory.stat");
+        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
+        zbx_docker_scan_t       scan;
+        if (0 > zbx_docker_scan_read(&scan, filename))
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Cannot open metric file: '%s'", filename);
+                free(filename);
+                SET_MSG_RESULT(result, strdup("Cannot open memory.stat file"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        zbx_uint64_t    value = 0;
+        zabbix_log(LOG_LEVEL_DEBUG, "Looking metric %s in memory.stat file", metric);
+        if (1 == zbx_docker_scan_value(&scan, metric, &value))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Id: %s; metric: %s; value: %lu", container, metric, value);
+                SET_UI64_RESULT(result, value);
+                ret = SYSINFO_RET_OK;
+        }
+
+        free(filename);
+
+        if (SYSINFO_RET_FAIL == ret)
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find a line with requested metric in memory.stat file"));
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cpuset_parse                                          *
+ *                                                                            *
+ * Purpose: call function for every range of cpuset list, e.g. "0-3,8,10-11" *
+ *          of cpuset.cpus, cpuset.mems or NUMA node cpulist                  *
+ *                                                                            *
+ * Parameters: list - cpuset list                                             *
+ *             range - function called with the first and the last number of  *
+ *                     the range and arg, non-zero value stops parsing        *
+ *             arg - argument of range function                               *
+ *                                                                            *
+ * Return value: non-zero value returned by range function, 0 - whole list    *
+ *               was parsed                                                   *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_cpuset_parse(const char *list, int (*range)(unsigned long, unsigned long, void *), void *arg)
+{
+        unsigned long   first, last;
+        char            *end;
+        int             ret;
+
+        while ('\0' != *list && '\n' != *list)
+        {
+                first = last = strtoul(list, &end, 10);
+                if (end == list)
+                        break;
+                if ('-' == *end)
+                {
+                        list = end + 1;
+                        last = strtoul(list, &end, 10);
+                }
+                if (0 != (ret = range(first, last, arg)))
+                        return ret;
+                if (',' != *end)
+                        break;
+                list = end + 1;
+        }
+
+        return 0;
+}
+
+// range function of zbx_docker_cpuset_has()
+int     zbx_docker_cpuset_has_range(unsigned long first, unsigned long last, void *arg)
+{
+        unsigned long   n = *(unsigned long *)arg;
+
+        return n >= first && n <= last;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cpuset_has                                            *
+ *                                                                            *
+ * Purpose: check if cpuset list (e.g. "0-3,8,10-11") contains the number     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_cpuset_has(const char *list, unsigned long n)
+{
+        return zbx_docker_cpuset_parse(list, zbx_docker_cpuset_has_range, &n);
+}
+
+// range function of zbx_docker_numa_local() - some CPU of the node range is in the container cpuset (arg)
+int     zbx_docker_numa_cpus_range(unsigned long first, unsigned long last, void *arg)
+{
+        unsigned long   cpu;
+
+        for (cpu = first; cpu <= last; cpu++)
+        {
+                if (1 == zbx_docker_cpuset_has((const char *)arg, cpu))
+                        return 1;
+        }
+
+        return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_numa_local                                            *
+ *                                                                            *
+ * Purpose: get mask of local NUMA nodes of the container                     *
+ *                                                                            *
+ * Return value: nodes of cpuset.mems which have some CPU of cpuset.cpus,     *
+ *               all nodes of cpuset.mems if no node has CPU of the container *
+ *               or node CPU lists are not available, 0 - unknown             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t    zbx_docker_numa_local(const char *container)
+{
+        char            *filename, mems[MAX_STRING_LEN], cpus[MAX_STRING_LEN], node_cpus[MAX_STRING_LEN];
+        zbx_uint64_t    nodes = 0, local = 0;
+        unsigned long   node;
+
+        filename = zbx_docker_cgroup_path("cpuset/", container, 1 == cgroup_v2 ? "/cpuset.mems.effective" :
+                        "/cpuset.mems");
+        if (0 >= zbx_docker_read_file(filename, mems, sizeof(mems)))
+                mems[0] = '\0';
+        free(filename);
+        filename = zbx_docker_cgroup_path("cpuset/", container, 1 == cgroup_v2 ? "/cpuset.cpus.effective" :
+                        "/cpuset.cpus");
+        if (0 >= zbx_docker_read_file(filename, cpus, sizeof(cpus)))
+                cpus[0] = '\0';
+        free(filename);
+
+        for (node = 0; node < ZBX_DOCKER_NUMA_NODES; node++)
+        {
+                if (0 == zbx_docker_cpuset_has(mems, node))
+                        continue;
+                nodes |= (zbx_uint64_t)1 << node;
+
+                filename = zbx_dsprintf(NULL, "%s/sys/devices/system/node/node%lu/cpulist", rootfs, node);
+                if (0 >= zbx_docker_read_file(filename, node_cpus, sizeof(node_cpus)))
+                        node_cpus[0] = '\0';
+                free(filename);
+
+                // CPU ranges of the node are checked against the container cpuset
+                if (1 == zbx_docker_cpuset_parse(node_cpus, zbx_docker_numa_cpus_range, cpus))
+                        local |= (zbx_uint64_t)1 << node;
+        }
+
+        return 0 != local ? local : nodes;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_numa_read                                             *
+ *                                                                            *
+ * Purpose: read per-node memory of the container from memory.numa_stat       *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - file cannot be read                       *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: v1 'total=<pages> N0=<pages> N1=<pages>', v2 'anon N0=<bytes> ...'  *
+ *        (v2 total is anon + file), all values are converted to bytes;       *
+ *        the file is parsed by the scanner of docker.mem at most once per    *
+ *        ZBX_DOCKER_NUMA_TTL, local nodes are cached until the cpuset cgroup *
+ *        directory is recreated (container restart), as CPU limits           *
+ ******************************************************************************/
+int     zbx_docker_numa_read(const char *container, zbx_docker_numa_t *numa)
+{
+        zbx_docker_numa_cache_t *entry = &numa_cache[zbx_docker_id_hash(container) & (ZBX_DOCKER_NUMA_SIZE - 1)];
+        zbx_docker_scan_t       scan;
+        zbx_stat_t              sb;
+        const char              *s, *end;
+        char                    *filename, *next;
+        zbx_uint64_t            value, now = zbx_docker_stats_time(), local = 0;
+        unsigned long           node;
+        int                     i, metric, cached;
+        size_t                  key_len;
+
+        cached = 0 == strcmp(entry->id, container);
+        if (1 == cached && 0 != entry->time_us && now - entry->time_us < ZBX_DOCKER_NUMA_TTL)
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_NUMA, 1);
+                *numa = entry->numa;
+                return SYSINFO_RET_OK;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_NUMA, 0);
+
+        memset(numa, 0, sizeof(zbx_docker_numa_t));
+        filename = zbx_docker_cgroup_path("memory/", container, "/memory.numa_stat");
+        if (0 > zbx_docker_scan_read(&scan, filename))
+        {
+                free(filename);
+                return SYSINFO_RET_FAIL;
+        }
+        free(filename);
+
+        for (i = 0; i < scan.lines_num; i++)
+        {
+                // v1 key is '<name>=<total>'
+                for (key_len = 0; key_len < scan.lines[i].key_len && '=' != scan.lines[i].key[key_len]; key_len++)
+                        ;
+                for (metric = 0; metric < ZBX_DOCKER_NUMA_METRICS; metric++)
+                {
+                        if (strlen(numa_metrics[metric]) == key_len &&
+                                        0 == memcmp(scan.lines[i].key, numa_metrics[metric], key_len))
+                                break;
+                }
+                if (ZBX_DOCKER_NUMA_METRICS == metric)
+                        continue;
+
+                for (s = scan.lines[i].value, end = s + scan.lines[i].value_len; s < end; s = next)
+                {
+                        if ('N' != *s)
+                                break;
+                        node = strtoul(s + 1, &next, 10);
+                        if ('=' != *next || ZBX_DOCKER_NUMA_NODES <= node)
+                                break;
+                        value = strtoull(next + 1, &next, 10);
+                        numa->values[node][metric] = 1 == cgroup_v2 ? value : value * page_size;
+                        numa->nodes |= (zbx_uint64_t)1 << node;
+                        while (next < end && ' ' == *next)
+                                next++;
+                }
+        }
+
+        if (1 == cgroup_v2)
+        {
+                for (node = 0; node < ZBX_DOCKER_NUMA_NODES; node++)
+                {
+                        numa->values[node][ZBX_DOCKER_NUMA_TOTAL] = numa->values[node][ZBX_DOCKER_NUMA_FILE] +
+                                        numa->values[node][ZBX_DOCKER_NUMA_ANON];
+                }
+        }
+        filename = zbx_docker_cgroup_path("cpuset/", container, "");
+        if (0 != zbx_stat(filename, &sb))
+                sb.st_ino = 0;
+        free(filename);
+        if (1 == cached && 0 != sb.st_ino && entry->ino == sb.st_ino)
+                local = entry->numa.local;
+        numa->local = 0 != local ? local : zbx_docker_numa_local(container);
+
+        // too long ids (cgroup directory names) are not cached
+        zbx_strlcpy(entry->id, container, sizeof(entry->id));
+        entry->time_us = strlen(container) < sizeof(entry->id) ? now : 0;
+        entry->ino = sb.st_ino;
+        entry->numa = *numa;
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_numa_sum                                              *
+ *                                                                            *
+ * Purpose: sum of the metric over NUMA nodes in the mask                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t    zbx_docker_numa_sum(const zbx_docker_numa_t *numa, zbx_uint64_t mask, int metric)
+{
+        zbx_uint64_t    sum = 0;
+        int             node;
+
+        for (node = 0; node < ZBX_DOCKER_NUMA_NODES; node++)
+        {
+                if (0 != (mask & numa->nodes & ((zbx_uint64_t)1 << node)))
+                        sum += numa->values[node][metric];
+        }
+
+        return sum;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_numa_locality                                         *
+ *                                                                            *
+ * Purpose: % of container memory on local NUMA nodes                         *
+ *                                                                            *
+ ******************************************************************************/
+double  zbx_docker_numa_locality(const zbx_docker_numa_t *numa)
+{
+        zbx_uint64_t    all = zbx_docker_numa_sum(numa, ~(zbx_uint64_t)0, ZBX_DOCKER_NUMA_TOTAL);
+
+        if (0 == all || 0 == numa->local)
+                return 100;
+
+        return (double)zbx_docker_numa_sum(numa, numa->local, ZBX_DOCKER_NUMA_TOTAL) * 100 / all;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_numa                                           *
+ *                                                                            *
+ * Purpose: container memory per NUMA node                                    *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: docker.numa[cid,<node>,<total|file|anon|locality>], node is number, *
+ *        local, remote or all; locality is % of memory on local nodes        *
+ ******************************************************************************/
+int     zbx_module_docker_numa(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_numa()");
+        zbx_docker_numa_t       numa;
+        zbx_uint64_t            mask;
+        char                    *container, *node, *metric, *end;
+        unsigned long           n;
+        int                     m;
+
+        if (1 > request->nparam || 3 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL || (cpu_cgroup == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.numa metrics are not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        node = get_rparam(request, 1);
+        if (NULL == node || '\0' == *node)
+                node = "all";
+        metric = get_rparam(request, 2);
+        if (NULL == metric || '\0' == *metric)
+                metric = "total";
+        for (m = 0; m < ZBX_DOCKER_NUMA_METRICS && 0 != strcmp(numa_metrics[m], metric); m++)
+                ;
+        if (ZBX_DOCKER_NUMA_METRICS == m && 0 != strcmp(metric, "locality"))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (SYSINFO_RET_OK != zbx_docker_numa_read(container, &numa))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read memory.numa_stat file"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (ZBX_DOCKER_NUMA_METRICS == m)
+        {
+                SET_DBL_RESULT(result, zbx_docker_numa_locality(&numa));
+                return SYSINFO_RET_OK;
+        }
+
+        if (0 == strcmp(node, "all"))
+                mask = ~(zbx_uint64_t)0;
+        else if (0 == strcmp(node, "local"))
+                mask = numa.local;
+        else if (0 == strcmp(node, "remote"))
+                mask = ~numa.local;
+        else
+        {
+                n = strtoul('N' == *node ? node + 1 : node, &end, 10);
+                if ('\0' != *end || ZBX_DOCKER_NUMA_NODES <= n || 0 == (numa.nodes & ((zbx_uint64_t)1 << n)))
+                {
+                        SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid NUMA node"));
+                        return SYSINFO_RET_FAIL;
+                }
+                mask = (zbx_uint64_t)1 << n;
+        }
+
+        SET_UI64_RESULT(result, zbx_docker_numa_sum(&numa, mask, m));
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_numa_bulk_add                                         *
+ *                                                                            *
+ * Purpose: enumeration callback, add NUMA memory of the container to JSON    *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_numa_bulk_add(const char *container, void *arg)
+{
+        zbx_docker_numa_t       numa;
+        char                    name[32];
+        int                     node, m;
+
+        if (SYSINFO_RET_OK != zbx_docker_numa_read(container, &numa))
+                return;
+
+        json_t *o = json_object();
+        json_t *nodes = json_object();
+        for (node = 0; node < ZBX_DOCKER_NUMA_NODES; node++)
+        {
+                if (0 == (numa.nodes & ((zbx_uint64_t)1 << node)))
+                        continue;
+                json_t *n = json_object();
+                for (m = 0; m < ZBX_DOCKER_NUMA_METRICS; m++)
+                        json_object_set_new(n, numa_metrics[m], json_integer(numa.values[node][m]));
+                json_object_set_new(n, "local", 0 != (numa.local & ((zbx_uint64_t)1 << node)) ? json_true() :
+                                json_false());
+                zbx_snprintf(name, sizeof(name), "%d", node);
+                json_object_set_new(nodes, name, n);
+        }
+        json_object_set_new(o, "nodes", nodes);
+        json_object_set_new(o, "locality", json_real(zbx_docker_numa_locality(&numa)));
+        json_object_set_new((json_t *)arg, container, o);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_numa_bulk                                      *
+ *                                                                            *
+ * Purpose: NUMA memory of all running containers in one value                *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: JSON {"<full container id>":{"nodes":{"0":{"total":N,"file":N,      *
+ *        "anon":N,"local":true},...},"locality":N},...}                      *
+ ******************************************************************************/
+int     zbx_module_docker_numa_bulk(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_numa_bulk()");
+
+        json_t *j = json_object();
+        if (SYSINFO_RET_OK != zbx_docker_containers_enum(zbx_docker_numa_bulk_add, j))
+        {
+                json_decref(j);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.numa.bulk is not available at the moment - containers cannot be enumerated"));
+                return SYSINFO_RET_FAIL;
+        }
+        SET_STR_RESULT(result, json_dumps(j, 0));
+        json_decref(j);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_cpu                                            *
+ *                                                                            *
+ * Purpose: container CPU metrics                                             *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: https://www.kernel.org/doc/Documentation/cgroups/cpuacct.txt        *
+ ******************************************************************************/
+int     zbx_module_docker_cpu(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_cpu()");
+
+        char    *container, *metric;
+        int     ret = SYSINFO_RET_FAIL;
+
+        if (2 != request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL)
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "docker.cpu metrics are not available at the moment - no stat directory");
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.cpu metrics are not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if(cpu_cgroup == NULL)
+        {
+                if (zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
+                {
                     zabbix_log(LOG_LEVEL_DEBUG, "docker.cpu check is not available at the moment - no cpu_cgroup directory");
                     SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.cpu check is not available at the moment - no cpu_cgroup directory"));
                     return SYSINFO_RET_FAIL;
                 }
         }
 
-        container = zbx_module_docker_get_fci(get_rparam(request, 0));
-        metric = get_rparam(request, 1);
-        char    *cgroup = NULL, *stat_file = NULL;
-        if(strcmp(metric, "user") == 0 || strcmp(metric, "system") == 0 || strcmp(metric, "total") == 0) {
-            stat_file = "/cpuacct.stat";
-            cgroup = cpu_cgroup;
-        } else {
-            stat_file = "/cpu.stat";
-            if (strchr(cpu_cgroup, ',') != NULL) {
-                cgroup = cpu_cgroup;
-            } else {
-                cgroup = "cpu/";
-            }
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (0 == zbx_docker_container_live(container))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Container %s is not running", container);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not running"));
+                return SYSINFO_RET_FAIL;
+        }
+        metric = get_rparam(request, 1);
+
+        // high precision counters in ns
+        if (0 == strcmp(metric, "usage") || 0 == strcmp(metric, "usage_user") || 0 == strcmp(metric, "usage_system"))
+        {
+                zbx_uint64_t    usage;
+
+                if (SYSINFO_RET_OK != (ret = zbx_docker_cpu_usage(container, metric, &usage)))
+                        SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot read CPU %s counter", metric));
+                else
+                        SET_UI64_RESULT(result, usage);
+                return ret;
+        }
+
+        char    *cgroup = NULL, *stat_file = NULL;
+        int     ticks = (strcmp(metric, "user") == 0 || strcmp(metric, "system") == 0 || strcmp(metric, "total") == 0);
+        if (1 == cgroup_v2) {
+            // cgroup v2 has only cpu.stat with usec values
+            stat_file = "/cpu.stat";
+            cgroup = cpu_cgroup;
+        } else if (ticks) {
+            stat_file = "/cpuacct.stat";
+            cgroup = cpu_cgroup;
+        } else {
+            stat_file = "/cpu.stat";
+            if (strchr(cpu_cgroup, ',') != NULL) {
+                cgroup = cpu_cgroup;
+            } else {
+                cgroup = "cpu/";
+            }
+        }
+        char    *filename = zbx_docker_cgroup_path(cgroup, container, stat_file);
+        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
+        zbx_docker_scan_t       scan;
+        if (0 > zbx_docker_scan_read(&scan, filename))
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Cannot open metric file: '%s'", filename);
+                free(filename);
+                SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot open %s file", ++stat_file));
+                return SYSINFO_RET_FAIL;
+        }
+
+        char    *metric2;
+        if (1 == cgroup_v2 && ticks) {
+            metric2 = zbx_docker_arena_dsprintf("%s_usec", metric);
+        } else if (1 == cgroup_v2 && strcmp(metric, "throttled_time") == 0) {
+            metric2 = "throttled_usec";
+        } else {
+            metric2 = metric;
+        }
+        zbx_uint64_t    value = 0;
+        zbx_uint64_t    result_value = 0;
+        zabbix_log(LOG_LEVEL_DEBUG, "Looking metric %s in cpuacct.stat/cpu.stat file", metric);
+        if (0 == strcmp("total", metric)) {
+                // sum of user and system time
+                if (1 == zbx_docker_scan_value(&scan, 1 == cgroup_v2 ? "user_usec" : "user", &value)) {
+                        result_value += value;
+                        ret = SYSINFO_RET_OK;
+                }
+                if (1 == zbx_docker_scan_value(&scan, 1 == cgroup_v2 ? "system_usec" : "system", &value)) {
+                        result_value += value;
+                        ret = SYSINFO_RET_OK;
+                }
+        } else if (1 == zbx_docker_scan_value(&scan, metric2, &value)) {
+                result_value = value;
+                ret = SYSINFO_RET_OK;
+        }
+
+        free(filename);
+
+        if (SYSINFO_RET_FAIL == ret) {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find a line with requested metric in cpuacct.stat/cpu.stat file"));
+        } else {
+                // cgroup v2 - usec values are converted to v1 units (USER_HZ ticks, ns)
+                if (1 == cgroup_v2 && ticks)
+                {
+                        result_value /= 1000000 / clk_tck;
+                } else if (1 == cgroup_v2 && strcmp(metric, "throttled_time") == 0) {
+                        result_value *= 1000;
+                }
+                // normalize CPU usage by using number of online CPUs - only tick metrics
+                if (ticks && 1 < cpu_online)
+                {
+                        result_value /= cpu_online;
+                }
+
+                zabbix_log(LOG_LEVEL_DEBUG, "Id: %s; metric: %s; value: %lu", container, metric, result_value);
+                SET_UI64_RESULT(result, result_value);
+        }
+
+        return ret;
+}
+
+// range function of zbx_docker_cpuset_count()
+int     zbx_docker_cpuset_count_range(unsigned long first, unsigned long last, void *arg)
+{
+        if (last >= first)
+                *(int *)arg += last - first + 1;
+
+        return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cpuset_count                                          *
+ *                                                                            *
+ * Purpose: number of CPUs in cpuset list, e.g. "0-3,8,10-11"                 *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_cpuset_count(const char *list)
+{
+        int     count = 0;
+
+        zbx_docker_cpuset_parse(list, zbx_docker_cpuset_count_range, &count);
+
+        return count;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cpu_limit                                             *
+ *                                                                            *
+ * Purpose: CPU entitlement of the container - the lowest of CFS quota/period,*
+ *          number of CPUs in cpuset and number of online CPUs                *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - container cgroup was not found            *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: limits are cached and re-read only when the cgroup directory is     *
+ *        recreated (container restart), update of running container (docker *
+ *        update) is applied after restart                                    *
+ ******************************************************************************/
+int     zbx_docker_cpu_limit(const char *container, double *cpus)
+{
+        zbx_docker_limits_t     *entry = &limits[zbx_docker_id_hash(container) & (ZBX_DOCKER_LIMITS_SIZE - 1)];
+        zbx_stat_t              sb;
+        char                    *filename, buffer[MAX_STRING_LEN], quota_str[32];
+        long long               quota = -1, period = 0;
+        int                     count;
+
+        filename = zbx_docker_cgroup_path(cpu_cgroup, container, "");
+        if (0 != zbx_stat(filename, &sb))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Cannot stat cgroup directory: '%s'", filename);
+                free(filename);
+                return SYSINFO_RET_FAIL;
+        }
+        free(filename);
+
+        if (entry->ino == sb.st_ino && 0 == strcmp(entry->id, container))
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_CPU_LIMITS, 1);
+                *cpus = entry->cpus;
+                return SYSINFO_RET_OK;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_CPU_LIMITS, 0);
+
+        *cpus = cpu_online;
+
+        filename = zbx_docker_cgroup_path("cpuset/", container, 1 == cgroup_v2 ? "/cpuset.cpus.effective" : "/cpuset.cpus");
+        if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)) && 0 < (count = zbx_docker_cpuset_count(buffer)) &&
+                        count < *cpus)
+        {
+                *cpus = count;
+        }
+        free(filename);
+
+        if (1 == cgroup_v2)
+        {
+                // cpu.max: "<quota|max> <period>"
+                filename = zbx_docker_cgroup_path("", container, "/cpu.max");
+                if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)) &&
+                                2 == sscanf(buffer, "%31s %lld", quota_str, &period) && 0 != strcmp(quota_str, "max"))
+                {
+                        quota = atoll(quota_str);
+                }
+                free(filename);
+        }
+        else
+        {
+                char    *cgroup = NULL != strchr(cpu_cgroup, ',') ? cpu_cgroup : "cpu/";
+
+                filename = zbx_docker_cgroup_path(cgroup, container, "/cpu.cfs_quota_us");
+                if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)))
+                        quota = atoll(buffer);
+                free(filename);
+                filename = zbx_docker_cgroup_path(cgroup, container, "/cpu.cfs_period_us");
+                if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)))
+                        period = atoll(buffer);
+                free(filename);
+        }
+        if (0 < quota && 0 < period && (double)quota / period < *cpus)
+                *cpus = (double)quota / period;
+
+        zabbix_log(LOG_LEVEL_DEBUG, "Id: %s; CPU limit: %f", container, *cpus);
+        if (strlen(container) < sizeof(entry->id))
+        {
+                zbx_strlcpy(entry->id, container, sizeof(entry->id));
+                entry->ino = sb.st_ino;
+                entry->cpus = *cpus;
+        }
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cpu_usage                                             *
+ *                                                                            *
+ * Purpose: read high precision cumulative CPU time of the container          *
+ *                                                                            *
+ * Parameters: container - full container id                                 *
+ *             metric - usage (user + system), usage_user or usage_system     *
+ *             usage - CPU time in ns                                         *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - counter cannot be read                    *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: cgroup v1 cpuacct.usage* files are in ns, v2 cpu.stat *_usec values *
+ *        are in usec; USER_HZ ticks of cpuacct.stat are not used; all three  *
+ *        counters are read at most once per ZBX_DOCKER_CPU_USAGE_TTL         *
+ ******************************************************************************/
+int     zbx_docker_cpu_usage(const char *container, const char *metric, zbx_uint64_t *usage)
+{
+        zbx_docker_cpu_usage_t  *entry = &cpu_usage_cache[zbx_docker_id_hash(container) &
+                                        (ZBX_DOCKER_CPU_USAGE_SIZE - 1)];
+        zbx_uint64_t            now = zbx_docker_stats_time();
+        char                    *filename, buffer[64];
+        int                     i, index = ZBX_DOCKER_CPU_USAGE;
+
+        if (0 == strcmp(metric, "usage_user"))
+                index = ZBX_DOCKER_CPU_USAGE_USER;
+        else if (0 == strcmp(metric, "usage_system"))
+                index = ZBX_DOCKER_CPU_USAGE_SYSTEM;
+
+        if (0 != entry->time_us && now - entry->time_us < ZBX_DOCKER_CPU_USAGE_TTL && 0 == strcmp(entry->id, container))
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_CPU_USAGE, 1);
+                *usage = entry->values[index];
+                return 1 == entry->has[index] ? SYSINFO_RET_OK : SYSINFO_RET_FAIL;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_CPU_USAGE, 0);
+
+        memset(entry->has, 0, sizeof(entry->has));
+        if (1 == cgroup_v2)
+        {
+                zbx_docker_scan_t       scan;
+                const int               ids[ZBX_DOCKER_CPU_USAGE_COUNT] = {ZBX_DOCKER_STAT_USAGE_USEC,
+                                                ZBX_DOCKER_STAT_USER_USEC, ZBX_DOCKER_STAT_SYSTEM_USEC};
+
+                filename = zbx_docker_cgroup_path(cpu_cgroup, container, "/cpu.stat");
+                if (0 <= zbx_docker_scan_read(&scan, filename))
+                {
+                        for (i = 0; i < ZBX_DOCKER_CPU_USAGE_COUNT; i++)
+                        {
+                                if (1 == (entry->has[i] = zbx_docker_scan_has(&scan, ids[i])))
+                                        entry->values[i] = scan.values[ids[i]] * 1000;
+                        }
+                }
+                free(filename);
+        }
+        else
+        {
+                const char      *files[ZBX_DOCKER_CPU_USAGE_COUNT] = {"/cpuacct.usage", "/cpuacct.usage_user",
+                                        "/cpuacct.usage_sys"};
+
+                for (i = 0; i < ZBX_DOCKER_CPU_USAGE_COUNT; i++)
+                {
+                        filename = zbx_docker_cgroup_path(cpu_cgroup, container, files[i]);
+                        if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)) &&
+                                        1 == zbx_docker_scan_uint64(buffer, strlen(buffer), &entry->values[i]))
+                        {
+                                entry->has[i] = 1;
+                        }
+                        free(filename);
+                }
+        }
+
+        zbx_strlcpy(entry->id, container, sizeof(entry->id));
+        // too long ids (cgroup directory names) are not cached
+        entry->time_us = strlen(container) < sizeof(entry->id) ? now : 0;
+
+        if (1 != entry->has[index])
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Cannot read CPU %s of container %s", metric, container);
+                return SYSINFO_RET_FAIL;
+        }
+        *usage = entry->values[index];
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cpu_counters                                          *
+ *                                                                            *
+ * Purpose: read cumulative CPU usage and CFS period counters                 *
+ *                                                                            *
+ * Parameters: container - full container id                                 *
+ *             usage - CPU time in usec (user + system), NULL - not needed    *
+ *             periods - elapsed CFS periods, NULL - not needed               *
+ *             throttled - throttled CFS periods                              *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - stat file cannot be read                  *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: cgroup v1 CFS periods are in cpu.stat of cpu controller            *
+ ******************************************************************************/
+int     zbx_docker_cpu_counters(const char *container, zbx_uint64_t *usage, zbx_uint64_t *periods,
+                zbx_uint64_t *throttled)
+{
+        zbx_docker_scan_t       scan;
+        char                    *filename;
+        int                     ret = SYSINFO_RET_OK;
+
+        if (NULL != usage)
+        {
+                if (SYSINFO_RET_OK == (ret = zbx_docker_cpu_usage(container, "usage", usage)))
+                        *usage /= 1000;
+        }
+
+        if (NULL != periods && SYSINFO_RET_OK == ret)
+        {
+                char    *cgroup = 1 == cgroup_v2 || NULL != strchr(cpu_cgroup, ',') ? cpu_cgroup : "cpu/";
+
+                filename = zbx_docker_cgroup_path(cgroup, container, "/cpu.stat");
+                if (0 > zbx_docker_scan_read(&scan, filename))
+                {
+                        zabbix_log(LOG_LEVEL_DEBUG, "Cannot open metric file: '%s'", filename);
+                        ret = SYSINFO_RET_FAIL;
+                }
+                else
+                {
+                        *periods = zbx_docker_scan_get(&scan, ZBX_DOCKER_STAT_NR_PERIODS);
+                        *throttled = zbx_docker_scan_get(&scan, ZBX_DOCKER_STAT_NR_THROTTLED);
+                }
+                free(filename);
+        }
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_cpu_util                                       *
+ *                                                                            *
+ * Purpose: container CPU utilization in % of its own CPU entitlement         *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: 100% - container uses all CPU time allowed by CFS quota/cpuset,     *
+ *        limit - entitlement in number of CPUs                               *
+ ******************************************************************************/
+int     zbx_module_docker_cpu_util(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_cpu_util()");
+        char            *container, *mode;
+        double          cpus, rate;
+        zbx_uint64_t    usage;
+
+        if (1 > request->nparam || 2 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        mode = get_rparam(request, 1);
+        if (NULL == mode || '\0' == *mode)
+                mode = "util";
+        if (0 != strcmp(mode, "util") && 0 != strcmp(mode, "limit"))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL || (cpu_cgroup == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "docker.cpu.util is not available at the moment - no stat directory");
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.cpu.util is not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (SYSINFO_RET_OK != zbx_docker_cpu_limit(container, &cpus))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find container cgroup"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (0 == strcmp(mode, "limit"))
+        {
+                SET_DBL_RESULT(result, cpus);
+                return SYSINFO_RET_OK;
+        }
+
+        if (SYSINFO_RET_OK != zbx_docker_cpu_counters(container, &usage, NULL, NULL))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read CPU usage"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (SYSINFO_RET_OK != zbx_docker_rate_sample(zbx_docker_rate_hash(request), usage, &rate, result))
+                return SYSINFO_RET_FAIL;
+
+        // usec of CPU time per second
+        SET_DBL_RESULT(result, 0 < cpus ? rate / 10000 / cpus : 0);
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_cpu_throttled                                  *
+ *                                                                            *
+ * Purpose: % of CFS periods in which the container was throttled since the   *
+ *          previous call                                                     *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_cpu_throttled(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_cpu_throttled()");
+        char            *container;
+        double          periods_rate, throttled_rate;
+        zbx_uint64_t    periods, throttled, hash;
+        int             ret;
+
+        if (1 != request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL || (cpu_cgroup == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "docker.cpu.throttled is not available at the moment - no stat directory");
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.cpu.throttled is not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (SYSINFO_RET_OK != zbx_docker_cpu_counters(container, NULL, &periods, &throttled))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot open cpu.stat file"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        // both counters are sampled at the same time, so they cover the same interval, both are stored on failure
+        hash = zbx_docker_rate_hash(request);
+        ret = zbx_docker_rate_sample(hash, periods, &periods_rate, result);
+        if (SYSINFO_RET_OK != zbx_docker_rate_sample(hash ^ __UINT64_C(0x9e3779b97f4a7c15), throttled,
+                        &throttled_rate, result) || SYSINFO_RET_OK != ret)
+        {
+                return SYSINFO_RET_FAIL;
+        }
+
+        SET_DBL_RESULT(result, 0 < periods_rate ? MIN(throttled_rate / periods_rate * 100, 100) : 0);
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cpu_percpu_get                                        *
+ *                                                                            *
+ * Purpose: get per-CPU usage of the container, cpuacct.usage_percpu is read  *
+ *          at most once per ZBX_DOCKER_PERCPU_TTL for all CPUs               *
+ *                                                                            *
+ * Return value: cached per-CPU usage, NULL - file cannot be read             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_docker_percpu_t     *zbx_docker_cpu_percpu_get(const char *container)
+{
+        zbx_docker_percpu_t     *entry = &percpu[zbx_docker_id_hash(container) & (ZBX_DOCKER_PERCPU_SIZE - 1)];
+        zbx_uint64_t            now = zbx_docker_stats_time(), value;
+        char                    *filename, *buffer, *p, *end;
+        size_t                  size;
+        int                     len, values_alloc = 0;
+
+        if (0 != entry->time_us && now - entry->time_us < ZBX_DOCKER_PERCPU_TTL && 0 == strcmp(entry->id, container))
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_PERCPU, 1);
+                return entry;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_PERCPU, 0);
+
+        // "<ns> <ns> ... \n", ~20 bytes per possible (not only online) CPU, the buffer grows until the read is short
+        size = cpu_online * 24 + MAX_STRING_LEN;
+        buffer = malloc(size);
+        filename = zbx_docker_cgroup_path(cpu_cgroup, container, "/cpuacct.usage_percpu");
+        while (0 <= (len = zbx_docker_read_file(filename, buffer, size)) && (size_t)len == size - 1)
+        {
+                size *= 2;
+                buffer = realloc(buffer, size);
+        }
+        free(filename);
+        if (0 > len)
+        {
+                free(buffer);
+                return NULL;
+        }
+
+        entry->values_num = 0;
+        for (p = buffer; ; p = end)
+        {
+                value = strtoull(p, &end, 10);
+                if (end == p)
+                        break;
+                if (entry->values_num == values_alloc)
+                {
+                        values_alloc = 0 == values_alloc ? cpu_online : values_alloc * 2;
+                        entry->values = realloc(entry->values, sizeof(zbx_uint64_t) * values_alloc);
+                }
+                entry->values[entry->values_num++] = value;
+        }
+        free(buffer);
+
+        zbx_strlcpy(entry->id, container, sizeof(entry->id));
+        // too long ids (cgroup directory names) are not cached
+        entry->time_us = strlen(container) < sizeof(entry->id) ? now : 0;
+
+        return entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_cpu_percpu                                     *
+ *                                                                            *
+ * Purpose: container CPU usage of single CPU or all CPUs                     *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: cumulative ns of the CPU, JSON array of all CPUs without <cpu>;     *
+ *        cgroup v2 has no per-CPU accounting                                 *
+ ******************************************************************************/
+int     zbx_module_docker_cpu_percpu(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_cpu_percpu()");
+        zbx_docker_percpu_t     *entry;
+        char                    *container, *cpu, *end;
+        long                    index;
+        int                     i;
+
+        if (1 > request->nparam || 2 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (stat_dir == NULL || driver == NULL || (cpu_cgroup == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "docker.cpu.percpu is not available at the moment - no stat directory");
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.cpu.percpu is not available at the moment - no stat directory"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (1 == cgroup_v2)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Per-CPU usage is not available for cgroup v2"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        entry = zbx_docker_cpu_percpu_get(container);
+        if (NULL == entry)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot open cpuacct.usage_percpu file"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        cpu = get_rparam(request, 1);
+        if (NULL == cpu || '\0' == *cpu)
+        {
+                json_t *a = json_array();
+                for (i = 0; i < entry->values_num; i++)
+                        json_array_append_new(a, json_integer(entry->values[i]));
+                SET_STR_RESULT(result, json_dumps(a, 0));
+                json_decref(a);
+                return SYSINFO_RET_OK;
+        }
+
+        index = strtol(cpu, &end, 10);
+        if ('\0' != *end || 0 > index || index >= entry->values_num)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid CPU number"));
+                return SYSINFO_RET_FAIL;
+        }
+        SET_UI64_RESULT(result, entry->values[index]);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sampler_find                                          *
+ *                                                                            *
+ * Purpose: find sampler entry of the container                               *
+ *                                                                            *
+ * Return value: entry index, -1 - container is not sampled                   *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_sampler_find(const char *container)
+{
+        unsigned int    start = zbx_docker_id_hash(container), i;
+
+        for (i = 0; i < ZBX_DOCKER_SAMPLER_CONTAINERS; i++)
+        {
+                int     index = (start + i) % ZBX_DOCKER_SAMPLER_CONTAINERS;
+
+                if (0 == strcmp(sampler[index].id, container))
+                        return index;
+                if ('\0' == sampler[index].id[0] && 0 == sampler[index].epoch)
+                        break;
+        }
+
+        return -1;
+}
+
+typedef struct
+{
+        zbx_uint64_t    usage;          // usec
+        zbx_uint64_t    periods;
+        zbx_uint64_t    throttled;
+        zbx_uint64_t    time_us;
+        unsigned int    generation;
+        zbx_uint64_t    sched_time_us;
+        void            *tasks;         // zbx_docker_sched_task_t of the previous pass, sorted by tid
+        int             tasks_num;
+}
+zbx_docker_sampler_prev_t;
+
+typedef struct
+{
+        zbx_uint64_t    tid;
+        zbx_uint64_t    run_delay;
+        zbx_uint64_t    timeslices;
+        zbx_uint64_t    voluntary;
+        zbx_uint64_t    nonvoluntary;
+}
+zbx_docker_sched_task_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sched_task_compare                                    *
+ *                                                                            *
+ * Purpose: qsort() and bsearch() comparison of tasks by tid                  *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_sched_task_compare(const void *t1, const void *t2)
+{
+        zbx_uint64_t    tid1 = ((const zbx_docker_sched_task_t *)t1)->tid, tid2 = ((const zbx_docker_sched_task_t *)t2)->tid;
+
+        return tid1 < tid2 ? -1 : tid1 > tid2;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sched_read                                            *
+ *                                                                            *
+ * Purpose: read scheduler statistics of all tasks of the container           *
+ *                                                                            *
+ * Parameters: container - full container id                                  *
+ *             tasks - statistics of tasks sorted by tid, must be freed       *
+ *             tasks_num - number of tasks                                    *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - task list cannot be read                  *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: tasks (threads) are from cgroup tasks (v1) or cgroup.threads (v2),  *
+ *        /proc/<tid>/schedstat is '<cpu ns> <run delay ns> <timeslices>',    *
+ *        context switches are from /proc/<tid>/status                        *
+ ******************************************************************************/
+int     zbx_docker_sched_read(const char *container, zbx_docker_sched_task_t **tasks, int *tasks_num)
+{
+        char                    *filename, *list = NULL, *tid, *saveptr, buffer[MAX_STRING_LEN * 2], *pos;
+        zbx_uint64_t            cpu;
+        zbx_docker_sched_task_t *task;
+        size_t                  len = 0, alloc = 0;
+        ssize_t                 n;
+        int                     fd, tasks_alloc = 0;
+
+        filename = zbx_docker_cgroup_path(cpu_cgroup, container, 1 == cgroup_v2 ? "/cgroup.threads" : "/tasks");
+        fd = open(filename, O_RDONLY | O_CLOEXEC);
+        free(filename);
+        if (-1 == fd)
+                return SYSINFO_RET_FAIL;
+
+        // one tid per line, the list grows with number of threads
+        do
+        {
+                if (alloc - len < MAX_STRING_LEN)
+                {
+                        alloc += 4 * MAX_STRING_LEN;
+                        list = realloc(list, alloc);
+                }
+                n = read(fd, list + len, alloc - len - 1);
+                len += 0 < n ? (size_t)n : 0;
+        }
+        while (0 < n);
+        close(fd);
+        list[len] = '\0';
+
+        *tasks = NULL;
+        *tasks_num = 0;
+        for (tid = strtok_r(list, "\n", &saveptr); NULL != tid; tid = strtok_r(NULL, "\n", &saveptr))
+        {
+                if (*tasks_num == tasks_alloc)
+                {
+                        tasks_alloc = 0 == tasks_alloc ? 64 : tasks_alloc * 2;
+                        *tasks = realloc(*tasks, tasks_alloc * sizeof(zbx_docker_sched_task_t));
+                }
+                task = &(*tasks)[*tasks_num];
+                memset(task, 0, sizeof(*task));
+                task->tid = strtoull(tid, NULL, 10);
+
+                // task could exit in the meantime
+                filename = zbx_dsprintf(NULL, "%s/proc/%s/schedstat", rootfs, tid);
+                if (0 >= zbx_docker_read_file(filename, buffer, sizeof(buffer)) ||
+                                3 != sscanf(buffer, ZBX_FS_UI64 " " ZBX_FS_UI64 " " ZBX_FS_UI64, &cpu,
+                                &task->run_delay, &task->timeslices))
+                {
+                        free(filename);
+                        continue;
+                }
+                free(filename);
+
+                filename = zbx_dsprintf(NULL, "%s/proc/%s/status", rootfs, tid);
+                if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)))
+                {
+                        if (NULL != (pos = strstr(buffer, "\nvoluntary_ctxt_switches:")))
+                                task->voluntary = strtoull(pos + 25, NULL, 10);
+                        if (NULL != (pos = strstr(buffer, "\nnonvoluntary_ctxt_switches:")))
+                                task->nonvoluntary = strtoull(pos + 28, NULL, 10);
+                }
+                free(filename);
+                (*tasks_num)++;
+        }
+        free(list);
+
+        if (1 < *tasks_num)
+                qsort(*tasks, *tasks_num, sizeof(zbx_docker_sched_task_t), zbx_docker_sched_task_compare);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sched_sample                                          *
+ *                                                                            *
+ * Purpose: background pass of the sampler, update scheduler statistics of   *
+ *          the container in shared memory                                    *
+ *                                                                            *
+ * Notes: counters are increased by the growth of each task since the        *
+ *        previous pass, so they don't decrease when tasks exit; a new task   *
+ *        adds all its values, the first pass gives the sums of the tasks     *
+ ******************************************************************************/
+void    zbx_docker_sched_sample(const char *container, zbx_docker_sampler_entry_t *entry,
+                zbx_docker_sampler_prev_t *p, zbx_uint64_t now)
+{
+        zbx_docker_sched_t      sched = entry->sched;
+        zbx_docker_sched_task_t *tasks, *task, *last, base;
+        zbx_uint64_t            run_delay = 0, timeslices = 0;
+        int                     tasks_num, i;
+
+        if (SYSINFO_RET_OK != zbx_docker_sched_read(container, &tasks, &tasks_num))
+                return;
+
+        for (i = 0; i < tasks_num; i++)
+        {
+                task = &tasks[i];
+                memset(&base, 0, sizeof(base));
+                // the tid could be reused by a new task with smaller counters
+                if (0 < p->tasks_num && NULL != (last = bsearch(task, p->tasks, p->tasks_num,
+                                sizeof(zbx_docker_sched_task_t), zbx_docker_sched_task_compare)) &&
+                                task->run_delay >= last->run_delay &&
+                                task->timeslices >= last->timeslices && task->voluntary >= last->voluntary &&
+                                task->nonvoluntary >= last->nonvoluntary)
+                {
+                        base = *last;
+                }
+                run_delay += task->run_delay - base.run_delay;
+                timeslices += task->timeslices - base.timeslices;
+                sched.voluntary += task->voluntary - base.voluntary;
+                sched.nonvoluntary += task->nonvoluntary - base.nonvoluntary;
+        }
+        sched.tasks = tasks_num;
+        sched.run_delay += run_delay;
+        sched.timeslices += timeslices;
+
+        if (0 != p->sched_time_us)
+        {
+                sched.wait = 0 < timeslices ? (double)run_delay / timeslices / 1000000 : 0;
+                sched.delay = (double)run_delay / ((now - p->sched_time_us) * 1000);
+        }
+        free(p->tasks);
+        p->tasks = tasks;
+        p->tasks_num = tasks_num;
+        p->sched_time_us = now;
+
+        // odd sequence while the statistics are being written
+        __atomic_add_fetch(&entry->sched_seq, 1, __ATOMIC_RELEASE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        entry->sched = sched;
+        __atomic_add_fetch(&entry->sched_seq, 1, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sampler_add                                           *
+ *                                                                            *
+ * Purpose: enumeration callback of the sampler, store one sample of the      *
+ *          container                                                         *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_sampler_add(const char *container, void *arg)
+{
+        static unsigned int             generation;
+        zbx_docker_sampler_prev_t       *prev = (zbx_docker_sampler_prev_t *)arg, *p;
+        zbx_docker_sampler_entry_t      *entry;
+        zbx_docker_sample_t             *sample;
+        zbx_uint64_t                    usage, periods = 0, throttled = 0, mem = 0, now;
+        char                            *filename, buffer[64];
+        double                          cpus;
+        int                             index;
+        unsigned int                    i, start;
+
+        // sweep call after enumeration, see zbx_docker_sampler_run()
+        if (NULL == container)
+        {
+                for (index = 0; index < ZBX_DOCKER_SAMPLER_CONTAINERS; index++)
+                {
+                        entry = &sampler[index];
+                        if ('\0' == entry->id[0] || prev[index].generation == generation)
+                                continue;
+                        __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+                        entry->id[0] = '\0';
+                        __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+                }
+                generation++;
+                return;
+        }
+
+        if (strlen(container) >= sizeof(entry->id))
+                return;
+
+        if (-1 == (index = zbx_docker_sampler_find(container)))
+        {
+                // new container, removed containers leave their slots free
+                start = zbx_docker_id_hash(container);
+                for (i = 0; i < ZBX_DOCKER_SAMPLER_CONTAINERS; i++)
+                {
+                        index = (start + i) % ZBX_DOCKER_SAMPLER_CONTAINERS;
+                        if ('\0' == sampler[index].id[0])
+                                break;
+                }
+                if (ZBX_DOCKER_SAMPLER_CONTAINERS == i)
+                        return;
+
+                entry = &sampler[index];
+                __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+                zbx_strlcpy(entry->id, container, sizeof(entry->id));
+                __atomic_store_n(&entry->seq, 0, __ATOMIC_RELAXED);
+                __atomic_store_n(&entry->sched_seq, 0, __ATOMIC_RELAXED);
+                memset(&entry->sched, 0, sizeof(entry->sched));
+                __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+                prev[index].time_us = 0;
+                prev[index].sched_time_us = 0;
+                free(prev[index].tasks);
+                prev[index].tasks = NULL;
+                prev[index].tasks_num = 0;
+        }
+        entry = &sampler[index];
+        p = &prev[index];
+        p->generation = generation;
+
+        if (0 != sched_pass)
+                zbx_docker_sched_sample(container, entry, p, zbx_docker_stats_time());
+
+        // scheduler statistics only (ZBX_DOCKER_SCHED without ZBX_DOCKER_SAMPLER)
+        if (0 == sampler_interval)
+                return;
+
+        if (SYSINFO_RET_OK != zbx_docker_cpu_counters(container, &usage, &periods, &throttled) ||
+                        SYSINFO_RET_OK != zbx_docker_cpu_limit(container, &cpus))
+        {
+                return;
+        }
+        filename = zbx_docker_cgroup_path("memory/", container, 1 == cgroup_v2 ? "/memory.current" :
+                        "/memory.usage_in_bytes");
+        if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)))
+                zbx_docker_scan_uint64(buffer, strlen(buffer), &mem);
+        free(filename);
+
+        now = zbx_docker_stats_time();
+        // the first sample and counter reset (restart) give only the base values
+        if (0 != p->time_us && usage >= p->usage && periods >= p->periods && throttled >= p->throttled)
+        {
+                sample = &entry->samples[entry->seq % ZBX_DOCKER_SAMPLER_RING];
+                sample->time_us = now;
+                sample->cpu = 0 < cpus ? (double)(usage - p->usage) * 100 / (now - p->time_us) / cpus : 0;
+                sample->throttled = periods > p->periods ? (double)(throttled - p->throttled) * 100 /
+                                (periods - p->periods) : 0;
+                sample->mem = mem;
+                __atomic_add_fetch(&entry->seq, 1, __ATOMIC_RELEASE);
+        }
+        p->usage = usage;
+        p->periods = periods;
+        p->throttled = throttled;
+        p->time_us = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sampler_run                                           *
+ *                                                                            *
+ * Purpose: sampler thread, samples all running containers every              *
+ *          sampler_interval seconds                                          *
+ *                                                                            *
+ * Notes: the thread runs in the agent main process, agent collectors read    *
+ *        the shared ring buffers; scheduler statistics are read every        *
+ *        sched_interval seconds, rounded down to a multiple of the sampler   *
+ *        interval, they open two /proc files per task                        *
+ ******************************************************************************/
+void    *zbx_docker_sampler_run(void *arg)
+{
+        static zbx_docker_sampler_prev_t        prev[ZBX_DOCKER_SAMPLER_CONTAINERS];
+        struct timespec                         next;
+        int                                     tick, ticks = 0, index;
+
+        tick = 0 != sampler_interval ? sampler_interval : sched_interval;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        pthread_mutex_lock(&sampler_lock);
+        while (0 == sampler_stop)
+        {
+                pthread_mutex_unlock(&sampler_lock);
+                sched_pass = 0 != sched_interval && 0 == ticks++ % (sched_interval > tick ? sched_interval / tick : 1);
+                if (SYSINFO_RET_OK == zbx_docker_containers_enum(zbx_docker_sampler_add, prev))
+                        zbx_docker_sampler_add(NULL, prev);
+                pthread_mutex_lock(&sampler_lock);
+
+                next.tv_sec += tick;
+                while (0 == sampler_stop && ETIMEDOUT != pthread_cond_timedwait(&sampler_cond, &sampler_lock, &next))
+                        ;
+        }
+        pthread_mutex_unlock(&sampler_lock);
+
+        for (index = 0; index < ZBX_DOCKER_SAMPLER_CONTAINERS; index++)
+        {
+                free(prev[index].tasks);
+                prev[index].tasks = NULL;
+                prev[index].tasks_num = 0;
+        }
+
+        return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_thread_create                                         *
+ *                                                                            *
+ * Purpose: start background thread in the agent main process with all       *
+ *          signals blocked                                                   *
+ *                                                                            *
+ * Return value: 0 - success, error number of pthread_create()                *
+ *                                                                            *
+ * Notes: agent signal handlers (SIGTERM, SIGCHLD, ...) must not run on the   *
+ *        thread, their exit path calls zbx_module_uninit(), which joins it   *
+ ******************************************************************************/
+int     zbx_docker_thread_create(pthread_t *thread, void *(*start)(void *))
+{
+        sigset_t        mask, orig_mask;
+        int             err;
+
+        sigfillset(&mask);
+        pthread_sigmask(SIG_SETMASK, &mask, &orig_mask);
+        err = pthread_create(thread, NULL, start, NULL);
+        pthread_sigmask(SIG_SETMASK, &orig_mask, NULL);
+
+        return err;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sampler_init                                          *
+ *                                                                            *
+ * Purpose: allocate shared ring buffers and start the sampler thread         *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_sampler_init()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_sampler_init()");
+        pthread_condattr_t      attr;
+        int                     err;
+
+        if (0 == sampler_interval && 0 == sched_interval)
+                return;
+
+        sampler = mmap(NULL, sizeof(zbx_docker_sampler_entry_t) * ZBX_DOCKER_SAMPLER_CONTAINERS,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == sampler)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot allocate shared memory for sampler: %s", zbx_strerror(errno));
+            sampler = NULL;
+            return;
+        }
+
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&sampler_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        sampler_stop = 0;
+        sampler_pid = getpid();
+        zbx_docker_live_atfork();
+        if (0 != (err = zbx_docker_thread_create(&sampler_thread, zbx_docker_sampler_run)))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot start sampler thread: %s", zbx_strerror(err));
+            munmap(sampler, sizeof(zbx_docker_sampler_entry_t) * ZBX_DOCKER_SAMPLER_CONTAINERS);
+            sampler = NULL;
+            return;
+        }
+        zabbix_log(LOG_LEVEL_DEBUG, "Sampler started, interval: %ds, scheduler statistics interval: %ds",
+                        sampler_interval, sched_interval);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_sampler_uninit                                        *
+ *                                                                            *
+ * Purpose: stop the sampler thread                                           *
+ *                                                                            *
+ * Notes: the thread exists only in the process which started it              *
+ ******************************************************************************/
+void    zbx_docker_sampler_uninit()
+{
+        if (NULL == sampler)
+                return;
+
+        if (getpid() == sampler_pid)
+        {
+                pthread_mutex_lock(&sampler_lock);
+                sampler_stop = 1;
+                pthread_cond_signal(&sampler_cond);
+                pthread_mutex_unlock(&sampler_lock);
+                pthread_join(sampler_thread, NULL);
+        }
+        munmap(sampler, sizeof(zbx_docker_sampler_entry_t) * ZBX_DOCKER_SAMPLER_CONTAINERS);
+        sampler = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_double_compare                                        *
+ *                                                                            *
+ * Purpose: qsort() comparison of doubles                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_double_compare(const void *d1, const void *d2)
+{
+        double  v1 = *(const double *)d1, v2 = *(const double *)d2;
+
+        return v1 < v2 ? -1 : v1 > v2;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_peak                                                  *
+ *                                                                            *
+ * Purpose: statistics of sampled container metric since the previous call   *
+ *          of the item                                                       *
+ *                                                                            *
+ * Parameters: request - item request: container, <max|p95|avg|min|count>    *
+ *             result - statistics                                            *
+ *             offset - offset of the metric in zbx_docker_sample_t           *
+ *             integer - metric is zbx_uint64_t, otherwise double             *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: position of the last call is kept in the shared rate samples; the   *
+ *        latest sample is used if there is no new one since the last call   *
+ ******************************************************************************/
+int     zbx_docker_peak(AGENT_REQUEST *request, AGENT_RESULT *result, size_t offset, int integer)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_peak()");
+        zbx_docker_sampler_entry_t      *entry;
+        zbx_docker_rate_t               *last;
+        zbx_uint64_t                    epoch, seq, from, i;
+        char                            *container, *func;
+        double                          values[ZBX_DOCKER_SAMPLER_RING], value = 0;
+        int                             index, values_num = 0;
+
+        if (1 > request->nparam || 2 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        func = get_rparam(request, 1);
+        if (NULL == func || '\0' == *func)
+                func = "max";
+        if (0 != strcmp(func, "max") && 0 != strcmp(func, "p95") && 0 != strcmp(func, "avg") &&
+                        0 != strcmp(func, "min") && 0 != strcmp(func, "count"))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (NULL == sampler || 0 == sampler_interval)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Sampler is not enabled, set ZBX_DOCKER_SAMPLER environment variable"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        index = zbx_docker_sampler_find(container);
+        entry = -1 == index ? NULL : &sampler[index];
+        epoch = NULL == entry ? 1 : __atomic_load_n(&entry->epoch, __ATOMIC_ACQUIRE);
+        if (0 != epoch % 2 || 0 != strcmp(entry->id, container))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not sampled yet"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (0 == (seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE)))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not sampled yet"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (NULL == rates || NULL == (last = zbx_docker_rate_get(zbx_docker_rate_hash(request), zbx_docker_stats_time())))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Rate samples are not available - shared memory is full or missing"));
+                return SYSINFO_RET_FAIL;
+        }
+        from = 0 == last->time_us || last->value > seq ? 0 : last->value;
+        last->value = seq;
+        last->time_us = zbx_docker_stats_time();
+        pthread_mutex_unlock(&last->lock);
+
+        if (from == seq)
+                from = seq - 1;
+        if (seq - from > ZBX_DOCKER_SAMPLER_RING)
+                from = seq - ZBX_DOCKER_SAMPLER_RING;
+
+        for (i = from; i < seq; i++)
+        {
+                const char      *sample = (const char *)&entry->samples[i % ZBX_DOCKER_SAMPLER_RING] + offset;
+
+                values[values_num++] = integer ? (double)*(const zbx_uint64_t *)sample : *(const double *)sample;
+        }
+
+        // samples overwritten by the sampler during the copy are dropped
+        i = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+        if (i - from > ZBX_DOCKER_SAMPLER_RING)
+        {
+                zbx_uint64_t    lost = MIN(i - from - ZBX_DOCKER_SAMPLER_RING, (zbx_uint64_t)values_num);
+
+                memmove(values, values + lost, sizeof(double) * (values_num - lost));
+                values_num -= lost;
+        }
+        if (epoch != __atomic_load_n(&entry->epoch, __ATOMIC_ACQUIRE) || 0 == values_num)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container was removed during sampling"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (0 == strcmp(func, "count"))
+        {
+                SET_UI64_RESULT(result, values_num);
+                return SYSINFO_RET_OK;
+        }
+
+        qsort(values, values_num, sizeof(double), zbx_docker_double_compare);
+        if (0 == strcmp(func, "max"))
+        {
+                value = values[values_num - 1];
+        }
+        else if (0 == strcmp(func, "min"))
+        {
+                value = values[0];
+        }
+        else if (0 == strcmp(func, "p95"))
+        {
+                // nearest rank
+                value = values[(values_num * 95 + 99) / 100 - 1];
+        }
+        else
+        {
+                for (index = 0; index < values_num; index++)
+                        value += values[index];
+                value /= values_num;
+        }
+
+        if (integer)
+                SET_UI64_RESULT(result, (zbx_uint64_t)value);
+        else
+                SET_DBL_RESULT(result, value);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_cpu_peak                                       *
+ *                                                                            *
+ * Purpose: sampled CPU utilization (% of entitlement) since the last call    *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_cpu_peak(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        return zbx_docker_peak(request, result, offsetof(zbx_docker_sample_t, cpu), 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_mem_peak                                       *
+ *                                                                            *
+ * Purpose: sampled memory usage since the last call                          *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_mem_peak(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        return zbx_docker_peak(request, result, offsetof(zbx_docker_sample_t, mem), 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_throttled_peak                                 *
+ *                                                                            *
+ * Purpose: sampled % of throttled CFS periods since the last call            *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_throttled_peak(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        return zbx_docker_peak(request, result, offsetof(zbx_docker_sample_t, throttled), 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_find                                           *
+ *                                                                            *
+ * Purpose: find event counters of the container                              *
+ *                                                                            *
+ * Return value: entry index, -1 - container is not watched                   *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_events_find(const char *container)
+{
+        unsigned int    start = zbx_docker_id_hash(container), i;
+
+        for (i = 0; i < ZBX_DOCKER_EVENTS_CONTAINERS; i++)
+        {
+                int     index = (start + i) % ZBX_DOCKER_EVENTS_CONTAINERS;
+
+                if (0 == strcmp(events[index].id, container))
+                        return index;
+                if ('\0' == events[index].id[0] && 0 == events[index].epoch)
+                        break;
+        }
+
+        return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_read                                           *
+ *                                                                            *
+ * Purpose: update counters of the container from memory.events (v2) or       *
+ *          oom_kill line of memory.oom_control (v1)                          *
+ *                                                                            *
+ * Parameters: index - entry index                                            *
+ *             fd - polled v2 memory.events, -1 - the file is opened          *
+ *             oom - v1, optional: 1 - under_oom is set or oom_kill changed   *
+ *                   (or it is not available, before kernel 4.13), 0 - no OOM *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - cgroup was removed                        *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: the kernel counters are cumulative, they are copied                 *
+ ******************************************************************************/
+int     zbx_docker_events_read(int index, int fd, int *oom)
+{
+        zbx_docker_events_entry_t       *entry = &events[index];
+        zbx_docker_scan_t               scan;
+        zbx_uint64_t                    value;
+        char                            *filename;
+        int                             ret;
+
+        if (1 == cgroup_v2)
+        {
+                filename = zbx_docker_cgroup_path("", entry->id, "/memory.events");
+                ret = 0 <= (-1 == fd ? zbx_docker_scan_read(&scan, filename) : zbx_docker_scan_fd(&scan, fd)) ?
+                                SYSINFO_RET_OK : SYSINFO_RET_FAIL;
+                if (SYSINFO_RET_OK == ret)
+                {
+                        if (1 == zbx_docker_scan_value(&scan, "high", &value))
+                                __atomic_store_n(&entry->counters[ZBX_DOCKER_EVENT_HIGH], value, __ATOMIC_RELAXED);
+                        if (1 == zbx_docker_scan_value(&scan, "max", &value))
+                                __atomic_store_n(&entry->counters[ZBX_DOCKER_EVENT_MAX], value, __ATOMIC_RELAXED);
+                        if (1 == zbx_docker_scan_value(&scan, "oom", &value))
+                                __atomic_store_n(&entry->counters[ZBX_DOCKER_EVENT_OOM], value, __ATOMIC_RELAXED);
+                        if (1 == zbx_docker_scan_value(&scan, "oom_kill", &value))
+                                __atomic_store_n(&entry->counters[ZBX_DOCKER_EVENT_OOM_KILL], value, __ATOMIC_RELAXED);
+                }
+        }
+        else
+        {
+                filename = zbx_docker_cgroup_path("memory/", entry->id, "/memory.oom_control");
+                ret = 0 <= zbx_docker_scan_read(&scan, filename) ? SYSINFO_RET_OK : SYSINFO_RET_FAIL;
+                if (SYSINFO_RET_OK == ret)
+                {
+                        if (NULL != oom)
+                                *oom = 1 == zbx_docker_scan_value(&scan, "under_oom", &value) && 0 != value;
+                        // kernel 4.13+
+                        if (1 == zbx_docker_scan_value(&scan, "oom_kill", &value))
+                        {
+                                if (NULL != oom && value != entry->counters[ZBX_DOCKER_EVENT_OOM_KILL])
+                                        *oom = 1;
+                                __atomic_store_n(&entry->counters[ZBX_DOCKER_EVENT_OOM_KILL], value, __ATOMIC_RELAXED);
+                        }
+                        else if (NULL != oom)
+                        {
+                                *oom = 1;
+                        }
+                }
+        }
+        free(filename);
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_notify                                         *
+ *                                                                            *
+ * Purpose: register v1 eventfd notification by cgroup.event_control          *
+ *                                                                            *
+ * Parameters: container - full container id                                  *
+ *             file - memory.oom_control or memory.pressure_level             *
+ *             args - optional arguments, e.g. pressure level                 *
+ *                                                                            *
+ * Return value: eventfd, -1 - notification cannot be registered              *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_events_notify(const char *container, const char *file, const char *args)
+{
+        char    *filename, line[64];
+        int     efd = -1, fd = -1, ctl = -1, len;
+
+        filename = zbx_docker_cgroup_path("memory/", container, file);
+        if (-1 == (fd = open(filename, O_RDONLY | O_CLOEXEC)))
+                goto out;
+        free(filename);
+        filename = zbx_docker_cgroup_path("memory/", container, "/cgroup.event_control");
+        if (-1 == (ctl = open(filename, O_WRONLY | O_CLOEXEC)) ||
+                        -1 == (efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)))
+        {
+                goto out;
+        }
+
+        len = zbx_snprintf(line, sizeof(line), "%d %d%s%s", efd, fd, NULL == args ? "" : " ", NULL == args ? "" : args);
+        if (len != write(ctl, line, len))
+        {
+                close(efd);
+                efd = -1;
+        }
+out:
+        if (-1 == efd)
+                zabbix_log(LOG_LEVEL_DEBUG, "Cannot register %s notification of %s: %s", file, container, zbx_strerror(errno));
+        // the kernel holds its own references after registration
+        if (-1 != fd)
+                close(fd);
+        if (-1 != ctl)
+                close(ctl);
+        free(filename);
+
+        return efd;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_watch                                          *
+ *                                                                            *
+ * Purpose: start watching memory events of the container                     *
+ *                                                                            *
+ * Notes: v1 - eventfd of memory.oom_control and memory.pressure_level        *
+ *        (medium), v2 - poll() of memory.events and PSI trigger on           *
+ *        memory.pressure; registration needs write access to cgroup files,   *
+ *        v2 memory.events is only read                                       *
+ ******************************************************************************/
+void    zbx_docker_events_watch(int index, zbx_docker_events_watch_t *watch)
+{
+        char    *filename;
+
+        if (1 == cgroup_v2)
+        {
+                filename = zbx_docker_cgroup_path("", events[index].id, "/memory.events");
+                watch->fds[0] = open(filename, O_RDONLY | O_CLOEXEC);
+                free(filename);
+
+                // 200ms of stalled tasks in 2s window, unprivileged triggers need 2s window multiples
+                filename = zbx_docker_cgroup_path("", events[index].id, "/memory.pressure");
+                if (-1 != (watch->fds[1] = open(filename, O_RDWR | O_NONBLOCK | O_CLOEXEC)) &&
+                                0 > write(watch->fds[1], ZBX_DOCKER_EVENTS_TRIGGER, strlen(ZBX_DOCKER_EVENTS_TRIGGER) + 1))
+                {
+                        zabbix_log(LOG_LEVEL_DEBUG, "Cannot register PSI trigger %s: %s", filename, zbx_strerror(errno));
+                        close(watch->fds[1]);
+                        watch->fds[1] = -1;
+                }
+                free(filename);
+        }
+        else
+        {
+                watch->fds[0] = zbx_docker_events_notify(events[index].id, "/memory.oom_control", NULL);
+                watch->fds[1] = zbx_docker_events_notify(events[index].id, "/memory.pressure_level", "medium");
+        }
+        zbx_docker_events_read(index, watch->fds[0], NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_unwatch                                        *
+ *                                                                            *
+ * Purpose: stop watching the container and release its entry                 *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_events_unwatch(int index, zbx_docker_events_watch_t *watch)
+{
+        zbx_docker_events_entry_t       *entry = &events[index];
+        int                             i;
+
+        for (i = 0; i < 2; i++)
+        {
+                if (-1 != watch->fds[i])
+                        close(watch->fds[i]);
+                watch->fds[i] = -1;
+        }
+        __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+        entry->id[0] = '\0';
+        __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_add                                            *
+ *                                                                            *
+ * Purpose: enumeration callback of the event thread, watch new containers    *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_events_add(const char *container, void *arg)
+{
+        zbx_docker_events_watch_t       *watches = (zbx_docker_events_watch_t *)arg;
+        zbx_docker_events_entry_t       *entry;
+        unsigned int                    i, start;
+        int                             index;
+
+        if (strlen(container) >= sizeof(entry->id))
+                return;
+
+        if (-1 == (index = zbx_docker_events_find(container)))
+        {
+                start = zbx_docker_id_hash(container);
+                for (i = 0; i < ZBX_DOCKER_EVENTS_CONTAINERS; i++)
+                {
+                        index = (start + i) % ZBX_DOCKER_EVENTS_CONTAINERS;
+                        if ('\0' == events[index].id[0])
+                                break;
+                }
+                if (ZBX_DOCKER_EVENTS_CONTAINERS == i)
+                        return;
+
+                entry = &events[index];
+                __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+                zbx_strlcpy(entry->id, container, sizeof(entry->id));
+                memset(entry->counters, 0, sizeof(entry->counters));
+                __atomic_add_fetch(&entry->epoch, 1, __ATOMIC_RELEASE);
+                zbx_docker_events_watch(index, &watches[index]);
+        }
+        watches[index].generation = events_generation;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_run                                            *
+ *                                                                            *
+ * Purpose: event thread, waits for memory notifications of all running       *
+ *          containers                                                        *
+ *                                                                            *
+ * Notes: the thread runs in the agent main process, agent collectors read    *
+ *        the shared counters; containers are rescanned every                 *
+ *        ZBX_DOCKER_EVENTS_RESCAN seconds                                    *
+ ******************************************************************************/
+void    *zbx_docker_events_run(void *arg)
+{
+        static zbx_docker_events_watch_t        watches[ZBX_DOCKER_EVENTS_CONTAINERS];
+        struct pollfd                           fds[ZBX_DOCKER_EVENTS_CONTAINERS * 2 + 1];
+        int                                     indexes[ZBX_DOCKER_EVENTS_CONTAINERS * 2 + 1], fds_num, i, index,
+                                                removed, oom;
+        zbx_uint64_t                            now, rescan = 0, count;
+        char                                    *filename;
+
+        for (i = 0; i < ZBX_DOCKER_EVENTS_CONTAINERS; i++)
+                watches[i].fds[0] = watches[i].fds[1] = -1;
+
+        while (1)
+        {
+                now = zbx_docker_stats_time();
+                if (now >= rescan)
+                {
+                        events_generation++;
+                        if (SYSINFO_RET_OK == zbx_docker_containers_enum(zbx_docker_events_add, watches))
+                        {
+                                for (index = 0; index < ZBX_DOCKER_EVENTS_CONTAINERS; index++)
+                                {
+                                        if ('\0' != events[index].id[0] && watches[index].generation != events_generation)
+                                                zbx_docker_events_unwatch(index, &watches[index]);
+                                }
+                        }
+                        rescan = now + ZBX_DOCKER_EVENTS_RESCAN * 1000000;
+                }
+
+                // v1 eventfd is readable, v2 files signal POLLPRI on change
+                fds[0].fd = events_wake[0];
+                fds[0].events = POLLIN;
+                for (fds_num = 1, index = 0; index < ZBX_DOCKER_EVENTS_CONTAINERS; index++)
+                {
+                        for (i = 0; i < 2; i++)
+                        {
+                                if (-1 == watches[index].fds[i])
+                                        continue;
+                                fds[fds_num].fd = watches[index].fds[i];
+                                fds[fds_num].events = 1 == cgroup_v2 ? POLLPRI : POLLIN;
+                                indexes[fds_num++] = index * 2 + i;
+                        }
+                }
+
+                if (0 > poll(fds, fds_num, (int)((rescan - now) / 1000)))
+                {
+                        if (EINTR != errno)
+                                zabbix_log(LOG_LEVEL_WARNING, "Cannot wait for memory events: %s", zbx_strerror(errno));
+                        continue;
+                }
+                if (0 != fds[0].revents)
+                        break;
+
+                for (i = 1; i < fds_num; i++)
+                {
+                        zbx_docker_events_entry_t       *entry;
+
+                        if (0 == fds[i].revents)
+                                continue;
+                        index = indexes[i] / 2;
+                        entry = &events[index];
+
+                        if (1 == cgroup_v2)
+                        {
+                                // PSI trigger of removed cgroup signals POLLERR, it is released by rescan
+                                if (1 == indexes[i] % 2 && 0 != (fds[i].revents & (POLLERR | POLLNVAL)))
+                                        rescan = 0;
+                                else if (1 == indexes[i] % 2)
+                                        __atomic_add_fetch(&entry->counters[ZBX_DOCKER_EVENT_PRESSURE], 1, __ATOMIC_RELAXED);
+                                else if (SYSINFO_RET_OK != zbx_docker_events_read(index, fds[i].fd, NULL))
+                                        zbx_docker_events_unwatch(index, &watches[index]);
+                                continue;
+                        }
+
+                        if (sizeof(count) != read(fds[i].fd, &count, sizeof(count)))
+                                continue;
+                        // v1 eventfd is signalled also on cgroup removal, memory.oom_control could be still readable
+                        filename = zbx_docker_cgroup_path("memory/", entry->id, "");
+                        removed = -1 == access(filename, F_OK);
+                        free(filename);
+                        if (0 != removed || SYSINFO_RET_OK != zbx_docker_events_read(index, -1, &oom))
+                        {
+                                zbx_docker_events_unwatch(index, &watches[index]);
+                                continue;
+                        }
+                        if (1 == indexes[i] % 2)
+                                __atomic_add_fetch(&entry->counters[ZBX_DOCKER_EVENT_PRESSURE], count, __ATOMIC_RELAXED);
+                        else if (0 != oom)
+                                __atomic_add_fetch(&entry->counters[ZBX_DOCKER_EVENT_OOM], count, __ATOMIC_RELAXED);
+                }
+        }
+
+        for (index = 0; index < ZBX_DOCKER_EVENTS_CONTAINERS; index++)
+        {
+                if ('\0' != events[index].id[0])
+                        zbx_docker_events_unwatch(index, &watches[index]);
+        }
+        return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_init                                           *
+ *                                                                            *
+ * Purpose: allocate shared event counters and start the event thread         *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_events_init()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_events_init()");
+        int     err;
+
+        if (0 == events_enabled)
+                return;
+
+        events = mmap(NULL, sizeof(zbx_docker_events_entry_t) * ZBX_DOCKER_EVENTS_CONTAINERS,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == events)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot allocate shared memory for memory events: %s", zbx_strerror(errno));
+            events = NULL;
+            return;
+        }
+
+        // pipe2() is GNU extension
+        if (-1 == pipe(events_wake) || -1 == fcntl(events_wake[0], F_SETFD, FD_CLOEXEC) ||
+                        -1 == fcntl(events_wake[1], F_SETFD, FD_CLOEXEC))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot create pipe for event thread: %s", zbx_strerror(errno));
+            if (-1 != events_wake[0])
+            {
+                close(events_wake[0]);
+                close(events_wake[1]);
+                events_wake[0] = events_wake[1] = -1;
+            }
+            munmap(events, sizeof(zbx_docker_events_entry_t) * ZBX_DOCKER_EVENTS_CONTAINERS);
+            events = NULL;
+            return;
+        }
+
+        events_pid = getpid();
+        zbx_docker_live_atfork();
+        if (0 != (err = zbx_docker_thread_create(&events_thread, zbx_docker_events_run)))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot start event thread: %s", zbx_strerror(err));
+            close(events_wake[0]);
+            close(events_wake[1]);
+            munmap(events, sizeof(zbx_docker_events_entry_t) * ZBX_DOCKER_EVENTS_CONTAINERS);
+            events = NULL;
+            return;
+        }
+        zabbix_log(LOG_LEVEL_DEBUG, "Memory event thread started");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_events_uninit                                         *
+ *                                                                            *
+ * Purpose: stop the event thread                                             *
+ *                                                                            *
+ * Notes: the thread exists only in the process which started it              *
+ ******************************************************************************/
+void    zbx_docker_events_uninit()
+{
+        if (NULL == events)
+                return;
+
+        if (getpid() == events_pid)
+        {
+                if (1 != write(events_wake[1], "", 1))
+                        zabbix_log(LOG_LEVEL_WARNING, "Cannot stop event thread: %s", zbx_strerror(errno));
+                else
+                        pthread_join(events_thread, NULL);
+        }
+        close(events_wake[0]);
+        close(events_wake[1]);
+        munmap(events, sizeof(zbx_docker_events_entry_t) * ZBX_DOCKER_EVENTS_CONTAINERS);
+        events = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_mem_events                                     *
+ *                                                                            *
+ * Purpose: number of OOM and memory pressure events of the container         *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: docker.mem.events[cid,<oom|oom_kill|high|max|pressure>], counters   *
+ *        are collected by the event thread, see ZBX_DOCKER_EVENTS; high and  *
+ *        max are available only on cgroup v2                                 *
+ ******************************************************************************/
+int     zbx_module_docker_mem_events(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_mem_events()");
+        zbx_docker_events_entry_t       *entry;
+        zbx_uint64_t                    epoch, value;
+        char                            *container, *name;
+        int                             index, event;
+
+        if (1 > request->nparam || 2 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        name = get_rparam(request, 1);
+        if (NULL == name || '\0' == *name)
+                name = "oom_kill";
+        for (event = 0; event < ZBX_DOCKER_EVENT_COUNT && 0 != strcmp(event_names[event], name); event++)
+                ;
+        if (ZBX_DOCKER_EVENT_COUNT == event)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (NULL == events)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Memory events are not enabled, set ZBX_DOCKER_EVENTS environment variable"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        // memory.events exists only in the unified hierarchy
+        if (1 != cgroup_v2 && (ZBX_DOCKER_EVENT_HIGH == event || ZBX_DOCKER_EVENT_MAX == event))
+        {
+                SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Event %s is not supported on cgroup v1", name));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        index = zbx_docker_events_find(container);
+        entry = -1 == index ? NULL : &events[index];
+        epoch = NULL == entry ? 1 : __atomic_load_n(&entry->epoch, __ATOMIC_ACQUIRE);
+        if (0 != epoch % 2 || 0 != strcmp(entry->id, container))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not watched yet"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        value = __atomic_load_n(&entry->counters[event], __ATOMIC_RELAXED);
+        if (epoch != __atomic_load_n(&entry->epoch, __ATOMIC_ACQUIRE))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not watched yet"));
+                return SYSINFO_RET_FAIL;
+        }
+        SET_UI64_RESULT(result, value);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_sched                                          *
+ *                                                                            *
+ * Purpose: scheduler statistics of all tasks of the container                *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: docker.sched[cid,<wait|delay|run_delay|timeslices|voluntary|        *
+ *        nonvoluntary|tasks>], collected by the background sampler           *
+ ******************************************************************************/
+int     zbx_module_docker_sched(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_sched()");
+        zbx_docker_sampler_entry_t      *entry;
+        zbx_docker_sched_t              sched;
+        zbx_uint64_t                    epoch, seq;
+        char                            *container, *metric;
+        int                             index, tries;
+
+        if (1 > request->nparam || 2 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        metric = get_rparam(request, 1);
+        if (NULL == metric || '\0' == *metric)
+                metric = "wait";
+
+        if (NULL == sampler || 0 == sched_interval)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Scheduler statistics are not enabled, set ZBX_DOCKER_SCHED environment variable"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        index = zbx_docker_sampler_find(container);
+        entry = -1 == index ? NULL : &sampler[index];
+        epoch = NULL == entry ? 1 : __atomic_load_n(&entry->epoch, __ATOMIC_ACQUIRE);
+        if (0 != epoch % 2 || 0 != strcmp(entry->id, container))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not sampled yet"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        // the copy is consistent if the sequence did not change
+        for (tries = 0; tries < 100; tries++)
+        {
+                seq = __atomic_load_n(&entry->sched_seq, __ATOMIC_ACQUIRE);
+                if (0 != seq % 2)
+                        continue;
+                memcpy(&sched, &entry->sched, sizeof(sched));
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (seq == __atomic_load_n(&entry->sched_seq, __ATOMIC_RELAXED))
+                        break;
+        }
+        if (100 == tries || 0 == seq || epoch != __atomic_load_n(&entry->epoch, __ATOMIC_ACQUIRE))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not sampled yet"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (0 == strcmp(metric, "wait"))
+                SET_DBL_RESULT(result, sched.wait);
+        else if (0 == strcmp(metric, "delay"))
+                SET_DBL_RESULT(result, sched.delay);
+        else if (0 == strcmp(metric, "run_delay"))
+                SET_UI64_RESULT(result, sched.run_delay);
+        else if (0 == strcmp(metric, "timeslices"))
+                SET_UI64_RESULT(result, sched.timeslices);
+        else if (0 == strcmp(metric, "voluntary"))
+                SET_UI64_RESULT(result, sched.voluntary);
+        else if (0 == strcmp(metric, "nonvoluntary"))
+                SET_UI64_RESULT(result, sched.nonvoluntary);
+        else if (0 == strcmp(metric, "tasks"))
+                SET_UI64_RESULT(result, sched.tasks);
+        else
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_container_pid                                         *
+ *                                                                            *
+ * Purpose: get first process of the container                                *
+ *                                                                            *
+ * Parameters: container - full container id                                 *
+ *             pid - buffer for process id                                    *
+ *             size - size of the buffer                                      *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - container has no process                  *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_container_pid(const char *container, char *pid, size_t size)
+{
+        char    *filename, buffer[64];
+        size_t  len;
+
+        filename = zbx_docker_cgroup_path("devices/", container, 1 == cgroup_v2 ? "/cgroup.procs" : "/tasks");
+        len = 0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)) ? strspn(buffer, "0123456789") : 0;
+        free(filename);
+        if (0 == len || len >= size)
+                return SYSINFO_RET_FAIL;
+
+        zbx_strlcpy(pid, buffer, len + 1);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_read_text                                             *
+ *                                                                            *
+ * Purpose: read whole file of unknown size                                   *
+ *                                                                            *
+ * Return value: allocated zero terminated content, NULL - cannot be read     *
+ *                                                                            *
+ ******************************************************************************/
+char    *zbx_docker_read_text(const char *filename)
+{
+        char    *buffer = NULL;
+        int     fd;
+        size_t  len = 0, alloc = 0;
+        ssize_t n;
+
+        if (-1 == (fd = open(filename, O_RDONLY | O_CLOEXEC)))
+                return NULL;
+
+        do
+        {
+                if (alloc - len < MAX_STRING_LEN)
+                {
+                        alloc += 4 * MAX_STRING_LEN;
+                        buffer = realloc(buffer, alloc);
+                }
+                n = read(fd, buffer + len, alloc - len - 1);
+                len += 0 < n ? (size_t)n : 0;
+        }
+        while (0 < n);
+        close(fd);
+
+        if (0 > n)
+        {
+                free(buffer);
+                return NULL;
+        }
+        buffer[len] = '\0';
+
+        return buffer;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_netproto_add                                          *
+ *                                                                            *
+ * Purpose: add one protocol counter to the container network namespace      *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_netproto_add(zbx_docker_netns_t *netns, const char *proto, size_t proto_len, const char *name,
+                const char *value)
+{
+        zbx_docker_netproto_value_t     *v;
+        char                            *end;
+        zbx_int64_t                     number;
+
+        number = strtoll(value, &end, 10);
+        if (end == value || ('\0' != *end && ' ' != *end && '\n' != *end))
+                return;
+
+        if (netns->values_num == netns->values_alloc)
+        {
+                netns->values_alloc = 0 == netns->values_alloc ? 256 : netns->values_alloc * 2;
+                netns->values = realloc(netns->values, sizeof(zbx_docker_netproto_value_t) * netns->values_alloc);
+        }
+        v = &netns->values[netns->values_num++];
+        zbx_strlcpy(v->proto, proto, MIN(sizeof(v->proto), proto_len + 1));
+        zbx_strlcpy(v->name, name, sizeof(v->name));
+        v->value = number;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_netproto_parse                                        *
+ *                                                                            *
+ * Purpose: parse protocol counters of /proc/<pid>/net/snmp, netstat or       *
+ *          sockstat                                                          *
+ *                                                                            *
+ * Parameters: netns - parsed values                                          *
+ *             buffer - file content                                          *
+ *             pairs - 1 - snmp and netstat, 0 - sockstat                     *
+ *                                                                            *
+ * Notes: snmp and netstat are pairs of lines 'Tcp: RtoAlgorithm RtoMin ...'  *
+ *        and 'Tcp: 1 200 ...', sockstat lines are name value pairs, e.g.     *
+ *        'TCP: inuse 5 orphan 0 tw 2 alloc 6 mem 1'                          *
+ ******************************************************************************/
+void    zbx_docker_netproto_parse(zbx_docker_netns_t *netns, char *buffer, int pairs)
+{
+        char    *line, *header = NULL, *colon, *name, *value, *saveptr_line, *saveptr_name, *saveptr;
+        size_t  proto_len, header_len = 0;
+
+        for (line = strtok_r(buffer, "\n", &saveptr_line); NULL != line; line = strtok_r(NULL, "\n", &saveptr_line))
+        {
+                if (NULL == (colon = strchr(line, ':')))
+                        continue;
+                proto_len = (size_t)(colon - line);
+
+                if (0 == pairs)
+                {
+                        for (name = strtok_r(colon + 1, " ", &saveptr); NULL != name;
+                                        name = strtok_r(NULL, " ", &saveptr))
+                        {
+                                if (NULL == (value = strtok_r(NULL, " ", &saveptr)))
+                                        break;
+                                zbx_docker_netproto_add(netns, line, proto_len, name, value);
+                        }
+                        continue;
+                }
+
+                if (NULL == header || header_len != proto_len || 0 != strncmp(header, line, proto_len))
+                {
+                        header = line;
+                        header_len = proto_len;
+                        continue;
+                }
+
+                // values of the previous header line
+                name = strtok_r(header + header_len + 1, " ", &saveptr_name);
+                value = strtok_r(colon + 1, " ", &saveptr);
+                for (; NULL != name && NULL != value; name = strtok_r(NULL, " ", &saveptr_name),
+                                value = strtok_r(NULL, " ", &saveptr))
+                {
+                        zbx_docker_netproto_add(netns, line, proto_len, name, value);
+                }
+                header = NULL;
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_netdev_parse                                          *
+ *                                                                            *
+ * Purpose: parse interface counters of /proc/<pid>/net/dev                   *
+ *                                                                            *
+ * Parameters: netns - parsed interfaces                                      *
+ *             buffer - file content                                          *
+ *                                                                            *
+ * Notes: two header lines and '  eth0: <rx bytes> <rx packets> ... ' lines   *
+ ******************************************************************************/
+void    zbx_docker_netdev_parse(zbx_docker_netns_t *netns, char *buffer)
+{
+        zbx_docker_netif_t      *netif;
+        char                    *line, *colon, *name, *value, *end, *saveptr;
+        int                     i;
+
+        for (line = strtok_r(buffer, "\n", &saveptr); NULL != line; line = strtok_r(NULL, "\n", &saveptr))
+        {
+                if (NULL == (colon = strchr(line, ':')))
+                        continue;
+                *colon = '\0';
+                for (name = line; ' ' == *name; name++)
+                        ;
+                if ('\0' == *name || NULL != strchr(name, '|'))
+                        continue;
+
+                if (netns->ifs_num == netns->ifs_alloc)
+                {
+                        netns->ifs_alloc = 0 == netns->ifs_alloc ? 8 : netns->ifs_alloc * 2;
+                        netns->ifs = realloc(netns->ifs, sizeof(zbx_docker_netif_t) * netns->ifs_alloc);
+                }
+                netif = &netns->ifs[netns->ifs_num];
+                zbx_strlcpy(netif->name, name, sizeof(netif->name));
+                for (i = 0, value = colon + 1; i < ZBX_DOCKER_NETDEV_COUNT; i++, value = end)
+                {
+                        netif->values[i] = strtoull(value, &end, 10);
+                        if (end == value)
+                                break;
+                }
+                if (ZBX_DOCKER_NETDEV_COUNT == i)
+                        netns->ifs_num++;
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_netns_get                                             *
+ *                                                                            *
+ * Purpose: get network namespace statistics of the container, files are read *
+ *          and parsed at most once per ZBX_DOCKER_NETNS_TTL                  *
+ *                                                                            *
+ * Return value: cached values, NULL - container has no process               *
+ *                                                                            *
+ * Notes: files are read from /proc of the first container process, so the   *
+ *        namespace is not entered, snmp, netstat, sockstat and dev are read  *
+ *        together                                                            *
+ ******************************************************************************/
+zbx_docker_netns_t      *zbx_docker_netns_get(const char *container)
+{
+        const char              *files[] = {"snmp", "netstat", "sockstat", "dev"};
+        zbx_docker_netns_t      *entry = &netns_cache[zbx_docker_id_hash(container) & (ZBX_DOCKER_NETNS_SIZE - 1)];
+        zbx_uint64_t            now = zbx_docker_stats_time();
+        char                    pid[32], *filename, *buffer;
+        size_t                  i;
+
+        if (0 != entry->time_us && now - entry->time_us < ZBX_DOCKER_NETNS_TTL && 0 == strcmp(entry->id, container))
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_NETNS, 1);
+                return entry;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_NETNS, 0);
+
+        entry->time_us = 0;
+        if (strlen(container) >= sizeof(entry->id) ||
+                        SYSINFO_RET_OK != zbx_docker_container_pid(container, pid, sizeof(pid)))
+        {
+                return NULL;
+        }
+
+        entry->values_num = 0;
+        entry->ifs_num = 0;
+        for (i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+        {
+                filename = zbx_dsprintf(NULL, "%s/proc/%s/net/%s", rootfs, pid, files[i]);
+                buffer = zbx_docker_read_text(filename);
+                free(filename);
+                if (NULL == buffer)
+                        continue;
+                if (3 == i)
+                        zbx_docker_netdev_parse(entry, buffer);
+                else
+                        zbx_docker_netproto_parse(entry, buffer, 2 != i);
+                free(buffer);
+        }
+        if (0 == entry->values_num && 0 == entry->ifs_num)
+                return NULL;
+
+        zbx_strlcpy(entry->id, container, sizeof(entry->id));
+        entry->time_us = now;
+
+        return entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_netproto                                       *
+ *                                                                            *
+ * Purpose: protocol statistics of container network namespace                *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: docker.netproto[cid,<protocol>,<counter>], e.g. Tcp,RetransSegs,    *
+ *        Tcp,CurrEstab (snmp), TcpExt,ListenDrops (netstat), TCP,tw          *
+ *        (sockstat)                                                          *
+ ******************************************************************************/
+int     zbx_module_docker_netproto(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_netproto()");
+        zbx_docker_netns_t      *netns;
+        char                    *container, *proto, *name;
+        int                     i;
+
+        if (3 != request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        proto = get_rparam(request, 1);
+        name = get_rparam(request, 2);
+        if (NULL == proto || '\0' == *proto || NULL == name || '\0' == *name)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid protocol or counter parameter"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (0 == zbx_docker_container_live(container) || NULL == (netns = zbx_docker_netns_get(container)))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not running"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        for (i = 0; i < netns->values_num; i++)
+        {
+                if (0 != strcmp(netns->values[i].proto, proto) || 0 != strcmp(netns->values[i].name, name))
+                        continue;
+
+                // items are unsigned, only few counters are signed, e.g. Tcp MaxConn -1 (no limit)
+                if (0 > netns->values[i].value)
+                {
+                        SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Counter %s %s is negative: " ZBX_FS_I64, proto,
+                                        name, netns->values[i].value));
+                        return SYSINFO_RET_FAIL;
+                }
+                SET_UI64_RESULT(result, (zbx_uint64_t)netns->values[i].value);
+                return SYSINFO_RET_OK;
+        }
+
+        SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Counter %s %s is not found", proto, name));
+        return SYSINFO_RET_FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_net_discovery                                  *
+ *                                                                            *
+ * Purpose: network interfaces of the container                               *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: docker.net.discovery[cid], interfaces of /proc/<pid>/net/dev        *
+ *        {"data":[{"{#IFNAME}":"eth0"},...]}                                 *
+ ******************************************************************************/
+int     zbx_module_docker_net_discovery(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_net_discovery()");
+        zbx_docker_netns_t      *netns;
+        char                    *container;
+        int                     i;
+
+        if (1 != request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (0 == zbx_docker_container_live(container) || NULL == (netns = zbx_docker_netns_get(container)) ||
+                        0 == netns->ifs_num)
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Container is not running"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        json_t *a = json_array();
+        for (i = 0; i < netns->ifs_num; i++)
+        {
+                json_t *o = json_object();
+                json_object_set_new(o, "{#IFNAME}", json_string(netns->ifs[i].name));
+                json_array_append_new(a, o);
+        }
+
+        json_t *j_data = json_object();
+        json_object_set_new(j_data, "data", a);
+        SET_STR_RESULT(result, json_dumps(j_data, 0));
+        json_decref(j_data);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_netdev_value                                          *
+ *                                                                            *
+ * Purpose: get interface counter of the container from /proc/<pid>/net/dev   *
+ *                                                                            *
+ * Parameters: container - full container id                                  *
+ *             netif - interface name, all - sum of all interfaces            *
+ *             metric - netstat -i column (RX-OK, ...) or rx_bytes, ...       *
+ *             value - counter value                                          *
+ *             error - error message, must be freed                           *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - error is set                              *
+ *               SYSINFO_RET_OK - value is set                                *
+ *               -1 - metric is not available in /proc/<pid>/net/dev         *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_netdev_value(const char *container, const char *netif, const char *metric, zbx_uint64_t *value,
+                char **error)
+{
+        zbx_docker_netns_t      *netns;
+        int                     i, index = -1, found = 0;
+
+        for (i = 0; i < ZBX_DOCKER_NETDEV_COUNT && -1 == index; i++)
+        {
+                if (0 == strcmp(netdev_metrics[i], metric))
+                        index = i;
+        }
+        for (i = 0; i < (int)(sizeof(netdev_netstat) / sizeof(netdev_netstat[0])) && -1 == index; i++)
+        {
+                if (0 == strcmp(netdev_netstat[i].name, metric))
+                        index = netdev_netstat[i].index;
+        }
+        if (-1 == index)
+                return -1;
+
+        if (0 == zbx_docker_container_live(container) || NULL == (netns = zbx_docker_netns_get(container)) ||
+                        0 == netns->ifs_num)
+        {
+                *error = zbx_strdup(NULL, "Container is not running");
+                return SYSINFO_RET_FAIL;
+        }
+
+        *value = 0;
+        for (i = 0; i < netns->ifs_num; i++)
+        {
+                if (0 != strcmp(netif, "all") && 0 != strcmp(netif, netns->ifs[i].name))
+                        continue;
+                *value += netns->ifs[i].values[index];
+                found = 1;
+        }
+        if (0 == found)
+        {
+                *error = zbx_dsprintf(NULL, "Interface %s is not found", netif);
+                return SYSINFO_RET_FAIL;
+        }
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_net                                            *
+ *                                                                            *
+ * Purpose: container network metrics                                         *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_net(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_net()");
+        char            *container, *metric, *interfacec, *error = NULL;
+        zbx_uint64_t    counter;
+        int             ret;
+
+        if (3 != request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        // counters of /proc/<pid>/net/dev don't need netns and netstat
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        ret = zbx_docker_netdev_value(container, get_rparam(request, 1), get_rparam(request, 2), &counter, &error);
+        if (SYSINFO_RET_OK == ret)
+        {
+                SET_UI64_RESULT(result, counter);
+                return SYSINFO_RET_OK;
+        }
+        if (SYSINFO_RET_FAIL == ret)
+        {
+                SET_MSG_RESULT(result, error);
+                return SYSINFO_RET_FAIL;
+        }
+
+        if(geteuid() != 0)
+        {
+            zabbix_log(LOG_LEVEL_ERR, "docker.net metrics requires root permissions");
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.net metrics requires root permissions"));
+            return SYSINFO_RET_FAIL;
+        }
+        struct stat st = {0};
+
+        if(stat("/var/run/netns", &st) == -1)
+        {
+            if(mkdir("/var/run/netns", 0755) != 0)
+            {
+                zabbix_log(LOG_LEVEL_ERR, "Cannot create /var/run/netns");
+                SET_MSG_RESULT(result, strdup("Cannot create /var/run/netns"));
+                return SYSINFO_RET_FAIL;
+            }
+        }
+
+        interfacec = get_rparam(request, 1);
+        metric = get_rparam(request, 2);
+        const char* znetns_prefix = "zabbix_module_docker_";
+
+        char    *filename = zbx_docker_arena_dsprintf("/var/run/netns/%s%s", znetns_prefix, container);
+        char    *netns = filename + strlen("/var/run/netns/");
+
+        zabbix_log(LOG_LEVEL_DEBUG, "netns file: %s", filename);
+        if(access(filename, F_OK ) == -1)
+        {
+            // create netns
+            // get first task
+            char    first_task[32];
+            if (SYSINFO_RET_OK != zbx_docker_container_pid(container, first_task, sizeof(first_task)))
+            {
+                zabbix_log(LOG_LEVEL_ERR, "Cannot read first task of container %s", container);
+                SET_MSG_RESULT(result, strdup("Cannot open Docker tasks file"));
+                return SYSINFO_RET_FAIL;
+            }
+            zabbix_log(LOG_LEVEL_DEBUG, "First task for container %s: %s", container, first_task);
+
+            // soft link - new netns
+            char* netns_source = zbx_docker_arena_dsprintf("/proc/%s/ns/net", first_task);
+
+            // remove broken link - container has been restarted
+            if(access(filename, F_OK ) == -1)
+            {
+                if(unlink(filename) != 0)
+                {
+                    zabbix_log(LOG_LEVEL_WARNING, "%s: %s", filename, zbx_strerror(errno));
+                }
+            }
+
+            if(symlink(netns_source, filename) != 0) {
+                zabbix_log(LOG_LEVEL_ERR, "Cannot create netns symlink: %s -> %s", filename, netns_source);
+                SET_MSG_RESULT(result, strdup("Cannot create netns symlink"));
+                return SYSINFO_RET_FAIL;
+            }
+        }
+
+        // execute ip netns exec filename netstat -i
+        FILE *fp;
+        char line[MAX_STRING_LEN];
+        char* command = zbx_docker_arena_dsprintf("ip netns exec %s netstat -i", netns);
+        zabbix_log(LOG_LEVEL_DEBUG, "netns command: %s", command);
+
+        fp = popen(command, "r");
+        if (fp == NULL)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot execute netns command");
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot execute netns command"));
+            return SYSINFO_RET_FAIL;
+        }
+
+        /*
+        [root@dev ~]# ip netns exec $CID netstat -i
+        Kernel Interface table
+        Iface      MTU    RX-OK RX-ERR RX-DRP RX-OVR    TX-OK TX-ERR TX-DRP TX-OVR Flg
+        eth0      1500  1238410      0      0 0       1836070      0      0      0 BRU
+        lo       65536  1856189      0      0 0       1856189      0      0      0 LRU
+        */
+
+        int metric_pos = 0;
+        int pos = 0;
+        char *pch;
+        int value = 0;
+        while(fgets(line, sizeof(line), fp) != NULL)
+        {
+            // skip first line
+            if (0 == strncmp(line, "Kernel Interface table", strlen("Kernel Interface table")))
+                continue;
+
+            if(metric_pos == INT_MAX)
+            {
+                zabbix_log(LOG_LEVEL_DEBUG, "Not found metric %s", metric);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Not found net metric"));
+                pclose(fp);
+                return SYSINFO_RET_FAIL;
+            }
+
+            // second line find position
+            if(metric_pos == 0)
+            {
+                int found = 0;
+                pch = strtok(line," ");
+                while (pch != NULL)
+                {
+                    if(0 != strncmp(pch, metric, strlen(metric)))
+                    {
+                       pch = strtok(NULL, " ");
+                       metric_pos++;
+                       continue;
+                    } else {
+                       found = 1;
+                       break;
+                    }
+                }
+                if(found == 0)
+                {
+                    metric_pos = INT_MAX;
+                    continue;
+                }
+            }
+
+            // find selected interface and metric
+            if(strcmp(interfacec, "all") == 0)
+            {
+                // find value at metric_pos and sum
+                pch = strtok(line," ");
+                pos = 0;
+                while (pch != NULL)
+                {
+                    if(pos < metric_pos)
+                    {
+                       pch = strtok(NULL, " ");
+                       pos++;
+                       continue;
+                    } else {
+                       value += atoi(pch);
+                       break;
+                    }
+                }
+
+            } else {
+                // skip lines which doesn't match interface
+                if (0 != strncmp(line, interfacec, strlen(interfacec)))
+                {
+                    continue;
+                }
+
+                // find value at metric_pos
+                pch = strtok(line," ");
+                pos = 0;
+                while (pch != NULL)
+                {
+                    if(pos != metric_pos)
+                    {
+                       pch = strtok(NULL, " ");
+                       pos++;
+                       continue;
+                    } else {
+                       value = atoi(pch);
+                       zabbix_log(LOG_LEVEL_DEBUG, "found metric %s: %d", metric, value);
+                       SET_UI64_RESULT(result, value);
+                       pclose(fp);
+                       return SYSINFO_RET_OK;
+                    }
+                }
+            }
+        }
+        zabbix_log(LOG_LEVEL_DEBUG, "found metric %s: %d", metric, value);
+        SET_UI64_RESULT(result, value);
+        pclose(fp);
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_uninit                                                *
+ *                                                                            *
+ * Purpose: the function is called on agent shutdown                          *
+ *          It should be used to cleanup used resources if there are any      *
+ *                                                                            *
+ * Return value: ZBX_MODULE_OK - success                                      *
+ *               ZBX_MODULE_FAIL - function failed                            *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_uninit()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_uninit()");
+        zbx_docker_sampler_uninit();
+        zbx_docker_events_uninit();
+        zbx_docker_info_uninit();
+        zbx_docker_live_reset();
+        free(live.ids);
+        live.ids = NULL;
+        live.ids_alloc = 0;
+
+        const char* znetns_prefix = "zabbix_module_docker_";
+        int             i;
+        DIR             *dir;
+        struct dirent   *d;
+
+        char *file = NULL;
+        if (NULL == (dir = opendir("/var/run/netns")))
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "/var/run/netns: %s", zbx_strerror(errno));
+        }
+        while (NULL != dir && NULL != (d = readdir(dir)))
+        {
+            if(0 == strcmp(d->d_name, ".") || 0 == strcmp(d->d_name, ".."))
+                continue;
+
+            // delete zabbix netns
+            if ((strstr(d->d_name, znetns_prefix)) != NULL)
+            {
+                file = zbx_dsprintf(file, "/var/run/netns/%s", d->d_name);
+                if(unlink(file) != 0)
+                {
+                    zabbix_log(LOG_LEVEL_WARNING, "%s: %s", d->d_name, zbx_strerror(errno));
+                }
+            }
+        }
+        if(NULL != dir && 0 != closedir(dir))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "/var/run/netns/: %s", zbx_strerror(errno));
+        }
+        free(file);
+
+        free(stat_dir);
+        free(docker_socket);
+        if ('\0' != *rootfs)
+        {
+            free(rootfs);
+        }
+        if (NULL != stats && stats != stats_slot)
+        {
+            munmap(stats, sizeof(zbx_docker_stats_t) * ZBX_DOCKER_STATS_SLOTS);
+        }
+        stats = stats_slot = NULL;
+        if (NULL != trace)
+        {
+            munmap(trace, sizeof(zbx_docker_trace_ring_t));
+            trace = NULL;
+        }
+        zbx_docker_store_free();
+        zbx_docker_arena_reset();
+        free(arena);
+        arena = NULL;
+        for (i = 0; i < ZBX_DOCKER_PERCPU_SIZE; i++)
+        {
+            free(percpu[i].values);
+        }
+        memset(percpu, 0, sizeof(percpu));
+        memset(cpu_usage_cache, 0, sizeof(cpu_usage_cache));
+        memset(numa_cache, 0, sizeof(numa_cache));
+        for (i = 0; i < ZBX_DOCKER_BLKIO_SIZE; i++)
+        {
+            free(blkio_cache[i].path);
+            free(blkio_cache[i].values);
+        }
+        memset(blkio_cache, 0, sizeof(blkio_cache));
+        for (i = 0; i < ZBX_DOCKER_NETNS_SIZE; i++)
+        {
+            free(netns_cache[i].values);
+            free(netns_cache[i].ifs);
+        }
+        memset(netns_cache, 0, sizeof(netns_cache));
+        for (i = 0; i < ZBX_DOCKER_PATH_SIZE; i++)
+        {
+            free(path_cache[i].key);
+            free(path_cache[i].buffer);
+            free(path_cache[i].steps);
+        }
+        memset(path_cache, 0, sizeof(path_cache));
+        for (i = 0; i < ZBX_DOCKER_DOCUMENT_SIZE; i++)
+        {
+            free(document_cache[i].body);
+        }
+        memset(document_cache, 0, sizeof(document_cache));
+        if (NULL != rates)
+        {
+            munmap(rates, sizeof(zbx_docker_rate_t) * ZBX_DOCKER_RATE_SIZE);
+            rates = NULL;
+        }
+
+        return ZBX_MODULE_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_config_init                                           *
+ *                                                                            *
+ * Purpose: read module configuration from the agent environment              *
+ *                                                                            *
+ * Notes: Zabbix doesn't pass any configuration to loadable modules, so       *
+ *        module options are environment variables of zabbix_agentd process:  *
+ *        DOCKER_HOST - Docker socket, only unix:// scheme is supported,      *
+ *                      default unix:///var/run/docker.sock                   *
+ *        ZBX_DOCKER_ROOTFS - prefix of /proc and cgroup paths, e.g. host     *
+ *                      root mounted in agent container or cgroup fixtures    *
+ *        ZBX_DOCKER_STATS_CGROUP=1 - docker.stats from cgroups               *
+ *        ZBX_DOCKER_SCHED - docker.sched interval in seconds, 0 - disabled   *
+ *        ZBX_DOCKER_INFO_TTL - docker.info cache TTL in seconds, 0 - no cache *
+ ******************************************************************************/
+void    zbx_docker_config_init()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_config_init()");
+        const char *docker_host = getenv("DOCKER_HOST"), *socket_path = ZBX_DOCKER_SOCKET, *value;
+
+        if (docker_host != NULL && *docker_host != '\0')
+        {
+            if (strncmp(docker_host, "unix://", strlen("unix://")) != 0)
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Only unix:// DOCKER_HOST is supported, ignoring DOCKER_HOST=%s", docker_host);
+            } else if (strlen(docker_host + strlen("unix://")) >= sizeof(((struct sockaddr_un *)0)->sun_path)) {
+                zabbix_log(LOG_LEVEL_WARNING, "Docker socket path is too long, ignoring DOCKER_HOST=%s", docker_host);
+            } else {
+                socket_path = docker_host + strlen("unix://");
+            }
+        }
+        docker_socket = zbx_strdup(docker_socket, socket_path);
+        zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket: %s", docker_socket);
+
+        if (NULL != (value = getenv("ZBX_DOCKER_ROOTFS")) && *value != '\0')
+        {
+            // paths are <rootfs>/proc/..., so trailing '/' is removed
+            size_t len = strlen(value);
+            while (len > 0 && value[len - 1] == '/')
+            {
+                len--;
+            }
+            if (len > 0)
+            {
+                rootfs = zbx_dsprintf(NULL, "%.*s", (int)len, value);
+                zabbix_log(LOG_LEVEL_DEBUG, "Root filesystem prefix: %s", rootfs);
+            }
+        }
+
+        if (NULL != (value = getenv("ZBX_DOCKER_SAMPLER")) && *value != '\0')
+        {
+            sampler_interval = atoi(value);
+            if (sampler_interval < 0 || sampler_interval > 60)
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Invalid ZBX_DOCKER_SAMPLER=%s, sampler interval must be 1-60 seconds", value);
+                sampler_interval = 0;
+            }
+        }
+
+        if (NULL != (value = getenv("ZBX_DOCKER_SCHED")) && *value != '\0')
+        {
+            sched_interval = atoi(value);
+            if (sched_interval < 0 || sched_interval > 600)
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Invalid ZBX_DOCKER_SCHED=%s, scheduler statistics interval must be 1-600 seconds", value);
+                sched_interval = 0;
+            }
+        }
+
+        if (NULL != (value = getenv("ZBX_DOCKER_EVENTS")) && 0 == strcmp(value, "1"))
+        {
+            events_enabled = 1;
+        }
+
+        if (NULL != (value = getenv("ZBX_DOCKER_STATS_CGROUP")) && 0 == strcmp(value, "1"))
+        {
+            stats_cgroup = 1;
+        }
+
+        if (NULL != (value = getenv("ZBX_DOCKER_INFO_TTL")) && *value != '\0')
+        {
+            info_ttl = atoi(value);
+            if (info_ttl < 0 || info_ttl > 3600)
+            {
+                zabbix_log(LOG_LEVEL_WARNING, "Invalid ZBX_DOCKER_INFO_TTL=%s, docker.info cache TTL must be 0-3600 seconds", value);
+                info_ttl = ZBX_DOCKER_INFO_TTL;
+            }
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_init                                                  *
+ *                                                                            *
+ * Purpose: the function is called on agent startup                           *
+ *          It should be used to call any initialization routines             *
+ *                                                                            *
+ * Return value: ZBX_MODULE_OK - success                                      *
+ *               ZBX_MODULE_FAIL - module initialization failed               *
+ *                                                                            *
+ * Comment: the module won't be loaded in case of ZBX_MODULE_FAIL             *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_init()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_init()");
+        zabbix_log(LOG_LEVEL_DEBUG, "zabbix_module_docker %s, compilation time: %s %s", m_version, __DATE__, __TIME__);
+        zbx_docker_config_init();
+        zbx_docker_stats_init();
+        zbx_docker_rate_init();
+        clk_tck = sysconf(_SC_CLK_TCK);
+        page_size = sysconf(_SC_PAGESIZE);
+        cpu_online = sysconf(_SC_NPROCESSORS_ONLN);
+        zbx_docker_dir_detect();
+        zbx_docker_api_detect();
+        zbx_docker_arena_reset();
+        zbx_docker_sampler_init();
+        zbx_docker_events_init();
+        zbx_docker_info_init();
+        return ZBX_MODULE_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_inspect                                        *
+ *                                                                            *
+ * Purpose: container inspection                                              *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_inspect(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_inspect()");
+        struct inspect_result iresult;
+        const char *path = get_rparam(request, 1);
+        // docker.inspect[cid,<path expression>]
+        if (2 == request->nparam && NULL != path && NULL != strpbrk(path, ".["))
+        {
+            return zbx_docker_path_item(request, result, ZBX_DOCKER_ENDPOINT_INSPECT);
+        }
+        iresult = zbx_module_docker_inspect_exec(get_rparam(request, 0), get_rparam(request, 1), get_rparam(request, 2), get_rparam(request, 3));
+        if (iresult.return_code == SYSINFO_RET_OK) {
+            zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec OK: %s", iresult.value);
+            SET_STR_RESULT(result, zbx_strdup(NULL, iresult.value));
+            return iresult.return_code;
+        } else {
+            zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec FAIL: %s", iresult.value);
+            SET_MSG_RESULT(result, zbx_strdup(NULL, iresult.value));
+            return iresult.return_code;
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_driver_dir                                            *
+ *                                                                            *
+ * Purpose: path of the cgroup driver directory with container cgroups        *
+ *                                                                            *
+ * Return value: path, it must be freed by caller                             *
+ *                                                                            *
+ ******************************************************************************/
+char    *zbx_docker_driver_dir()
+{
+        return zbx_dsprintf(NULL, "%s%s%s", stat_dir, 1 == cgroup_v2 ? "" : "cpuset/", driver);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_container_id                                          *
+ *                                                                            *
+ * Purpose: get container id from the name of cgroup directory                *
+ *                                                                            *
+ * Parameters: name - directory name, it is modified                          *
+ *                                                                            *
+ * Return value: full container id, NULL - directory is not a container       *
+ *                                                                            *
+ ******************************************************************************/
+char    *zbx_docker_container_id(char *name)
+{
+        char    *containerid;
+
+        if(0 == strcmp(name, ".") || 0 == strcmp(name, ".."))
+                return NULL;
+
+        // systemd docker: skip other units in the slice (docker-<fci>.scope only)
+        if ((c_prefix != NULL && 0 != strncmp(name, c_prefix, strlen(c_prefix))) ||
+                (c_suffix != NULL && (strlen(name) < strlen(c_suffix) ||
+                0 != strcmp(name + strlen(name) - strlen(c_suffix), c_suffix))))
+                return NULL;
+
+        // systemd docker: remove suffix (.scope)
+        if (c_suffix != NULL)
+        {
+            containerid = strtok(name, ".");
+        } else {
+            containerid = name;
+        }
+
+        // systemd docker: remove preffix (docker-)
+        if (c_prefix != NULL)
+        {
+            containerid = strtok(containerid, "-");
+            containerid = strtok(NULL, "-");
+        } else {
+            containerid = name;
+        }
+
+        return containerid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_containers_scan                                       *
+ *                                                                            *
+ * Purpose: read running containers from the cgroup driver directory          *
+ *                                                                            *
+ * Parameters: callback - called with full container id of every container   *
+ *             arg - callback argument                                        *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - driver directory cannot be read           *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_containers_scan(void (*callback)(const char *container, void *arg), void *arg)
+{
+        DIR             *dir;
+        zbx_stat_t      sb;
+        char            *file = NULL, *containerid, *ddir = zbx_docker_driver_dir();
+        struct dirent   *d;
+
+        if (NULL == (dir = opendir(ddir)))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "%s: %s", ddir, zbx_strerror(errno));
+            free(ddir);
+            return SYSINFO_RET_FAIL;
+        }
+
+        while (NULL != (d = readdir(dir)))
+        {
+                // cgroup pseudo-files are skipped, stat() only if file type is unknown
+                if (DT_DIR != d->d_type)
+                {
+                        if (DT_UNKNOWN != d->d_type)
+                                continue;
+                        file = zbx_dsprintf(file, "%s/%s", ddir, d->d_name);
+                        if (0 != zbx_stat(file, &sb) || 0 == S_ISDIR(sb.st_mode))
+                                continue;
+                }
+
+                if (NULL != (containerid = zbx_docker_container_id(d->d_name)))
+                {
+                        callback(containerid, arg);
+                }
+        }
+
+        if(0 != closedir(dir))
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "%s: %s\n", ddir, zbx_strerror(errno));
+        }
+
+        free(file);
+        free(ddir);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_live_find                                             *
+ *                                                                            *
+ * Purpose: find container in the live set                                    *
+ *                                                                            *
+ * Return value: index of the container or of the first free/removed entry   *
+ *               where it can be added                                        *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_live_find(const char *id, int *found)
+{
+        unsigned int    i = zbx_docker_id_hash(id) & (live.ids_alloc - 1);
+        int             first = -1;
+
+        for (*found = 0; NULL != live.ids[i]; i = (i + 1) & (live.ids_alloc - 1))
+        {
+                if (ZBX_DOCKER_LIVE_REMOVED == live.ids[i])
+                {
+                        if (-1 == first)
+                                first = i;
+                }
+                else if (0 == strcmp(live.ids[i], id))
+                {
+                        *found = 1;
+                        return i;
+                }
+        }
+
+        return -1 == first ? (int)i : first;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_live_add                                              *
+ *                                                                            *
+ * Purpose: add container to the live set, callback of the directory scan     *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_live_add(const char *id, void *arg)
+{
+        int     i, found;
+
+        // rehash without removed entries if the table is 3/4 full
+        if ((live.ids_num + live.removed_num + 1) * 4 > live.ids_alloc * 3)
+        {
+                char    **ids = live.ids;
+                int     ids_alloc = live.ids_alloc, j;
+
+                while ((live.ids_num + 1) * 2 > live.ids_alloc)
+                        live.ids_alloc *= 2;
+                live.ids = calloc(live.ids_alloc, sizeof(char *));
+                live.removed_num = 0;
+                for (j = 0; j < ids_alloc; j++)
+                {
+                        if (NULL != ids[j] && ZBX_DOCKER_LIVE_REMOVED != ids[j])
+                                live.ids[zbx_docker_live_find(ids[j], &found)] = ids[j];
+                }
+                free(ids);
+        }
+
+        i = zbx_docker_live_find(id, &found);
+        if (1 == found)
+                return;
+        if (ZBX_DOCKER_LIVE_REMOVED == live.ids[i])
+                live.removed_num--;
+        live.ids[i] = zbx_strdup(NULL, id);
+        live.ids_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_live_reset                                            *
+ *                                                                            *
+ * Purpose: stop container tracking and free the live set                     *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_live_reset()
+{
+        int     i;
+
+        if (-1 != live.fd)
+                close(live.fd);
+        live.fd = -1;
+        for (i = 0; i < live.ids_alloc; i++)
+        {
+                if (ZBX_DOCKER_LIVE_REMOVED != live.ids[i])
+                        free(live.ids[i]);
+                live.ids[i] = NULL;
+        }
+        live.ids_num = live.removed_num = 0;
+        free(live.dir);
+        live.dir = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_live_init                                             *
+ *                                                                            *
+ * Purpose: start inotify tracking of the driver directory and read current   *
+ *          containers                                                        *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - inotify cannot be used                    *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_live_init(char *dir)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_live_init() dir:'%s'", dir);
+
+        zbx_docker_live_reset();
+        live.pid = getpid();
+        if (NULL == live.ids)
+        {
+                live.ids_alloc = 64;
+                live.ids = calloc(live.ids_alloc, sizeof(char *));
+        }
+
+        // watch is added before the scan, so no container is missed
+        if (-1 == (live.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) ||
+                        -1 == inotify_add_watch(live.fd, dir, IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                        IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Cannot watch %s: %s, containers will be read by readdir()", dir,
+                        zbx_strerror(errno));
+                zbx_docker_live_reset();
+                live.failed = time(NULL);
+                free(dir);
+                return SYSINFO_RET_FAIL;
+        }
+        live.dir = dir;
+
+        if (SYSINFO_RET_OK != zbx_docker_containers_scan(zbx_docker_live_add, NULL))
+        {
+                zbx_docker_live_reset();
+                live.failed = time(NULL);
+                return SYSINFO_RET_FAIL;
+        }
+        zabbix_log(LOG_LEVEL_DEBUG, "Tracking %d containers in %s", live.ids_num, live.dir);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_live_update                                           *
+ *                                                                            *
+ * Purpose: apply pending inotify events to the live set                      *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - tracking is not available, driver         *
+ *                                  directory must be read                    *
+ *               SYSINFO_RET_OK - live set is up to date                      *
+ *                                                                            *
+ * Notes: every agent process has its own inotify instance, the events are    *
+ *        read without blocking when the set is used; caller must hold        *
+ *        live_lock                                                           *
+ ******************************************************************************/
+int     zbx_docker_live_update()
+{
+        char    buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event)))), name[NAME_MAX + 1];
+        char    *dir, *id;
+        ssize_t len, pos;
+
+        if (stat_dir == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
+                return SYSINFO_RET_FAIL;
+
+        if (live.pid != getpid())
+        {
+                // live set of the parent process is inherited by fork(), it is dropped, not freed; the inherited
+                // inotify descriptor shares the event queue of the parent, so it is closed
+                if (-1 != live.fd)
+                        close(live.fd);
+                memset(&live, 0, sizeof(live));
+                live.fd = -1;
+        }
+
+        dir = zbx_docker_driver_dir();
+        if (-1 == live.fd || 0 != strcmp(dir, live.dir))
+        {
+                if (0 != live.failed && time(NULL) - live.failed < ZBX_DOCKER_LIVE_RETRY)
+                {
+                        free(dir);
+                        return SYSINFO_RET_FAIL;
+                }
+                return zbx_docker_live_init(dir);
+        }
+        free(dir);
+
+        while (0 < (len = read(live.fd, buffer, sizeof(buffer))))
+        {
+                for (pos = 0; pos < len; pos += sizeof(struct inotify_event) + ((struct inotify_event *)(buffer + pos))->len)
+                {
+                        struct inotify_event    *event = (struct inotify_event *)(buffer + pos);
+                        int                     i, found;
+
+                        if (0 != (event->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)))
+                        {
+                                // events were lost or the directory was removed
+                                zabbix_log(LOG_LEVEL_DEBUG, "Container tracking of %s is restarted, event mask: 0x%x",
+                                        live.dir, event->mask);
+                                return zbx_docker_live_init(zbx_docker_driver_dir());
+                        }
+                        if (0 == event->len || 0 == (event->mask & IN_ISDIR))
+                                continue;
+
+                        zbx_strlcpy(name, event->name, sizeof(name));
+                        if (NULL == (id = zbx_docker_container_id(name)))
+                                continue;
+
+                        if (0 != (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                        {
+                                zbx_docker_live_add(id, NULL);
+                        }
+                        else if (1 == (i = zbx_docker_live_find(id, &found), found))
+                        {
+                                free(live.ids[i]);
+                                live.ids[i] = ZBX_DOCKER_LIVE_REMOVED;
+                                live.ids_num--;
+                                live.removed_num++;
+                        }
+                }
+        }
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_container_live                                        *
+ *                                                                            *
+ * Purpose: check if container is running according to the live set          *
+ *                                                                            *
+ * Return value: 1 - container is running, 0 - container is not running,      *
+ *               -1 - unknown (tracking is not available or container is      *
+ *               identified by cgroup directory name)                         *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_container_live(const char *container)
+{
+        int     ret = -1, found;
+
+        if (NULL != strchr(container, '.'))
+                return -1;
+
+        pthread_mutex_lock(&live_lock);
+        if (SYSINFO_RET_OK == zbx_docker_live_update())
+        {
+                zbx_docker_live_find(container, &found);
+                ret = found;
+        }
+        pthread_mutex_unlock(&live_lock);
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_live_prepare                                          *
+ *                                                                            *
+ * Purpose: fork handlers - live set is not modified during fork() (sampler   *
+ *          thread)                                                           *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_live_prepare()
+{
+        pthread_mutex_lock(&live_lock);
+}
+
+void    zbx_docker_live_release()
+{
+        pthread_mutex_unlock(&live_lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_live_atfork                                           *
+ *                                                                            *
+ * Purpose: register fork handlers of the live set once, background threads   *
+ *          use it and it must not be locked when agent forks                 *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_live_atfork()
+{
+        static int      registered = 0;
+
+        if (0 == registered++)
+                pthread_atfork(zbx_docker_live_prepare, zbx_docker_live_release, zbx_docker_live_release);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_containers_enum                                       *
+ *                                                                            *
+ * Purpose: enumerate running containers                                      *
+ *                                                                            *
+ * Parameters: callback - called with full container id of every container   *
+ *             arg - callback argument                                        *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - driver directory cannot be read           *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: containers are taken from the live set maintained by inotify, the   *
+ *        driver directory is read only if inotify is not available; ids are  *
+ *        copied, so callbacks (e.g. sampler reading /proc of all tasks) run  *
+ *        without live_lock, which blocks item calls of all collectors        *
+ ******************************************************************************/
+int     zbx_docker_containers_enum(void (*callback)(const char *container, void *arg), void *arg)
+{
+        char    **ids = NULL;
+        int     ret, i, ids_num = 0;
+
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_containers_enum()");
+
+        if(stat_dir == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "Containers cannot be enumerated at the moment - no stat directory");
+            return SYSINFO_RET_FAIL;
+        }
+
+        pthread_mutex_lock(&live_lock);
+        if (SYSINFO_RET_OK == (ret = zbx_docker_live_update()) && 0 < live.ids_alloc)
+        {
+                ids = malloc(sizeof(char *) * live.ids_alloc);
+                for (i = 0; i < live.ids_alloc; i++)
+                {
+                        if (NULL != live.ids[i] && ZBX_DOCKER_LIVE_REMOVED != live.ids[i])
+                                ids[ids_num++] = zbx_strdup(NULL, live.ids[i]);
+                }
+        }
+        pthread_mutex_unlock(&live_lock);
+
+        for (i = 0; i < ids_num; i++)
+        {
+                callback(ids[i], arg);
+                free(ids[i]);
         }
-        size_t  filename_size = strlen(cgroup) + strlen(container) + strlen(stat_dir) + strlen(driver) + strlen(stat_file) + 2;
-        if (strstr(container, ".") == NULL) {
-            if (c_prefix != NULL)
-            {
-                filename_size += strlen(c_prefix);
+        free(ids);
+
+        if (SYSINFO_RET_OK != ret)
+                ret = zbx_docker_containers_scan(callback, arg);
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_discovery_basic_add                                   *
+ *                                                                            *
+ * Purpose: add container to basic discovery                                  *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_discovery_basic_add(const char *containerid, void *arg)
+{
+        char    scontainerid[13];
+        json_t  *o = json_object();
+
+        json_object_set_new(o, "{#FCONTAINERID}", json_string(containerid));
+        zbx_strlcpy(scontainerid, containerid, 13);
+        json_object_set_new(o, "{#HCONTAINERID}", json_string(scontainerid));
+        json_object_set_new(o, "{#SCONTAINERID}", json_string(scontainerid));
+        json_object_set_new(o, "{#SYSTEM.HOSTNAME}", json_string(hostname));
+        json_array_append_new((json_t *)arg, o);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_discovery_basic                                *
+ *                                                                            *
+ * Purpose: container discovery                                               *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_discovery_basic(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_discovery_basic()");
+
+        if(stat_dir == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
+        {
+            zabbix_log(LOG_LEVEL_DEBUG, "docker.discovery is not available at the moment - no stat directory - empty discovery");
+            json_t *j = json_object();
+            json_object_set_new(j, "data", json_array());
+            SET_STR_RESULT(result, json_dumps(j, 0));
+            json_decref(j);
+            return SYSINFO_RET_FAIL;
+        }
+
+        size_t hostname_len = 128;
+        while (1) {
+            char* realloc_hostname = realloc(hostname, hostname_len);
+            if (realloc_hostname == 0) {
+                free(hostname);
             }
-            if (c_suffix != NULL)
-            {
-                filename_size += strlen(c_suffix);
+            hostname = realloc_hostname;
+            hostname[hostname_len-1] = 0;
+            if (gethostname(hostname, hostname_len-1) == 0) {
+                size_t count = strlen(hostname);
+                if (count < hostname_len-2) {
+                    break;
+                }
             }
+            hostname_len *= 2;
+        }
+
+        json_t *a = json_array();
+
+        if (SYSINFO_RET_OK != zbx_docker_containers_enum(zbx_docker_discovery_basic_add, a))
+        {
+            json_decref(a);
+            return SYSINFO_RET_FAIL;
+        }
+
+        json_t *j = json_object();
+        json_object_set_new(j, "data", a);
+
+        SET_STR_RESULT(result, json_dumps(j, 0));
+
+        json_decref(j);
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_index                                           *
+ *                                                                            *
+ * Purpose: rebuild container id -> slot index of the store                   *
+ *                                                                            *
+ * Notes: index is rebuilt after every enumeration, so there are no           *
+ *        tombstones of removed containers                                    *
+ ******************************************************************************/
+void    zbx_docker_store_index()
+{
+        int     size = 16, slot;
+
+        while (size < store.live_num * 2)
+                size *= 2;
+
+        if (size - 1 != store.index_mask)
+        {
+                store.index = realloc(store.index, sizeof(int) * size);
+                store.index_mask = size - 1;
+        }
+        memset(store.index, 0, sizeof(int) * size);
+
+        for (slot = 0; slot < store.slots_num; slot++)
+        {
+                unsigned int    i;
+
+                if (NULL == store.ids[slot])
+                        continue;
+
+                for (i = zbx_docker_id_hash(store.ids[slot]) & store.index_mask; 0 != store.index[i];
+                                i = (i + 1) & store.index_mask)
+                        ;
+                store.index[i] = slot + 1;
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_find                                            *
+ *                                                                            *
+ * Purpose: find slot of the container in the store                           *
+ *                                                                            *
+ * Return value: slot, -1 - container is not in the store                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_store_find(const char *id)
+{
+        unsigned int    i;
+
+        if (NULL == store.index)
+                return -1;
+
+        for (i = zbx_docker_id_hash(id) & store.index_mask; 0 != store.index[i]; i = (i + 1) & store.index_mask)
+        {
+                if (0 == strcmp(store.ids[store.index[i] - 1], id))
+                        return store.index[i] - 1;
+        }
+
+        return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_alloc                                           *
+ *                                                                            *
+ * Purpose: get slot for new container, recycled slot of removed container    *
+ *          is preferred, so columns stay dense                               *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_store_alloc(const char *id)
+{
+        int     slot, column;
+
+        if (0 < store.free_num)
+        {
+                slot = store.free_slots[--store.free_num];
+        }
+        else
+        {
+                if (store.slots_num == store.slots_alloc)
+                {
+                        store.slots_alloc = 0 == store.slots_alloc ? ZBX_DOCKER_STORE_SLOTS : store.slots_alloc * 2;
+                        store.ids = realloc(store.ids, sizeof(char *) * store.slots_alloc);
+                        store.seen = realloc(store.seen, sizeof(unsigned int) * store.slots_alloc);
+                        store.free_slots = realloc(store.free_slots, sizeof(int) * store.slots_alloc);
+                        for (column = 0; column < ZBX_DOCKER_COLUMN_COUNT; column++)
+                        {
+                                store.columns[column] = realloc(store.columns[column],
+                                                sizeof(zbx_uint64_t) * store.slots_alloc);
+                        }
+                        store.pressure = realloc(store.pressure,
+                                        sizeof(double) * ZBX_DOCKER_PRESSURE_COUNT * store.slots_alloc);
+                }
+                slot = store.slots_num++;
+        }
+
+        store.ids[slot] = zbx_strdup(NULL, id);
+        store.live_num++;
+
+        return slot;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_read                                            *
+ *                                                                            *
+ * Purpose: read all store columns of the container from cgroup files         *
+ *                                                                            *
+ * Notes: missing files (e.g. disabled swap accounting) give 0 values         *
+ ******************************************************************************/
+void    zbx_docker_store_read(int slot)
+{
+        zbx_docker_scan_t       *scan = store.scan;
+        const zbx_docker_blkio_t        *blkio;
+        zbx_uint64_t            value;
+        char                    *filename;
+        int                     column, i;
+
+        for (column = 0; column < ZBX_DOCKER_COLUMN_COUNT; column++)
+                store.columns[column][slot] = 0;
+
+        // memory - v2 memory.stat is always hierarchical
+        filename = zbx_docker_cgroup_path("memory/", store.ids[slot], "/memory.stat");
+        if (0 <= zbx_docker_scan_read(scan, filename))
+        {
+                if (1 == cgroup_v2)
+                {
+                        store.columns[ZBX_DOCKER_COLUMN_RSS][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_ANON);
+                        store.columns[ZBX_DOCKER_COLUMN_CACHE][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_FILE);
+                }
+                else
+                {
+                        store.columns[ZBX_DOCKER_COLUMN_RSS][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_TOTAL_RSS);
+                        store.columns[ZBX_DOCKER_COLUMN_CACHE][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_TOTAL_CACHE);
+                        store.columns[ZBX_DOCKER_COLUMN_SWAP][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_TOTAL_SWAP);
+                }
+        }
+        free(filename);
+
+        if (1 == cgroup_v2)
+        {
+                filename = zbx_docker_cgroup_path("", store.ids[slot], "/memory.swap.current");
+                if (0 < zbx_docker_scan_read(scan, filename) &&
+                                1 == zbx_docker_scan_uint64(scan->lines[0].key, scan->lines[0].key_len, &value))
+                {
+                        store.columns[ZBX_DOCKER_COLUMN_SWAP][slot] = value;
+                }
+                free(filename);
+        }
+
+        // CPU - usec, v1 cpuacct.stat is in USER_HZ ticks
+        filename = zbx_docker_cgroup_path(cpu_cgroup, store.ids[slot], 1 == cgroup_v2 ? "/cpu.stat" : "/cpuacct.stat");
+        if (0 <= zbx_docker_scan_read(scan, filename))
+        {
+                if (1 == cgroup_v2)
+                {
+                        store.columns[ZBX_DOCKER_COLUMN_CPU_USER][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_USER_USEC);
+                        store.columns[ZBX_DOCKER_COLUMN_CPU_SYSTEM][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_SYSTEM_USEC);
+                }
+                else
+                {
+                        store.columns[ZBX_DOCKER_COLUMN_CPU_USER][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_USER) *
+                                        (1000000 / clk_tck);
+                        store.columns[ZBX_DOCKER_COLUMN_CPU_SYSTEM][slot] = zbx_docker_scan_get(scan, ZBX_DOCKER_STAT_SYSTEM) *
+                                        (1000000 / clk_tck);
+                }
+        }
+        free(filename);
+
+        // block I/O - bytes summed over all devices
+        filename = zbx_docker_cgroup_path("blkio/", store.ids[slot], 1 == cgroup_v2 ? "/io.stat" :
+                        "/blkio.throttle.io_service_bytes");
+        if (0 <= zbx_docker_scan_file(scan, filename))
+        {
+                const char      *read_field = 1 == cgroup_v2 ? "rbytes" : "Read";
+                const char      *write_field = 1 == cgroup_v2 ? "wbytes" : "Write";
+
+                for (i = 0; i < scan->lines_num; i++)
+                {
+                        if (1 == zbx_docker_scan_field(&scan->lines[i], read_field, &value))
+                                store.columns[ZBX_DOCKER_COLUMN_BLKIO_READ][slot] += value;
+                        if (1 == zbx_docker_scan_field(&scan->lines[i], write_field, &value))
+                                store.columns[ZBX_DOCKER_COLUMN_BLKIO_WRITE][slot] += value;
+                }
+        }
+        else if (EFBIG == errno && NULL != (blkio = zbx_docker_blkio_get(filename)))
+        {
+                // too many devices for the scan buffer, whole file is read into heap
+                const char      *read_op = 1 == cgroup_v2 ? "rbytes" : "Read";
+                const char      *write_op = 1 == cgroup_v2 ? "wbytes" : "Write";
+
+                for (i = 0; i < blkio->values_num; i++)
+                {
+                        if (0 == blkio->values[i].dev)
+                                continue;
+                        if (0 == strcmp(blkio->values[i].op, read_op))
+                                store.columns[ZBX_DOCKER_COLUMN_BLKIO_READ][slot] += blkio->values[i].value;
+                        else if (0 == strcmp(blkio->values[i].op, write_op))
+                                store.columns[ZBX_DOCKER_COLUMN_BLKIO_WRITE][slot] += blkio->values[i].value;
+                }
+        }
+        free(filename);
+
+        // pressure - only if pressure items are used
+        if (1 == store.pressure_used)
+                zbx_docker_pressure_read(store.ids[slot], &store.pressure[slot * ZBX_DOCKER_PRESSURE_COUNT]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_add                                             *
+ *                                                                            *
+ * Purpose: enumeration callback, update store row of the container           *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_store_add(const char *containerid, void *arg)
+{
+        int     slot;
+
+        if (-1 == (slot = zbx_docker_store_find(containerid)))
+                slot = zbx_docker_store_alloc(containerid);
+
+        store.seen[slot] = store.generation;
+        zbx_docker_store_read(slot);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_refresh                                         *
+ *                                                                            *
+ * Purpose: refresh the store from cgroup files of all running containers,    *
+ *          slots of removed containers are released for new ones            *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - containers cannot be enumerated           *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: store is private memory of the agent process, all keys served by    *
+ *        the process within ZBX_DOCKER_STORE_TTL use the same snapshot       *
+ ******************************************************************************/
+int     zbx_docker_store_refresh()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_store_refresh()");
+        zbx_uint64_t    now = zbx_docker_stats_time();
+        int             slot;
+
+        if (0 != store.refreshed && now - store.refreshed < ZBX_DOCKER_STORE_TTL)
+        {
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_STORE, 1);
+                return SYSINFO_RET_OK;
+        }
+        zbx_docker_stats_cache(ZBX_DOCKER_CACHE_STORE, 0);
+
+        if (NULL == store.scan)
+                store.scan = malloc(sizeof(zbx_docker_scan_t));
+
+        store.generation++;
+        if (SYSINFO_RET_OK != zbx_docker_containers_enum(zbx_docker_store_add, NULL) || NULL == cpu_cgroup)
+        {
+                store.refreshed = 0;
+                return SYSINFO_RET_FAIL;
+        }
+
+        for (slot = 0; slot < store.slots_num; slot++)
+        {
+                if (NULL == store.ids[slot] || store.seen[slot] == store.generation)
+                        continue;
+
+                zabbix_log(LOG_LEVEL_DEBUG, "Container %s was removed from store slot %d", store.ids[slot], slot);
+                free(store.ids[slot]);
+                store.ids[slot] = NULL;
+                store.free_slots[store.free_num++] = slot;
+                store.live_num--;
+        }
+        zbx_docker_store_index();
+        store.refreshed = now;
+
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_free                                            *
+ *                                                                            *
+ * Purpose: free the store                                                    *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_store_free()
+{
+        int     slot, column;
+
+        for (slot = 0; slot < store.slots_num; slot++)
+                free(store.ids[slot]);
+        for (column = 0; column < ZBX_DOCKER_COLUMN_COUNT; column++)
+                free(store.columns[column]);
+        free(store.ids);
+        free(store.seen);
+        free(store.free_slots);
+        free(store.index);
+        free(store.scan);
+        free(store.pressure);
+        memset(&store, 0, sizeof(store));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_store_column                                          *
+ *                                                                            *
+ * Purpose: find store column by name                                         *
+ *                                                                            *
+ * Return value: column, -1 - unknown column                                  *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_store_column(const char *name)
+{
+        int     column;
+
+        for (column = 0; column < ZBX_DOCKER_COLUMN_COUNT; column++)
+        {
+                if (0 == strcmp(store_column_names[column], name))
+                        return column;
         }
-        char    *filename = malloc(filename_size);
-        zbx_strlcpy(filename, stat_dir, filename_size);
-        zbx_strlcat(filename, cgroup, filename_size);
-        zbx_strlcat(filename, driver, filename_size);
-        if (strstr(container, ".") == NULL && c_prefix != NULL)
+
+        return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_summary                                        *
+ *                                                                            *
+ * Purpose: aggregate of the store metric over all running containers         *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_summary(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_summary()");
+        char            *func;
+        int             column, slot, found = 0;
+        zbx_uint64_t    *values, sum = 0, min = 0, max = 0;
+
+        if (1 > request->nparam || 2 < request->nparam)
         {
-            zbx_strlcat(filename, c_prefix, filename_size);
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
         }
-        zbx_strlcat(filename, container, filename_size);
-        if (strstr(container, ".") == NULL && c_suffix != NULL)
+
+        if (-1 == (column = zbx_docker_store_column(get_rparam(request, 0))))
         {
-            zbx_strlcat(filename, c_suffix, filename_size);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid metric"));
+                return SYSINFO_RET_FAIL;
         }
-        zbx_strlcat(filename, stat_file, filename_size);
-        zabbix_log(LOG_LEVEL_DEBUG, "Metric source file: %s", filename);
-        FILE    *file;
-        if (NULL == (file = fopen(filename, "r")))
+
+        func = get_rparam(request, 1);
+        if (NULL == func || '\0' == *func)
+                func = "sum";
+
+        if (SYSINFO_RET_OK != zbx_docker_store_refresh())
         {
-                zabbix_log(LOG_LEVEL_ERR, "Cannot open metric file: '%s'", filename);
-                free(filename);
-                free(container);
-                SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot open %s file", ++stat_file));
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.summary is not available at the moment - containers cannot be enumerated"));
                 return SYSINFO_RET_FAIL;
         }
 
-        char    line[MAX_STRING_LEN];
-        char    *metric2 = malloc(strlen(metric)+3);
-        zbx_uint64_t cpu_num;
-        memcpy(metric2, metric, strlen(metric));
-        memcpy(metric2 + strlen(metric), " ", 2);
-        zbx_uint64_t    value = 0;
-        zbx_uint64_t    result_value = 0;
-        zabbix_log(LOG_LEVEL_DEBUG, "Looking metric %s in cpuacct.stat/cpu.stat file", metric);
-        while (NULL != fgets(line, sizeof(line), file))
+        // free slots are skipped, the column is scanned sequentially
+        values = store.columns[column];
+        for (slot = 0; slot < store.slots_num; slot++)
         {
-                if (0 != strcmp("total", metric) && 0 != strncmp(line, metric2, strlen(metric2))) {
-                        continue;
-                }
-                if (1 != sscanf(line, "%*s " ZBX_FS_UI64, &value))
-                {
-                        zabbix_log(LOG_LEVEL_ERR, "sscanf failed for matched metric line");
+                if (NULL == store.ids[slot])
                         continue;
-                }
-                result_value += value;
-                ret = SYSINFO_RET_OK;
+                if (0 == found++ || values[slot] < min)
+                        min = values[slot];
+                if (values[slot] > max)
+                        max = values[slot];
+                sum += values[slot];
         }
 
-        zbx_fclose(file);
-        free(filename);
-        free(metric2);
-
-        if (SYSINFO_RET_FAIL == ret) {
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot find a line with requested metric in cpuacct.stat/cpu.stat file"));
-        } else {
-                // normalize CPU usage by using number of online CPUs - only tick metrics
-                if ((strcmp(metric, "user") == 0 || strcmp(metric, "system") == 0 || strcmp(metric, "total") == 0) && (1 < (cpu_num = sysconf(_SC_NPROCESSORS_ONLN))))
-                {
-                        result_value /= cpu_num;
-                }
-
-                zabbix_log(LOG_LEVEL_DEBUG, "Id: %s; metric: %s; value: %lu", container, metric, result_value);
-                SET_UI64_RESULT(result, result_value);
+        if (0 == strcmp(func, "sum"))
+        {
+                SET_UI64_RESULT(result, sum);
+        }
+        else if (0 == strcmp(func, "avg"))
+        {
+                SET_DBL_RESULT(result, 0 == store.live_num ? 0 : (double)sum / store.live_num);
+        }
+        else if (0 == strcmp(func, "min"))
+        {
+                SET_UI64_RESULT(result, min);
+        }
+        else if (0 == strcmp(func, "max"))
+        {
+                SET_UI64_RESULT(result, max);
+        }
+        else if (0 == strcmp(func, "count"))
+        {
+                SET_UI64_RESULT(result, store.live_num);
+        }
+        else
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid aggregate function"));
+                return SYSINFO_RET_FAIL;
         }
-        free(container);
 
-        return ret;
+        return SYSINFO_RET_OK;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_net                                            *
+ * Function: zbx_module_docker_top                                            *
  *                                                                            *
- * Purpose: container network metrics                                         *
+ * Purpose: containers with the highest values of the store metric            *
  *                                                                            *
  * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
  *                                 as not supported by zabbix                 *
  *               SYSINFO_RET_OK - success                                     *
  *                                                                            *
+ * Notes: JSON array [{"id":"<full container id>","value":N}, ...] sorted     *
+ *        by value, the top is selected by insertion into N ordered slots     *
  ******************************************************************************/
-int     zbx_module_docker_net(AGENT_REQUEST *request, AGENT_RESULT *result)
+int     zbx_module_docker_top(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_net()");
-        char    *container, *metric, *interfacec;
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_top()");
+        char            *param;
+        int             column, slot, count = 5, top_num = 0, *top, i;
+        zbx_uint64_t    *values;
 
-        if(geteuid() != 0)
+        if (1 > request->nparam || 2 < request->nparam)
         {
-            zabbix_log(LOG_LEVEL_ERR, "docker.net metrics requires root permissions");
-            SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.net metrics requires root permissions"));
-            return SYSINFO_RET_FAIL;
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
         }
-        struct stat st = {0};
 
-        if(stat("/var/run/netns", &st) == -1)
+        if (-1 == (column = zbx_docker_store_column(get_rparam(request, 0))))
         {
-            if(mkdir("/var/run/netns", 0755) != 0)
-            {
-                zabbix_log(LOG_LEVEL_ERR, "Cannot create /var/run/netns");
-                SET_MSG_RESULT(result, strdup("Cannot create /var/run/netns"));
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid metric"));
                 return SYSINFO_RET_FAIL;
-            }
         }
 
-        container = zbx_module_docker_get_fci(get_rparam(request, 0));
-        interfacec = get_rparam(request, 1);
-        metric = get_rparam(request, 2);
-        const char* znetns_prefix = "zabbix_module_docker_";
-
-        size_t  filename_size = strlen("/var/run/netns/") + strlen(znetns_prefix) + strlen(container) + 2;
-        char    *filename = malloc(filename_size);
-        char    *netns = malloc(filename_size - strlen("/var/run/netns/") + 2);
-        zbx_strlcpy(filename, "/var/run/netns/", filename_size);
-        zbx_strlcat(filename, znetns_prefix, filename_size);
-        zbx_strlcpy(netns, znetns_prefix, filename_size);
-        zbx_strlcat(filename, container, filename_size);
-        zbx_strlcat(netns, container, filename_size);
-
-        zabbix_log(LOG_LEVEL_DEBUG, "netns file: %s", filename);
-        if(access(filename, F_OK ) == -1)
+        param = get_rparam(request, 1);
+        if (NULL != param && '\0' != *param && 0 >= (count = atoi(param)))
         {
-            // create netns
-            // get first task
-            char    *stat_file = "/tasks";
-            char    *cgroup = "devices/";
-            filename_size = strlen(cgroup) + strlen(container) + strlen(stat_dir) + strlen(driver) + strlen(stat_file) + 2;
-            if (c_prefix != NULL)
-            {
-                filename_size += strlen(c_prefix);
-            }
-            if (c_suffix != NULL)
-            {
-                filename_size += strlen(c_suffix);
-            }
-            char* filename2 = malloc(filename_size);
-            zbx_strlcpy(filename2, stat_dir, filename_size);
-            zbx_strlcat(filename2, cgroup, filename_size);
-            zbx_strlcat(filename2, driver, filename_size);
-            if (c_prefix != NULL)
-            {
-                zbx_strlcat(filename2, c_prefix, filename_size);
-            }
-            zbx_strlcat(filename2, container, filename_size);
-            if (c_suffix != NULL)
-            {
-                zbx_strlcat(filename2, c_suffix, filename_size);
-            }
-            zbx_strlcat(filename2, stat_file, filename_size);
-            zabbix_log(LOG_LEVEL_DEBUG, "Tasks file: %s", filename2);
-            FILE    *file;
-            if (NULL == (file = fopen(filename2, "r")))
-            {
-                zabbix_log(LOG_LEVEL_ERR, "Cannot open Docker tasks file: '%s'", filename2);
-                free(container);
-                free(filename);
-                free(netns);
-                free(filename2);
-                SET_MSG_RESULT(result, strdup("Cannot open Docker tasks file"));
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid count"));
                 return SYSINFO_RET_FAIL;
-            }
-
-            char    line[MAX_STRING_LEN];
-            char* first_task;
-            while (NULL != fgets(line, sizeof(line), file))
-            {
-                first_task = string_replace(line, "\n", "");
-                zabbix_log(LOG_LEVEL_DEBUG, "First task for container %s: %s", container, first_task);
-                break;
-            }
-            zbx_fclose(file);
-            free(container);
-            free(filename2);
-
-            // soft link - new netns
-            filename_size = strlen("/proc//ns/net") + strlen(first_task) + 2;
-            char* netns_source = malloc(filename_size);
-            zbx_strlcpy(netns_source, "/proc/", filename_size);
-            zbx_strlcat(netns_source, first_task, filename_size);
-            free(first_task);
-            zbx_strlcat(netns_source, "/ns/net", filename_size);
-
-            // remove broken link - container has been restarted
-            if(access(filename, F_OK ) == -1)
-            {
-                if(unlink(filename) != 0)
-                {
-                    zabbix_log(LOG_LEVEL_WARNING, "%s: %s", filename, zbx_strerror(errno));
-                }
-            }
+        }
 
-            if(symlink(netns_source, filename) != 0) {
-                zabbix_log(LOG_LEVEL_ERR, "Cannot create netns symlink: %s -> %s", filename, netns_source);
-                free(netns_source);
-                free(filename);
-                free(netns);
-                SET_MSG_RESULT(result, strdup("Cannot create netns symlink"));
+        if (SYSINFO_RET_OK != zbx_docker_store_refresh())
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.top is not available at the moment - containers cannot be enumerated"));
                 return SYSINFO_RET_FAIL;
-            }
-            free(netns_source);
         }
 
-        // execute ip netns exec filename netstat -i
-        FILE *fp;
-        char line[MAX_STRING_LEN];
-        filename_size = strlen("ip netns exec  netstat -i") + strlen(netns) + 2;
-        char* command = malloc(filename_size);
-        zbx_strlcpy(command, "ip netns exec ", filename_size);
-        zbx_strlcat(command, netns, filename_size);
-        zbx_strlcat(command, " netstat -i", filename_size);
-        zabbix_log(LOG_LEVEL_DEBUG, "netns command: %s", command);
+        if (count > store.live_num)
+                count = store.live_num;
+        top = malloc(sizeof(int) * (count + 1));
+        values = store.columns[column];
 
-        fp = popen(command, "r");
-        free(command);
-        free(filename);
-        free(netns);
-        if (fp == NULL)
+        for (slot = 0; slot < store.slots_num; slot++)
         {
-            zabbix_log(LOG_LEVEL_WARNING, "Cannot execute netns command");
-            SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot execute netns command"));
-            return SYSINFO_RET_FAIL;
+                if (NULL == store.ids[slot])
+                        continue;
+                if (top_num == count && values[top[top_num - 1]] >= values[slot])
+                        continue;
+                for (i = top_num < count ? top_num++ : count - 1; 0 < i && values[top[i - 1]] < values[slot]; i--)
+                        top[i] = top[i - 1];
+                top[i] = slot;
         }
 
-        /*
-        [root@dev ~]# ip netns exec $CID netstat -i
-        Kernel Interface table
-        Iface      MTU    RX-OK RX-ERR RX-DRP RX-OVR    TX-OK TX-ERR TX-DRP TX-OVR Flg
-        eth0      1500  1238410      0      0 0       1836070      0      0      0 BRU
-        lo       65536  1856189      0      0 0       1856189      0      0      0 LRU
-        */
-
-        int metric_pos = 0;
-        int pos = 0;
-        char *pch;
-        int value = 0;
-        while(fgets(line, sizeof(line), fp) != NULL)
+        json_t *a = json_array();
+        for (i = 0; i < top_num; i++)
         {
-            // skip first line
-            if (0 == strncmp(line, "Kernel Interface table", strlen("Kernel Interface table")))
-                continue;
+                json_t *o = json_object();
+                json_object_set_new(o, "id", json_string(store.ids[top[i]]));
+                json_object_set_new(o, "value", json_integer(values[top[i]]));
+                json_array_append_new(a, o);
+        }
+        SET_STR_RESULT(result, json_dumps(a, 0));
+        json_decref(a);
+        free(top);
 
-            if(metric_pos == INT_MAX)
-            {
-                zabbix_log(LOG_LEVEL_DEBUG, "Not found metric %s", metric);
-                SET_MSG_RESULT(result, zbx_strdup(NULL, "Not found net metric"));
-                return SYSINFO_RET_FAIL;
-            }
+        return SYSINFO_RET_OK;
+}
 
-            // second line find position
-            if(metric_pos == 0)
-            {
-                int found = 0;
-                pch = strtok(line," ");
-                while (pch != NULL)
-                {
-                    if(0 != strncmp(pch, metric, strlen(metric)))
-                    {
-                       pch = strtok(NULL, " ");
-                       metric_pos++;
-                       continue;
-                    } else {
-                       found = 1;
-                       break;
-                    }
-                }
-                if(found == 0)
-                {
-                    metric_pos = INT_MAX;
-                    continue;
-                }
-            }
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_bulk                                           *
+ *                                                                            *
+ * Purpose: all store metrics of all running containers in one value          *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: JSON {"<full container id>":{"rss":N,...},...} for dependent items  *
+ *        with JSONPath preprocessing, e.g. $["{#FCONTAINERID}"].rss          *
+ ******************************************************************************/
+int     zbx_module_docker_bulk(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_bulk()");
+        int     slot, column;
 
-            // find selected interface and metric
-            if(strcmp(interfacec, "all") == 0)
-            {
-                // find value at metric_pos and sum
-                pch = strtok(line," ");
-                pos = 0;
-                while (pch != NULL)
-                {
-                    if(pos < metric_pos)
-                    {
-                       pch = strtok(NULL, " ");
-                       pos++;
-                       continue;
-                    } else {
-                       value += atoi(pch);
-                       break;
-                    }
-                }
+        if (SYSINFO_RET_OK != zbx_docker_store_refresh())
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.bulk is not available at the moment - containers cannot be enumerated"));
+                return SYSINFO_RET_FAIL;
+        }
 
-            } else {
-                // skip lines which doesn't match interface
-                if (0 != strncmp(line, interfacec, strlen(interfacec)))
-                {
-                    continue;
-                }
+        json_t *j = json_object();
+        for (slot = 0; slot < store.slots_num; slot++)
+        {
+                if (NULL == store.ids[slot])
+                        continue;
 
-                // find value at metric_pos
-                pch = strtok(line," ");
-                pos = 0;
-                while (pch != NULL)
-                {
-                    if(pos != metric_pos)
-                    {
-                       pch = strtok(NULL, " ");
-                       pos++;
-                       continue;
-                    } else {
-                       value = atoi(pch);
-                       zabbix_log(LOG_LEVEL_DEBUG, "found metric %s: %d", metric, value);
-                       SET_UI64_RESULT(result, value);
-                       pclose(fp);
-                       return SYSINFO_RET_OK;
-                    }
-                }
-            }
+                json_t *o = json_object();
+                for (column = 0; column < ZBX_DOCKER_COLUMN_COUNT; column++)
+                        json_object_set_new(o, store_column_names[column], json_integer(store.columns[column][slot]));
+                json_object_set_new(j, store.ids[slot], o);
         }
-        zabbix_log(LOG_LEVEL_DEBUG, "found metric %s: %d", metric, value);
-        SET_UI64_RESULT(result, value);
-        pclose(fp);
+        SET_STR_RESULT(result, json_dumps(j, 0));
+        json_decref(j);
+
         return SYSINFO_RET_OK;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_uninit                                                *
+ * Function: zbx_docker_pressure_index                                        *
  *                                                                            *
- * Purpose: the function is called on agent shutdown                          *
- *          It should be used to cleanup used resources if there are any      *
+ * Purpose: index of the pressure value in the container snapshot             *
+ *                                                                            *
+ * Parameters: resource - cpu, memory or io                                   *
+ *             type - some or full                                            *
+ *             field - avg10, avg60, avg300 or total                          *
+ *                                                                            *
+ * Return value: index, -1 - invalid parameter                                *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_pressure_index(const char *resource, const char *type, const char *field)
+{
+        int     r, t, f;
+
+        for (r = 0; r < 3 && 0 != strcmp(pressure_resources[r], resource); r++)
+                ;
+        for (t = 0; t < 2 && 0 != strcmp(pressure_types[t], type); t++)
+                ;
+        for (f = 0; f < 4 && 0 != strcmp(pressure_fields[f], field); f++)
+                ;
+        if (3 == r || 2 == t || 4 == f)
+                return -1;
+
+        return (r * 2 + t) * 4 + f;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_pressure_read                                         *
  *                                                                            *
- * Return value: ZBX_MODULE_OK - success                                      *
- *               ZBX_MODULE_FAIL - function failed                            *
+ * Purpose: read cpu.pressure, memory.pressure and io.pressure of the         *
+ *          container                                                         *
  *                                                                            *
+ * Parameters: container - full container id or cgroup directory name         *
+ *             values - ZBX_DOCKER_PRESSURE_COUNT values, -1 if not available *
+ *                                                                            *
+ * Notes: 'some avg10=0.12 avg60=0.05 avg300=0.01 total=12345', averages are  *
+ *        in %, total stall time in usec; v1 has the files in cpuacct         *
+ *        hierarchy only with psi_cgroupv1 kernel option                      *
+ *        https://docs.kernel.org/accounting/psi.html                         *
  ******************************************************************************/
-int     zbx_module_uninit()
+void    zbx_docker_pressure_read(const char *container, double *values)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_uninit()");
+        char            buffer[256], *line, *filename, file[16], type[8];
+        double          avg10, avg60, avg300;
+        zbx_uint64_t    total;
+        int             r, t;
 
-        const char* znetns_prefix = "zabbix_module_docker_";
-        DIR             *dir;
-        struct dirent   *d;
+        for (r = 0; r < ZBX_DOCKER_PRESSURE_COUNT; r++)
+                values[r] = -1;
 
-        if (NULL == (dir = opendir("/var/run/netns")))
-        {
-            zabbix_log(LOG_LEVEL_DEBUG, "/var/run/netns: %s", zbx_strerror(errno));
-            return ZBX_MODULE_OK;
-        }
-        char *file = NULL;
-        while (NULL != (d = readdir(dir)))
+        for (r = 0; r < 3; r++)
         {
-            if(0 == strcmp(d->d_name, ".") || 0 == strcmp(d->d_name, ".."))
-                continue;
-
-            // delete zabbix netns
-            if ((strstr(d->d_name, znetns_prefix)) != NULL)
-            {
-                file = NULL;
-                file = zbx_dsprintf(file, "/var/run/netns/%s", d->d_name);
-                if(unlink(file) != 0)
+                zbx_snprintf(file, sizeof(file), "/%s.pressure", pressure_resources[r]);
+                filename = zbx_docker_cgroup_path(cpu_cgroup, container, file);
+                if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)))
                 {
-                    zabbix_log(LOG_LEVEL_WARNING, "%s: %s", d->d_name, zbx_strerror(errno));
+                        for (line = strtok(buffer, "\n"); NULL != line; line = strtok(NULL, "\n"))
+                        {
+                                if (5 != sscanf(line, "%7s avg10=%lf avg60=%lf avg300=%lf total=" ZBX_FS_UI64, type,
+                                                &avg10, &avg60, &avg300, &total))
+                                        continue;
+                                for (t = 0; t < 2 && 0 != strcmp(pressure_types[t], type); t++)
+                                        ;
+                                if (2 == t)
+                                        continue;
+                                values[(r * 2 + t) * 4] = avg10;
+                                values[(r * 2 + t) * 4 + 1] = avg60;
+                                values[(r * 2 + t) * 4 + 2] = avg300;
+                                values[(r * 2 + t) * 4 + 3] = (double)total;
+                        }
                 }
-            }
-        }
-        if(0 != closedir(dir))
-        {
-            zabbix_log(LOG_LEVEL_WARNING, "/var/run/netns/: %s", zbx_strerror(errno));
+                free(filename);
         }
-
-        free(stat_dir);
-
-        return ZBX_MODULE_OK;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_init                                                  *
- *                                                                            *
- * Purpose: the function is called on agent startup                           *
- *          It should be used to call any initialization routines             *
+ * Function: zbx_docker_pressure_refresh                                      *
  *                                                                            *
- * Return value: ZBX_MODULE_OK - success                                      *
- *               ZBX_MODULE_FAIL - module initialization failed               *
+ * Purpose: refresh the store with pressure snapshots of all containers       *
  *                                                                            *
- * Comment: the module won't be loaded in case of ZBX_MODULE_FAIL             *
+ * Return value: SYSINFO_RET_FAIL - containers cannot be enumerated           *
+ *               SYSINFO_RET_OK - success                                     *
  *                                                                            *
+ * Notes: pressure files are read by store refresh only after the first       *
+ *        pressure item, the store is refreshed immediately at that moment    *
  ******************************************************************************/
-int     zbx_module_init()
+int     zbx_docker_pressure_refresh()
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_init()");
-        zabbix_log(LOG_LEVEL_DEBUG, "zabbix_module_docker %s, compilation time: %s %s", m_version, __DATE__, __TIME__);
-        zbx_docker_dir_detect();
-        zbx_docker_api_detect();
-        return ZBX_MODULE_OK;
+        if (0 == store.pressure_used)
+        {
+                store.pressure_used = 1;
+                store.refreshed = 0;
+        }
+
+        return zbx_docker_store_refresh();
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_inspect                                        *
+ * Function: zbx_module_docker_pressure                                       *
  *                                                                            *
- * Purpose: container inspection                                              *
+ * Purpose: container Pressure Stall Information                              *
  *                                                                            *
  * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
  *                                 as not supported by zabbix                 *
  *               SYSINFO_RET_OK - success                                     *
  *                                                                            *
+ * Notes: docker.pressure[cid,cpu|memory|io,<some|full>,<avg10|avg60|avg300|  *
+ *        total>], running containers are served from the store snapshot      *
  ******************************************************************************/
-int     zbx_module_docker_inspect(AGENT_REQUEST *request, AGENT_RESULT *result)
+int     zbx_module_docker_pressure(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_inspect()");
-        struct inspect_result iresult;
-        iresult = zbx_module_docker_inspect_exec(get_rparam(request, 0), get_rparam(request, 1), get_rparam(request, 2), get_rparam(request, 3));
-        if (iresult.return_code == SYSINFO_RET_OK) {
-            zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec OK: %s", iresult.value);
-            SET_STR_RESULT(result, iresult.value);
-            return iresult.return_code;
-        } else {
-            zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec FAIL: %s", iresult.value);
-            SET_MSG_RESULT(result, iresult.value);
-            return iresult.return_code;
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_pressure()");
+        char    *container, *type, *field;
+        double  values[ZBX_DOCKER_PRESSURE_COUNT], *snapshot = values;
+        int     index, slot;
+
+        if (2 > request->nparam || 4 < request->nparam)
+        {
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        type = get_rparam(request, 2);
+        if (NULL == type || '\0' == *type)
+                type = "some";
+        field = get_rparam(request, 3);
+        if (NULL == field || '\0' == *field)
+                field = "avg10";
+
+        if (-1 == (index = zbx_docker_pressure_index(get_rparam(request, 1), type, field)))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid pressure metric"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (SYSINFO_RET_OK != zbx_docker_pressure_refresh())
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.pressure is not available at the moment - containers cannot be enumerated"));
+                return SYSINFO_RET_FAIL;
+        }
+
+        container = zbx_module_docker_get_fci(get_rparam(request, 0));
+        if (-1 != (slot = zbx_docker_store_find(container)))
+                snapshot = &store.pressure[slot * ZBX_DOCKER_PRESSURE_COUNT];
+        else
+                zbx_docker_pressure_read(container, values);
+
+        if (0 > snapshot[index])
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Pressure metric is not available, PSI may be disabled in the kernel"));
+                return SYSINFO_RET_FAIL;
         }
+
+        if (3 == index % 4)
+                SET_UI64_RESULT(result, (zbx_uint64_t)snapshot[index]);
+        else
+                SET_DBL_RESULT(result, snapshot[index]);
+
+        return SYSINFO_RET_OK;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_discovery_basic                                *
+ * Function: zbx_module_docker_pressure_top                                   *
  *                                                                            *
- * Purpose: container discovery                                               *
+ * Purpose: containers ranked by pressure                                     *
  *                                                                            *
  * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
  *                                 as not supported by zabbix                 *
  *               SYSINFO_RET_OK - success                                     *
  *                                                                            *
+ * Notes: docker.pressure.top[cpu|memory|io,<some|full>,<avg10|...>,<count>], *
+ *        JSON array [{"id":"<full container id>","value":N}, ...] as         *
+ *        docker.top, containers without PSI are skipped                      *
  ******************************************************************************/
-int     zbx_module_docker_discovery_basic(AGENT_REQUEST *request, AGENT_RESULT *result)
+int     zbx_module_docker_pressure_top(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
-        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_discovery_basic()");
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_pressure_top()");
+        char    *type, *field, *param;
+        int     index, slot, count = 5, top_num = 0, *top, i;
+        double  *values;
 
-        if(stat_dir == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL)
+        if (1 > request->nparam || 4 < request->nparam)
         {
-            zabbix_log(LOG_LEVEL_DEBUG, "docker.discovery is not available at the moment - no stat directory - empty discovery");
-            json_t *j = json_object();
-            json_object_set_new(j, "data", json_array());
-            SET_STR_RESULT(result, json_dumps(j, 0));
-            json_decref(j);
-            return SYSINFO_RET_FAIL;
+                zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                return SYSINFO_RET_FAIL;
         }
 
-        DIR             *dir;
-        zbx_stat_t      sb;
-        char            *file = NULL, *containerid, scontainerid[13];
-        struct dirent   *d;
-        char    *cgroup = "cpuset/";
-        size_t  ddir_size = strlen(cgroup) + strlen(stat_dir) + strlen(driver) + 2;
-        char    *ddir = malloc(ddir_size);
-        zbx_strlcpy(ddir, stat_dir, ddir_size);
-        zbx_strlcat(ddir, cgroup, ddir_size);
-        zbx_strlcat(ddir, driver, ddir_size);
+        type = get_rparam(request, 1);
+        if (NULL == type || '\0' == *type)
+                type = "some";
+        field = get_rparam(request, 2);
+        if (NULL == field || '\0' == *field)
+                field = "avg10";
 
-        if (NULL == (dir = opendir(ddir)))
+        if (-1 == (index = zbx_docker_pressure_index(get_rparam(request, 0), type, field)))
         {
-            zabbix_log(LOG_LEVEL_WARNING, "%s: %s", ddir, zbx_strerror(errno));
-            free(ddir);
-            return SYSINFO_RET_FAIL;
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid pressure metric"));
+                return SYSINFO_RET_FAIL;
         }
 
-        json_t *a = json_array();
-
-        size_t hostname_len = 128;
-        while (1) {
-            char* realloc_hostname = realloc(hostname, hostname_len);
-            if (realloc_hostname == 0) {
-                free(hostname);
-            }
-            hostname = realloc_hostname;
-            hostname[hostname_len-1] = 0;
-            if (gethostname(hostname, hostname_len-1) == 0) {
-                size_t count = strlen(hostname);
-                if (count < hostname_len-2) {
-                    break;
-                }
-            }
-            hostname_len *= 2;
+        param = get_rparam(request, 3);
+        if (NULL != param && '\0' != *param && 0 >= (count = atoi(param)))
+        {
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid count"));
+                return SYSINFO_RET_FAIL;
         }
 
-        while (NULL != (d = readdir(dir)))
+        if (SYSINFO_RET_OK != zbx_docker_pressure_refresh())
         {
-                if(0 == strcmp(d->d_name, ".") || 0 == strcmp(d->d_name, ".."))
-                        continue;
-
-                file = zbx_dsprintf(file, "%s/%s", ddir, d->d_name);
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.pressure.top is not available at the moment - containers cannot be enumerated"));
+                return SYSINFO_RET_FAIL;
+        }
 
-                if (0 != zbx_stat(file, &sb) || 0 == S_ISDIR(sb.st_mode))
-                        continue;
+        if (count > store.live_num)
+                count = store.live_num;
+        top = malloc(sizeof(int) * (count + 1));
+        values = store.pressure + index;
 
-                // systemd docker: remove suffix (.scope)
-                if (c_suffix != NULL)
-                {
-                    containerid = strtok(d->d_name, ".");
-                } else {
-                    containerid = d->d_name;
-                }
+        // values of the metric are strided by ZBX_DOCKER_PRESSURE_COUNT
+        for (slot = 0; slot < store.slots_num; slot++)
+        {
+                double  value = values[slot * ZBX_DOCKER_PRESSURE_COUNT];
 
-                // systemd docker: remove preffix (docker-)
-                if (c_prefix != NULL)
-                {
-                    containerid = strtok(containerid, "-");
-                    containerid = strtok(NULL, "-");
-                } else {
-                    containerid = d->d_name;
-                }
+                if (NULL == store.ids[slot] || 0 > value || 0 == count)
+                        continue;
+                if (top_num == count && values[top[top_num - 1] * ZBX_DOCKER_PRESSURE_COUNT] >= value)
+                        continue;
+                for (i = top_num < count ? top_num++ : count - 1;
+                                0 < i && values[top[i - 1] * ZBX_DOCKER_PRESSURE_COUNT] < value; i--)
+                        top[i] = top[i - 1];
+                top[i] = slot;
+        }
 
+        json_t *a = json_array();
+        for (i = 0; i < top_num; i++)
+        {
                 json_t *o = json_object();
-                json_object_set_new(o, "{#FCONTAINERID}", json_string(containerid));
-                zbx_strlcpy(scontainerid, containerid, 13);
-                json_object_set_new(o, "{#HCONTAINERID}", json_string(scontainerid));
-                json_object_set_new(o, "{#SCONTAINERID}", json_string(scontainerid));
-                json_object_set_new(o, "{#SYSTEM.HOSTNAME}", json_string(hostname));
+                json_object_set_new(o, "id", json_string(store.ids[top[i]]));
+                if (3 == index % 4)
+                        json_object_set_new(o, "value", json_integer(values[top[i] * ZBX_DOCKER_PRESSURE_COUNT]));
+                else
+                        json_object_set_new(o, "value", json_real(values[top[i] * ZBX_DOCKER_PRESSURE_COUNT]));
                 json_array_append_new(a, o);
-
         }
+        SET_STR_RESULT(result, json_dumps(a, 0));
+        json_decref(a);
+        free(top);
 
-        if(0 != closedir(dir))
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_pressure_bulk                                  *
+ *                                                                            *
+ * Purpose: pressure of all running containers in one value                   *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: JSON {"<full container id>":{"cpu":{"some":{"avg10":N,...},...},...}*
+ *        for dependent items, e.g. $["{#FCONTAINERID}"].memory.full.avg60    *
+ ******************************************************************************/
+int     zbx_module_docker_pressure_bulk(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_pressure_bulk()");
+        int     slot, r, t, f;
+        double  *values;
+
+        if (SYSINFO_RET_OK != zbx_docker_pressure_refresh())
         {
-            zabbix_log(LOG_LEVEL_WARNING, "%s: %s\n", ddir, zbx_strerror(errno));
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.pressure.bulk is not available at the moment - containers cannot be enumerated"));
+                return SYSINFO_RET_FAIL;
         }
 
         json_t *j = json_object();
-        json_object_set_new(j, "data", a);
+        for (slot = 0; slot < store.slots_num; slot++)
+        {
+                if (NULL == store.ids[slot])
+                        continue;
 
+                values = &store.pressure[slot * ZBX_DOCKER_PRESSURE_COUNT];
+                json_t *o = json_object();
+                for (r = 0; r < 3; r++)
+                {
+                        json_t *res = json_object();
+                        for (t = 0; t < 2; t++)
+                        {
+                                if (0 > values[(r * 2 + t) * 4])
+                                        continue;
+                                json_t *p = json_object();
+                                for (f = 0; f < 3; f++)
+                                        json_object_set_new(p, pressure_fields[f], json_real(values[(r * 2 + t) * 4 + f]));
+                                json_object_set_new(p, pressure_fields[3], json_integer(values[(r * 2 + t) * 4 + 3]));
+                                json_object_set_new(res, pressure_types[t], p);
+                        }
+                        if (0 == json_object_size(res))
+                                json_decref(res);
+                        else
+                                json_object_set_new(o, pressure_resources[r], res);
+                }
+                json_object_set_new(j, store.ids[slot], o);
+        }
         SET_STR_RESULT(result, json_dumps(j, 0));
-
         json_decref(j);
 
-        free(ddir);
-
         return SYSINFO_RET_OK;
 }
 
@@ -1679,7 +8248,6 @@ int     zbx_module_docker_discovery_extended(AGENT_REQUEST *request, AGENT_RESUL
             json_object_set_new(j, "data", json_array());
             SET_STR_RESULT(result, json_dumps(j, 0));
             json_decref(j);
-            free((void*) answer);
             return SYSINFO_RET_OK;
         }
 
@@ -1745,9 +8313,11 @@ int     zbx_module_docker_discovery_extended(AGENT_REQUEST *request, AGENT_RESUL
                         break;
                     }
 
-                    names = zbx_strdup(NULL, names);
+                    names = zbx_docker_arena_strdup(names);
                 } else {
-                    names = json_dumps(jp_data2, 0);
+                    char *dump = json_dumps(jp_data2, 0);
+                    names = zbx_docker_arena_strdup(dump);
+                    free(dump);
                 }
                 zabbix_log(LOG_LEVEL_DEBUG, "Parsed container name: %s", names);
 
@@ -1772,19 +8342,16 @@ int     zbx_module_docker_discovery_extended(AGENT_REQUEST *request, AGENT_RESUL
                     iresult = zbx_module_docker_inspect_exec(cid, get_rparam(request, 0), get_rparam(request, 1), get_rparam(request, 2));
                     if (iresult.return_code == SYSINFO_RET_OK) {
                         zabbix_log(LOG_LEVEL_DEBUG, "zbx_module_docker_inspect_exec OK: %s", iresult.value);
-                        free((void *)names);
                         names = iresult.value;
                         json_object_set_new(o, "{#HCONTAINERID}", json_string(names));
                     } else {
                         zabbix_log(LOG_LEVEL_DEBUG, "Default HCONTAINERID is used, because zbx_module_docker_inspect_exec FAIL: %s", iresult.value);
-                        free(iresult.value);
                         json_object_set_new(o, "{#HCONTAINERID}", json_string(names));
                     }
                 } else {
                     json_object_set_new(o, "{#HCONTAINERID}", json_string(names));
                 }
                 json_array_append_new(a, o);
-                free((void *)names);
             }
 
             // TODO expose labels in discovery
@@ -1839,31 +8406,222 @@ int     zbx_module_docker_discovery_extended(AGENT_REQUEST *request, AGENT_RESUL
         json_object_set_new(j, "data", a);
         SET_STR_RESULT(result, json_dumps(j, 0));
         json_decref(j);
-        free((void*) answer);
         json_decref(jp_data);
 
-        return SYSINFO_RET_OK;
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_discovery                                      *
+ *                                                                            *
+ * Purpose: container discovery                                               *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_module_docker_discovery(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        if (zbx_docker_api_available() == 0)
+        {
+            return zbx_module_docker_discovery_basic(request, result);
+        } else {
+            return zbx_module_docker_discovery_extended(request, result);
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_info_store                                            *
+ *                                                                            *
+ * Purpose: store /info document to the shared cache                          *
+ *                                                                            *
+ * Notes: the document is not stored while other process or the refresh       *
+ *        thread is writing it                                                *
+ ******************************************************************************/
+void    zbx_docker_info_store(const char *document, zbx_uint64_t now)
+{
+        zbx_uint64_t    seq = __atomic_load_n(&info_cache->seq, __ATOMIC_RELAXED);
+        size_t          len = strlen(document);
+
+        if (len >= ZBX_DOCKER_INFO_SIZE)
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Docker's /info document is too large for cache: %zu bytes", len);
+                return;
+        }
+        if (0 != (seq & 1) || 0 == __atomic_compare_exchange_n(&info_cache->seq, &seq, seq + 1, 0, __ATOMIC_ACQUIRE,
+                        __ATOMIC_RELAXED))
+        {
+                return;
+        }
+        // odd sequence must be visible before the document is overwritten
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        memcpy(info_cache->data, document, len + 1);
+        info_cache->len = len;
+        info_cache->time_us = now;
+        __atomic_store_n(&info_cache->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_info_get                                              *
+ *                                                                            *
+ * Purpose: get /info document, Docker API is queried only when the shared    *
+ *          cache is older than ZBX_DOCKER_INFO_TTL                           *
+ *                                                                            *
+ * Return value: JSON document in the arena, NULL - Docker API query failed   *
+ *                                                                            *
+ ******************************************************************************/
+const char      *zbx_docker_info_get()
+{
+        zbx_uint64_t    now = zbx_docker_stats_time(), seq;
+        const char      *answer;
+        char            *document;
+        size_t          len;
+
+        if (NULL != info_cache)
+        {
+                __atomic_store_n(&info_cache->used_us, now, __ATOMIC_RELAXED);
+                seq = __atomic_load_n(&info_cache->seq, __ATOMIC_ACQUIRE);
+                len = info_cache->len;
+                if (0 == (seq & 1) && 0 != info_cache->time_us && now - info_cache->time_us <
+                                (zbx_uint64_t)info_ttl * 1000000 && len < ZBX_DOCKER_INFO_SIZE)
+                {
+                        document = zbx_docker_arena_alloc(len + 1);
+                        memcpy(document, info_cache->data, len);
+                        document[len] = '\0';
+                        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                        if (seq == __atomic_load_n(&info_cache->seq, __ATOMIC_RELAXED))
+                        {
+                                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_INFO, 1);
+                                return document;
+                        }
+                }
+                zbx_docker_stats_cache(ZBX_DOCKER_CACHE_INFO, 0);
+        }
+
+        answer = zbx_module_docker_socket_query("GET /info HTTP/1.0\r\n\n", 0);
+        if ('\0' == *answer)
+                return NULL;
+        if (NULL != info_cache)
+                zbx_docker_info_store(answer, now);
+
+        return answer;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_info_run                                              *
+ *                                                                            *
+ * Purpose: refresh thread of /info document cache                            *
+ *                                                                            *
+ * Notes: the document is refreshed a quarter of TTL before expiry, only      *
+ *        while docker.info items are polled, so items are served from the    *
+ *        cache without waiting for Docker API                                *
+ ******************************************************************************/
+void    *zbx_docker_info_run(void *arg)
+{
+        struct timespec next;
+        zbx_uint64_t    now, used, ttl_us = (zbx_uint64_t)info_ttl * 1000000;
+        int             period = 4 <= info_ttl ? info_ttl / 4 : 1;
+        char            *document;
+
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        pthread_mutex_lock(&info_lock);
+        while (0 == info_stop)
+        {
+                // the first document is queried by item call on cache miss
+                next.tv_sec += period;
+                while (0 == info_stop && ETIMEDOUT != pthread_cond_timedwait(&info_cond, &info_lock, &next))
+                        ;
+                if (0 != info_stop)
+                        break;
+                pthread_mutex_unlock(&info_lock);
+                now = zbx_docker_stats_time();
+                used = __atomic_load_n(&info_cache->used_us, __ATOMIC_RELAXED);
+                if (0 != used && now - used < 2 * ttl_us && (0 == info_cache->time_us ||
+                                now - info_cache->time_us + (zbx_uint64_t)period * 1000000 >= ttl_us))
+                {
+                        // not the arena, it belongs to item calls
+                        if (NULL != (document = zbx_docker_socket_read("GET /info HTTP/1.0\r\n\n", 0)))
+                        {
+                                zbx_docker_info_store(document, zbx_docker_stats_time());
+                                free(document);
+                        }
+                }
+                pthread_mutex_lock(&info_lock);
+        }
+        pthread_mutex_unlock(&info_lock);
+
+        return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_info_init                                             *
+ *                                                                            *
+ * Purpose: allocate shared /info cache and start its refresh thread in the   *
+ *          agent main process                                                *
+ *                                                                            *
+ ******************************************************************************/
+void    zbx_docker_info_init()
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_info_init()");
+        pthread_condattr_t      attr;
+        int                     err;
+
+        if (0 == info_ttl)
+                return;
+
+        info_cache = mmap(NULL, sizeof(zbx_docker_info_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == info_cache)
+        {
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot allocate shared memory for docker.info cache: %s", zbx_strerror(errno));
+            info_cache = NULL;
+            return;
+        }
+
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&info_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        info_stop = 0;
+        info_pid = getpid();
+        if (0 != (err = zbx_docker_thread_create(&info_thread, zbx_docker_info_run)))
+        {
+            // items still share the cache, it's refreshed on expiry
+            zabbix_log(LOG_LEVEL_WARNING, "Cannot start docker.info refresh thread: %s", zbx_strerror(err));
+            info_pid = 0;
+            return;
+        }
+        zabbix_log(LOG_LEVEL_DEBUG, "docker.info cache started, TTL: %ds", info_ttl);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_module_docker_discovery                                      *
- *                                                                            *
- * Purpose: container discovery                                               *
+ * Function: zbx_docker_info_uninit                                           *
  *                                                                            *
- * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
- *                                 as not supported by zabbix                 *
- *               SYSINFO_RET_OK - success                                     *
+ * Purpose: stop refresh thread and release /info cache                       *
  *                                                                            *
  ******************************************************************************/
-int     zbx_module_docker_discovery(AGENT_REQUEST *request, AGENT_RESULT *result)
+void    zbx_docker_info_uninit()
 {
-        if (socket_api == 0 && zbx_docker_api_detect() == 0)
+        if (NULL == info_cache)
+                return;
+
+        if (getpid() == info_pid)
         {
-            return zbx_module_docker_discovery_basic(request, result);
-        } else {
-            return zbx_module_docker_discovery_extended(request, result);
+                pthread_mutex_lock(&info_lock);
+                info_stop = 1;
+                pthread_cond_signal(&info_cond);
+                pthread_mutex_unlock(&info_lock);
+                pthread_join(info_thread, NULL);
         }
+        munmap(info_cache, sizeof(zbx_docker_info_t));
+        info_cache = NULL;
 }
 
 /******************************************************************************
@@ -1880,8 +8638,10 @@ int     zbx_module_docker_discovery(AGENT_REQUEST *request, AGENT_RESULT *result
 int     zbx_module_docker_info(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
         zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_info()");
+        zbx_docker_path_t       *path;
+        const char              *answer;
 
-        if (socket_api == 0 && zbx_docker_api_detect() == 0)
+        if (zbx_docker_api_available() == 0)
         {
             zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not avalaible");
             SET_MSG_RESULT(result, strdup("Docker's socket API is not avalaible"));
@@ -1895,34 +8655,287 @@ int     zbx_module_docker_info(AGENT_REQUEST *request, AGENT_RESULT *result)
                 return SYSINFO_RET_FAIL;
         }
 
-        char    *info;
-        info = get_rparam(request, 0);
-        const char *answer = zbx_module_docker_socket_query("GET /info HTTP/1.0\r\n\n", 0);
-        if(strcmp(answer, "") == 0)
+        if (NULL == (path = zbx_docker_path_get(request, 0)))
+        {
+                SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid JSON path expression: %s", get_rparam(request, 0)));
+                return SYSINFO_RET_FAIL;
+        }
+
+        if (NULL == (answer = zbx_docker_info_get()))
         {
             zabbix_log(LOG_LEVEL_DEBUG, "docker.info is not available at the moment - some problem with Docker's socket API");
             SET_MSG_RESULT(result, strdup("docker.info is not available at the moment - some problem with Docker's socket API"));
             return SYSINFO_RET_FAIL;
         }
 
-        json_t *jp_data = json_loads(answer, 0, NULL);
-        const char* api_value = json_string_value(json_object_get(jp_data, info));
-        if (NULL == api_value)
+        return zbx_docker_path_result(request, result, path, answer, 0);
+}
+
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_cgroup_uint64                                         *
+ *                                                                            *
+ * Purpose: read single value cgroup file, e.g. memory.current                *
+ *                                                                            *
+ * Return value: SUCCEED, FAIL - file cannot be read or the value is not a    *
+ *               number (e.g. max)                                            *
+ *                                                                            *
+ ******************************************************************************/
+int     zbx_docker_cgroup_uint64(const char *cgroup, const char *container, const char *file, zbx_uint64_t *value)
+{
+        char    *filename, buffer[64];
+        int     ret = FAIL;
+
+        filename = zbx_docker_cgroup_path(cgroup, container, file);
+        if (0 < zbx_docker_read_file(filename, buffer, sizeof(buffer)) &&
+                        1 == zbx_docker_scan_uint64(buffer, strlen(buffer), value))
         {
-            zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s] item in the received JSON object", info);
-            SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot find the [%s] item in the received JSON object", info));
-            free((void*) answer);
-            json_decref(jp_data);
-            return SYSINFO_RET_FAIL;
-        } else {
-            zabbix_log(LOG_LEVEL_DEBUG, "Item [%s] found in the received JSON object: %s", info, api_value);
-            SET_STR_RESULT(result, zbx_strdup(NULL, api_value));
-            free((void*) answer);
-            json_decref(jp_data);
-            return SYSINFO_RET_OK;
+                ret = SUCCEED;
+        }
+        free(filename);
+
+        return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_blkio                                           *
+ *                                                                            *
+ * Purpose: blkio_stats array of Docker stats API from blkio file             *
+ *                                                                            *
+ * Parameters: filename - blkio.throttle.* file (v1) or io.stat (v2)          *
+ *             read, write - io.stat fields of read and write operations,     *
+ *                           NULL for v1 files with Read, Write, ... lines    *
+ *                                                                            *
+ * Return value: JSON array of {major, minor, op, value} objects              *
+ *                                                                            *
+ ******************************************************************************/
+json_t  *zbx_docker_stats_blkio(const char *filename, const char *read, const char *write)
+{
+        const zbx_docker_blkio_t        *blkio;
+        const zbx_docker_blkio_value_t  *v;
+        const char                      *op;
+        json_t                          *a = json_array(), *o;
+        int                             i;
+
+        if (NULL == (blkio = zbx_docker_blkio_get(filename)))
+                return a;
+
+        for (i = 0; i < blkio->values_num; i++)
+        {
+                v = &blkio->values[i];
+                if (0 == v->dev)
+                        continue;
+                if (NULL == read)
+                        op = v->op;
+                else if (0 == strcmp(v->op, read))
+                        op = "read";
+                else if (0 == strcmp(v->op, write))
+                        op = "write";
+                else
+                        continue;
+
+                o = json_object();
+                json_object_set_new(o, "major", json_integer(v->major));
+                json_object_set_new(o, "minor", json_integer(v->minor));
+                json_object_set_new(o, "op", json_string(op));
+                json_object_set_new(o, "value", json_integer(v->value));
+                json_array_append_new(a, o);
         }
+
+        return a;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_cgroup                                          *
+ *                                                                            *
+ * Purpose: stats document of the container synthesised from cgroup files     *
+ *          and /proc/<pid>/net/dev, without Docker API query                 *
+ *                                                                            *
+ * Parameters: container - container id or name                               *
+ *                                                                            *
+ * Return value: JSON document in the arena, NULL - container cgroup is not   *
+ *               found                                                        *
+ *                                                                            *
+ * Notes: only memory_stats, cpu_stats, blkio_stats, pids_stats and networks  *
+ *        are in the document, in the same shape as the Docker stats API      *
+ ******************************************************************************/
+char    *zbx_docker_stats_cgroup(const char *container)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_docker_stats_cgroup()");
+        zbx_docker_scan_t       scan;
+        zbx_docker_percpu_t     *cpus;
+        zbx_docker_netns_t      *netns;
+        zbx_docker_netif_t      *netif;
+        struct inspect_result   iresult;
+        json_t                  *j, *o, *s;
+        char                    *filename, *dump, *text, *buffer, *cgroup, *p, key[128];
+        zbx_uint64_t            value, memtotal = 0;
+        int                     i;
+
+        if (stat_dir == NULL || driver == NULL || (cpu_cgroup == NULL && zbx_docker_dir_detect() == SYSINFO_RET_FAIL))
+                return NULL;
+
+        // container name is translated to id by (cached) inspect document
+        if (SUCCEED != zbx_docker_cgroup_uint64("memory/", container, 1 == cgroup_v2 ? "/memory.current" :
+                        "/memory.usage_in_bytes", &value) &&
+                        (SYSINFO_RET_OK != (iresult = zbx_module_docker_inspect_exec(container, "Id", NULL,
+                        NULL)).return_code || SUCCEED != zbx_docker_cgroup_uint64("memory/", container =
+                        iresult.value, 1 == cgroup_v2 ? "/memory.current" : "/memory.usage_in_bytes", &value)))
+        {
+                zabbix_log(LOG_LEVEL_DEBUG, "Cannot read memory usage of container %s", container);
+                return NULL;
+        }
+
+        j = json_object();
+
+        // memory_stats - limit is capped at host memory as by Docker, memory.max "max" (v2) and unlimited
+        // memory.limit_in_bytes 9223372036854771712 (v1) are reported as MemTotal
+        o = json_object();
+        json_object_set_new(o, "usage", json_integer(value));
+        if (0 == cgroup_v2 && SUCCEED == zbx_docker_cgroup_uint64("memory/", container, "/memory.max_usage_in_bytes",
+                        &value))
+        {
+                json_object_set_new(o, "max_usage", json_integer(value));
+        }
+        filename = zbx_dsprintf(NULL, "%s/proc/meminfo", rootfs);
+        if (NULL != (buffer = zbx_docker_read_text(filename)) && NULL != (p = strstr(buffer, "MemTotal:")))
+                memtotal = strtoull(p + 9, NULL, 10) * 1024;
+        free(buffer);
+        free(filename);
+        if (SUCCEED == zbx_docker_cgroup_uint64("memory/", container, 1 == cgroup_v2 ? "/memory.max" :
+                        "/memory.limit_in_bytes", &value) && (0 == memtotal || value < memtotal))
+        {
+                json_object_set_new(o, "limit", json_integer(value));
+        }
+        else if (0 != memtotal)
+        {
+                json_object_set_new(o, "limit", json_integer(memtotal));
+        }
+        filename = zbx_docker_cgroup_path("memory/", container, "/memory.stat");
+        if (0 <= zbx_docker_scan_read(&scan, filename))
+        {
+                s = json_object();
+                for (i = 0; i < scan.lines_num; i++)
+                {
+                        if (1 != zbx_docker_scan_uint64(scan.lines[i].value, scan.lines[i].value_len, &value))
+                                continue;
+                        zbx_snprintf(key, sizeof(key), "%.*s", (int)scan.lines[i].key_len, scan.lines[i].key);
+                        json_object_set_new(s, key, json_integer(value));
+                }
+                json_object_set_new(o, "stats", s);
+        }
+        free(filename);
+        json_object_set_new(j, "memory_stats", o);
+
+        // cpu_stats - times in ns, system_cpu_usage is the sum of /proc/stat cpu line as in Docker
+        o = json_object();
+        s = json_object();
+        if (SYSINFO_RET_OK == zbx_docker_cpu_usage(container, "usage", &value))
+                json_object_set_new(s, "total_usage", json_integer(value));
+        if (0 == cgroup_v2 && NULL != (cpus = zbx_docker_cpu_percpu_get(container)))
+        {
+                json_t  *a = json_array();
+
+                for (i = 0; i < cpus->values_num; i++)
+                        json_array_append_new(a, json_integer(cpus->values[i]));
+                json_object_set_new(s, "percpu_usage", a);
+        }
+        if (SYSINFO_RET_OK == zbx_docker_cpu_usage(container, "usage_system", &value))
+                json_object_set_new(s, "usage_in_kernelmode", json_integer(value));
+        if (SYSINFO_RET_OK == zbx_docker_cpu_usage(container, "usage_user", &value))
+                json_object_set_new(s, "usage_in_usermode", json_integer(value));
+        json_object_set_new(o, "cpu_usage", s);
+
+        filename = zbx_dsprintf(NULL, "%s/proc/stat", rootfs);
+        if (NULL != (buffer = zbx_docker_read_text(filename)) && 0 == strncmp(buffer, "cpu ", 4))
+        {
+                // user, nice, system, idle, iowait, irq and softirq in USER_HZ
+                for (p = buffer + 4, value = 0, i = 0; i < 7; i++)
+                        value += strtoull(p, &p, 10);
+                json_object_set_new(o, "system_cpu_usage", json_integer(value * (1000000000 / clk_tck)));
+        }
+        free(buffer);
+        free(filename);
+        json_object_set_new(o, "online_cpus", json_integer(cpu_online));
+
+        cgroup = 1 == cgroup_v2 || NULL != strchr(cpu_cgroup, ',') ? cpu_cgroup : "cpu/";
+        filename = zbx_docker_cgroup_path(cgroup, container, "/cpu.stat");
+        if (0 <= zbx_docker_scan_read(&scan, filename))
+        {
+                s = json_object();
+                json_object_set_new(s, "periods", json_integer(zbx_docker_scan_get(&scan, ZBX_DOCKER_STAT_NR_PERIODS)));
+                json_object_set_new(s, "throttled_periods", json_integer(zbx_docker_scan_get(&scan,
+                                ZBX_DOCKER_STAT_NR_THROTTLED)));
+                json_object_set_new(s, "throttled_time", json_integer(1 == cgroup_v2 ?
+                                zbx_docker_scan_get(&scan, ZBX_DOCKER_STAT_THROTTLED_USEC) * 1000 :
+                                zbx_docker_scan_get(&scan, ZBX_DOCKER_STAT_THROTTLED_TIME)));
+                json_object_set_new(o, "throttling_data", s);
+        }
+        free(filename);
+        json_object_set_new(j, "cpu_stats", o);
+
+        // blkio_stats - v2 operations are read and write as in Docker
+        o = json_object();
+        if (1 == cgroup_v2)
+        {
+                filename = zbx_docker_cgroup_path("", container, "/io.stat");
+                json_object_set_new(o, "io_service_bytes_recursive", zbx_docker_stats_blkio(filename, "rbytes",
+                                "wbytes"));
+                json_object_set_new(o, "io_serviced_recursive", zbx_docker_stats_blkio(filename, "rios", "wios"));
+        }
+        else
+        {
+                filename = zbx_docker_cgroup_path("blkio/", container, "/blkio.throttle.io_service_bytes");
+                json_object_set_new(o, "io_service_bytes_recursive", zbx_docker_stats_blkio(filename, NULL, NULL));
+                free(filename);
+                filename = zbx_docker_cgroup_path("blkio/", container, "/blkio.throttle.io_serviced");
+                json_object_set_new(o, "io_serviced_recursive", zbx_docker_stats_blkio(filename, NULL, NULL));
+        }
+        free(filename);
+        json_object_set_new(j, "blkio_stats", o);
+
+        o = json_object();
+        if (SUCCEED == zbx_docker_cgroup_uint64("pids/", container, "/pids.current", &value))
+                json_object_set_new(o, "current", json_integer(value));
+        if (SUCCEED == zbx_docker_cgroup_uint64("pids/", container, "/pids.max", &value))
+                json_object_set_new(o, "limit", json_integer(value));
+        json_object_set_new(j, "pids_stats", o);
+
+        // networks - interfaces of container network namespace, except loopback
+        if (NULL != (netns = zbx_docker_netns_get(container)))
+        {
+                o = json_object();
+                for (i = 0; i < netns->ifs_num; i++)
+                {
+                        netif = &netns->ifs[i];
+                        if (0 == strcmp(netif->name, "lo"))
+                                continue;
+                        s = json_object();
+                        json_object_set_new(s, "rx_bytes", json_integer(netif->values[0]));
+                        json_object_set_new(s, "rx_packets", json_integer(netif->values[1]));
+                        json_object_set_new(s, "rx_errors", json_integer(netif->values[2]));
+                        json_object_set_new(s, "rx_dropped", json_integer(netif->values[3]));
+                        json_object_set_new(s, "tx_bytes", json_integer(netif->values[8]));
+                        json_object_set_new(s, "tx_packets", json_integer(netif->values[9]));
+                        json_object_set_new(s, "tx_errors", json_integer(netif->values[10]));
+                        json_object_set_new(s, "tx_dropped", json_integer(netif->values[11]));
+                        json_object_set_new(o, netif->name, s);
+                }
+                json_object_set_new(j, "networks", o);
+        }
+
+        dump = json_dumps(j, 0);
+        json_decref(j);
+        if (NULL == dump)
+                return NULL;
+        text = zbx_docker_arena_strdup(dump);
+        free(dump);
+
+        return text;
+}
 
 /******************************************************************************
  *                                                                            *
@@ -1939,21 +8952,52 @@ int     zbx_module_docker_stats(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
         zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_stats()");
 
-        if (socket_api == 0 && zbx_docker_api_detect() == 0)
+        return zbx_docker_path_item(request, result, ZBX_DOCKER_ENDPOINT_STATS);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_stats_derived                                  *
+ *                                                                            *
+ * Purpose: container metrics of docker stats command computed from one       *
+ *          stats document                                                    *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: JSON object for dependent items, CPU % is usage delta to system     *
+ *        usage delta since the previous call of the item (kept in the shared *
+ *        rate samples, precpu_stats of the first stream frame is empty), it  *
+ *        is not in the object of the first call,                             *
+ *        memory usage is without inactive file cache, network and blkio      *
+ *        bytes are summed over all interfaces and devices                    *
+ ******************************************************************************/
+int     zbx_module_docker_stats_derived(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_stats_derived()");
+        const char      *document, *cpu, *memory, *value, *op;
+        char            *container;
+        zbx_uint64_t    total = 0, system = 0, cpus = 0, usage = 0, limit = 0, cache, rx = 0, tx = 0, read = 0,
+                        write = 0, pids = 0, bytes, hash;
+        double          cpu_percent = 0, total_rate, system_rate;
+        AGENT_RESULT    rate_result;
+        json_t          *j;
+
+        if (zbx_docker_api_available() == 0)
         {
-            zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not avalaible");
-            SET_MSG_RESULT(result, strdup("Docker's socket API is not avalaible"));
+            zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not available");
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "Docker's socket API is not available"));
             return SYSINFO_RET_FAIL;
         }
 
-        if (1 >= request->nparam)
+        if (1 != request->nparam)
         {
                 zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
-                SET_MSG_RESULT(result, strdup("Invalid number of parameters"));
+                SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters"));
                 return SYSINFO_RET_FAIL;
         }
 
-        char    *container, *query;
         container = get_rparam(request, 0);
         // skip leading '/' in case of human name or short container id
         if (container[0] == '/')
@@ -1961,114 +9005,96 @@ int     zbx_module_docker_stats(AGENT_REQUEST *request, AGENT_RESULT *result)
             container++;
         }
 
-        size_t s_size = strlen("GET /containers/ /stats HTTP/1.0\r\n\n") + strlen(container);
-        query = malloc(s_size);
-        zbx_strlcpy(query, "GET /containers/", s_size);
-        zbx_strlcat(query, container, s_size);
-        zbx_strlcat(query, "/stats HTTP/1.0\r\n\n", s_size);
-        // stats output is stream
-        const char *answer = zbx_module_docker_socket_query(query, 1);
-        free(query);
-        if(strcmp(answer, "") == 0)
+        if (NULL == (document = zbx_docker_document_get(ZBX_DOCKER_ENDPOINT_STATS, container)) ||
+                        NULL == (cpu = zbx_docker_json_member(document, "cpu_stats")))
         {
-            zabbix_log(LOG_LEVEL_DEBUG, "docker.stats is not available at the moment - some problem with Docker's socket API");
-            SET_MSG_RESULT(result, strdup("docker.stats is not available at the moment - some problem with Docker's socket API"));
+            zabbix_log(LOG_LEVEL_DEBUG, "docker.stats.derived is not available at the moment - some problem with Docker's socket API");
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "docker.stats.derived is not available at the moment - some problem with Docker's socket API"));
             return SYSINFO_RET_FAIL;
         }
 
-        json_t *jp_data = json_loads(answer, 0, NULL);
+        // CPU % - as calculateCPUPercentUnix() of docker CLI, but the previous values are from the previous call
+        zbx_docker_json_uint64(zbx_docker_json_member(cpu, "cpu_usage"), "total_usage", &total);
+        zbx_docker_json_uint64(cpu, "system_cpu_usage", &system);
+        // cpu_percent is left out on the first call, other values don't depend on the previous one
+        hash = zbx_docker_rate_hash(request);
+        memset(&rate_result, 0, sizeof(rate_result));
+        if (SYSINFO_RET_OK != zbx_docker_rate_sample(hash, total, &total_rate, &rate_result))
+            cpu_percent = -1;
+        if (SYSINFO_RET_OK != zbx_docker_rate_sample(hash ^ __UINT64_C(0x9e3779b97f4a7c15), system, &system_rate,
+                &rate_result))
+        {
+            cpu_percent = -1;
+        }
+        free(rate_result.msg);
+        if (SUCCEED != zbx_docker_json_uint64(cpu, "online_cpus", &cpus) &&
+                NULL != (value = zbx_docker_json_member(cpu, "cpu_usage")) &&
+                NULL != (op = zbx_docker_json_member(value, "percpu_usage")))
+        {
+            for (value = zbx_docker_json_next(op, NULL); NULL != value; value = zbx_docker_json_next(op, value))
+                cpus++;
+        }
+        if (0 == cpu_percent && 0 < system_rate)
+            cpu_percent = total_rate / system_rate * cpus * 100.0;
 
-        if (request->nparam > 1)
+        // memory without inactive file cache, total_inactive_file on cgroup v1, inactive_file on v2
+        if (NULL != (memory = zbx_docker_json_member(document, "memory_stats")))
         {
-            char *param1;
-            param1 = get_rparam(request, 1);
-            // 1st level - plain value search
-            json_t *jp_data2 = json_object_get(jp_data, param1);
-            if (!json_is_string(jp_data2))
+            zbx_docker_json_uint64(memory, "usage", &usage);
+            zbx_docker_json_uint64(memory, "limit", &limit);
+            value = zbx_docker_json_member(memory, "stats");
+            if ((SUCCEED == zbx_docker_json_uint64(value, "total_inactive_file", &cache) ||
+                    SUCCEED == zbx_docker_json_uint64(value, "inactive_file", &cache)) && cache < usage)
             {
-                 // 1st level - json object search
-                if (NULL == jp_data2)
-                {
-                    zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s] item in the received JSON object", param1);
-                    SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot find the [%s] item in the received JSON object", param1));
-                    free((void*) answer);
-                    json_decref(jp_data);
-                    return SYSINFO_RET_FAIL;
-                } else {
-                    // 2nd level
-                    if (request->nparam > 2)
-                    {
-                        char *param2;
-                        param2 = get_rparam(request, 2);
-                        json_t *jp_data3 = json_object_get(jp_data2, param2);
-                        if (!json_is_string(jp_data3))
-                        {
-                            // 2nd level - json object search
-                            if (NULL == jp_data3)
-                            {
-                                zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s] item in the received JSON object", param1, param2);
-                                SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot find the [%s][%s] item in the received JSON object", param1, param2));
-                                free((void*) answer);
-                                json_decref(jp_data);
-                                return SYSINFO_RET_FAIL;
-                            } else {
-                                // 3rd level
-                                if (request->nparam > 3)
-                                {
-                                    char *param3;
-                                    param3 = get_rparam(request, 3);
-                                    json_t *jp_data4 = json_object_get(jp_data3, param3);
-                                    if (NULL == jp_data4)
-                                    {
-                                        zabbix_log(LOG_LEVEL_WARNING, "Cannot find the [%s][%s][%s] item in the received JSON object", param1, param2, param3);
-                                        SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot find the [%s][%s][%s] item in the received JSON object", param1, param2, param3));
-                                        free((void*) answer);
-                                        json_decref(jp_data);
-                                        return SYSINFO_RET_FAIL;
-                                    } else {
-                                        const char *api_value3 = json_dumps(jp_data4, JSON_ENCODE_ANY);
-                                        zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s][%s] found in the received JSON object: %s", param1, param2, param3, api_value3);
-                                        SET_STR_RESULT(result, api_value3);
-                                        free((void*) answer);
-                                        json_decref(jp_data);
-                                        return SYSINFO_RET_OK;
-                                    }
-                                } else {
-                                    const char *api_value2 = json_dumps(jp_data3, 0);
-                                    zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s] found the received JSON object: %s", param1, param2, api_value2);
-                                    SET_STR_RESULT(result, api_value2);
-                                    free((void*) answer);
-                                    json_decref(jp_data);
-                                    return SYSINFO_RET_OK;
-                                }
-                            }
-                        } else {
-                            const char *api_value2 = json_string_value(jp_data3);
-                            zabbix_log(LOG_LEVEL_DEBUG, "Item [%s][%s] found in the received JSON object: %s", param1, param2, api_value2);
-                            SET_STR_RESULT(result, zbx_strdup(NULL, api_value2));
-                            free((void*) answer);
-                            json_decref(jp_data);
-                            return SYSINFO_RET_OK;
-                        }
-                    } else {
-                        zabbix_log(LOG_LEVEL_WARNING, "Item [%s] found in the received JSON object, but it's not plain value object", param1);
-                        SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Item [%s] found in the received JSON object, but it's not plain value object", param1));
-                        free((void*) answer);
-                        json_decref(jp_data);
-                        return SYSINFO_RET_FAIL;
-                    }
-                }
-            } else {
-                    const char* api_value = json_string_value(jp_data2);
-                    zabbix_log(LOG_LEVEL_DEBUG, "Item [%s] found in the received JSON object: %s", param1, api_value);
-                    SET_STR_RESULT(result, zbx_strdup(NULL, api_value));
-                    free((void*) answer);
-                    json_decref(jp_data);
-                    return SYSINFO_RET_OK;
+                usage -= cache;
             }
         }
-        free((void*) answer);
-        json_decref(jp_data);
+
+        if (NULL != (op = zbx_docker_json_member(document, "networks")))
+        {
+            for (value = zbx_docker_json_next(op, NULL); NULL != value; value = zbx_docker_json_next(op, value))
+            {
+                if (SUCCEED == zbx_docker_json_uint64(value, "rx_bytes", &bytes))
+                    rx += bytes;
+                if (SUCCEED == zbx_docker_json_uint64(value, "tx_bytes", &bytes))
+                    tx += bytes;
+            }
+        }
+
+        // blkio entries of Read and Write (v1) or read and write (v2) operations
+        if (NULL != (op = zbx_docker_json_member(document, "blkio_stats")) &&
+                NULL != (op = zbx_docker_json_member(op, "io_service_bytes_recursive")))
+        {
+            for (value = zbx_docker_json_next(op, NULL); NULL != value; value = zbx_docker_json_next(op, value))
+            {
+                const char *name = zbx_docker_json_member(value, "op");
+
+                if (NULL == name || '"' != *name || SUCCEED != zbx_docker_json_uint64(value, "value", &bytes))
+                    continue;
+                if ('r' == name[1] || 'R' == name[1])
+                    read += bytes;
+                else if ('w' == name[1] || 'W' == name[1])
+                    write += bytes;
+            }
+        }
+
+        zbx_docker_json_uint64(zbx_docker_json_member(document, "pids_stats"), "current", &pids);
+
+        j = json_object();
+        if (0 <= cpu_percent)
+            json_object_set_new(j, "cpu_percent", json_real(cpu_percent));
+        json_object_set_new(j, "online_cpus", json_integer(cpus));
+        json_object_set_new(j, "memory_usage", json_integer(usage));
+        json_object_set_new(j, "memory_limit", json_integer(limit));
+        json_object_set_new(j, "memory_percent", json_real(0 == limit ? 0 : (double)usage / limit * 100.0));
+        json_object_set_new(j, "net_rx_bytes", json_integer(rx));
+        json_object_set_new(j, "net_tx_bytes", json_integer(tx));
+        json_object_set_new(j, "blkio_read_bytes", json_integer(read));
+        json_object_set_new(j, "blkio_write_bytes", json_integer(write));
+        json_object_set_new(j, "pids", json_integer(pids));
+
+        SET_STR_RESULT(result, json_dumps(j, 0));
+        json_decref(j);
         return SYSINFO_RET_OK;
 }
 
@@ -2087,7 +9113,7 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
         zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_cstatus()");
 
-        if (socket_api == 0 && zbx_docker_api_detect() == 0)
+        if (zbx_docker_api_available() == 0)
         {
             zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not avalaible");
             SET_MSG_RESULT(result, strdup("Docker's socket API is not avalaible"));
@@ -2123,7 +9149,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                 count = json_array_size(jp_data);
                 json_decref(jp_data);
             }
-            free((void*) answer);
             zabbix_log(LOG_LEVEL_DEBUG, "Count of containers in %s status: %d", state, count);
             SET_UI64_RESULT(result, count);
             return SYSINFO_RET_OK;
@@ -2148,7 +9173,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                     count = json_array_size(jp_data);
                     json_decref(jp_data);
                 }
-                free((void*) answer);
 
                 // # Up
                 const char *answer2 = zbx_module_docker_socket_query("GET /containers/json?all=0 HTTP/1.0\r\n\n", 0);
@@ -2164,7 +9188,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                     count = count - json_array_size(jp_data);
                     json_decref(jp_data);
                 }
-                free((void*) answer2);
                 zabbix_log(LOG_LEVEL_DEBUG, "Count of containers in %s status: %d", state, count);
                 SET_UI64_RESULT(result, count);
                 return SYSINFO_RET_OK;
@@ -2184,7 +9207,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                     // empty response
                     if (strcmp(answer, "[]\n") == 0) {
                        SET_UI64_RESULT(result, 0);
-                       free((void*) answer);
                        return SYSINFO_RET_OK;
                     }
 
@@ -2219,7 +9241,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
 
                     zabbix_log(LOG_LEVEL_DEBUG, "Count of containers in %s status: %d", state, count);
                     SET_UI64_RESULT(result, count);
-                    free((void*) answer);
                     json_decref(jp_data);
                     return SYSINFO_RET_OK;
                 } else {
@@ -2240,7 +9261,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                             count = json_array_size(jp_data);
                             json_decref(jp_data);
                         }
-                        free((void*) answer);
                         zabbix_log(LOG_LEVEL_DEBUG, "Count of containers in %s status: %d", state, count);
                         SET_UI64_RESULT(result, count);
                         return SYSINFO_RET_OK;
@@ -2260,7 +9280,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                             // empty reponse
                             if (strcmp(answer, "[]\n") == 0) {
                                SET_UI64_RESULT(result, 0);
-                               free((void*) answer);
                                return SYSINFO_RET_OK;
                             }
 
@@ -2292,7 +9311,6 @@ int     zbx_module_docker_cstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                                 }
                             }
 
-                            free((void*) answer);
                             json_decref(jp_data);
                             zabbix_log(LOG_LEVEL_DEBUG, "Count of containers in %s status: %d", state, count);
                             SET_UI64_RESULT(result, count);
@@ -2325,7 +9343,7 @@ int     zbx_module_docker_istatus(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
         zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_istatus()");
 
-        if (socket_api == 0 && zbx_docker_api_detect() == 0)
+        if (zbx_docker_api_available() == 0)
         {
             zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not avalaible");
             SET_MSG_RESULT(result, strdup("Docker's socket API is not avalaible"));
@@ -2360,7 +9378,6 @@ int     zbx_module_docker_istatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                 count = json_array_size(jp_data);
                 json_decref(jp_data);
             }
-            free((void*) answer);
             zabbix_log(LOG_LEVEL_DEBUG, "Count of images in %s status: %d", state, count);
             SET_UI64_RESULT(result, count);
             return SYSINFO_RET_OK;
@@ -2379,7 +9396,6 @@ int     zbx_module_docker_istatus(AGENT_REQUEST *request, AGENT_RESULT *result)
                 count = json_array_size(jp_data);
                 json_decref(jp_data);
             }
-            free((void*) answer);
             zabbix_log(LOG_LEVEL_DEBUG, "Count of images in %s status: %d", state, count);
             SET_UI64_RESULT(result, count);
             return SYSINFO_RET_OK;
@@ -2405,7 +9421,7 @@ int     zbx_module_docker_vstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
         zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_vstatus()");
 
-        if (socket_api == 0 && zbx_docker_api_detect() == 0)
+        if (zbx_docker_api_available() == 0)
         {
             zabbix_log(LOG_LEVEL_DEBUG, "Docker's socket API is not avalaible");
             SET_MSG_RESULT(result, strdup("Docker's socket API is not avalaible"));
@@ -2446,13 +9462,11 @@ int     zbx_module_docker_vstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
 
             if (NULL != jp_data2) {
                 count = json_array_size(jp_data2);
-                free((void*) answer);
                 json_decref(jp_data);
                 zabbix_log(LOG_LEVEL_DEBUG, "Count of volumes in %s status: %d", state, count);
                 SET_UI64_RESULT(result, count);
                 return SYSINFO_RET_OK;
             } else {
-                free((void*) answer);
                 json_decref(jp_data);
                 count = 0;
                 zabbix_log(LOG_LEVEL_DEBUG, "Count of volumes in %s status: %d", state, count);
@@ -2482,13 +9496,11 @@ int     zbx_module_docker_vstatus(AGENT_REQUEST *request, AGENT_RESULT *result)
 
             if (NULL != jp_data2) {
                 count = json_array_size(jp_data2);
-                free((void*) answer);
                 json_decref(jp_data);
                 zabbix_log(LOG_LEVEL_DEBUG, "Count of volumes in %s status: %d", state, count);
                 SET_UI64_RESULT(result, count);
                 return SYSINFO_RET_OK;
             } else {
-                free((void*) answer);
                 json_decref(jp_data);
                 count = 0;
                 zabbix_log(LOG_LEVEL_DEBUG, "Count of volumes in %s status: %d", state, count);
@@ -2519,3 +9531,216 @@ int     zbx_module_docker_modver(AGENT_REQUEST *request, AGENT_RESULT *result)
         SET_STR_RESULT(result, zbx_strdup(NULL, m_version));
         return SYSINFO_RET_OK;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stats_json                                            *
+ *                                                                            *
+ * Purpose: sum counters of all agent processes into JSON object              *
+ *                                                                            *
+ * Return value: JSON object with count, errors, bytes, latency and histogram *
+ *                                                                            *
+ ******************************************************************************/
+json_t  *zbx_docker_stats_json(size_t offset, const char *count_name, int with_bytes)
+{
+        zbx_docker_counter_t    sum;
+        const zbx_docker_counter_t      *counter;
+        json_t  *o = json_object(), *h = json_object();
+        char    bucket[16];
+        int     i, b;
+
+        memset(&sum, 0, sizeof(sum));
+        for (i = 0; i < ZBX_DOCKER_STATS_SLOTS && NULL != stats; i++)
+        {
+            // there is only one (process local) slot without shared memory
+            if (stats == stats_slot && 0 != i)
+                break;
+            counter = (const zbx_docker_counter_t *)((const char *)&stats[i] + offset);
+            sum.count += __atomic_load_n(&counter->count, __ATOMIC_RELAXED);
+            sum.errors += __atomic_load_n(&counter->errors, __ATOMIC_RELAXED);
+            sum.bytes += __atomic_load_n(&counter->bytes, __ATOMIC_RELAXED);
+            sum.latency_us += __atomic_load_n(&counter->latency_us, __ATOMIC_RELAXED);
+            for (b = 0; b < ZBX_DOCKER_STATS_BUCKETS; b++)
+                sum.histogram[b] += __atomic_load_n(&counter->histogram[b], __ATOMIC_RELAXED);
+        }
+
+        json_object_set_new(o, count_name, json_integer(sum.count));
+        json_object_set_new(o, "errors", json_integer(sum.errors));
+        if (1 == with_bytes)
+            json_object_set_new(o, "bytes_read", json_integer(sum.bytes));
+        json_object_set_new(o, "latency_avg_ms", json_real(0 == sum.count ? 0 : sum.latency_us / 1000.0 / sum.count));
+        for (b = 0; b < ZBX_DOCKER_STATS_BUCKETS; b++)
+        {
+            if (b < ZBX_DOCKER_STATS_BUCKETS - 1)
+                zbx_snprintf(bucket, sizeof(bucket), "%dms", stats_bucket_ms[b]);
+            else
+                zbx_strlcpy(bucket, "inf", sizeof(bucket));
+            json_object_set_new(h, bucket, json_integer(sum.histogram[b]));
+        }
+        json_object_set_new(o, "latency_histogram", h);
+        return o;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_module_stats                                   *
+ *                                                                            *
+ * Purpose: module self-instrumentation - item keys calls, errors and         *
+ *          latency, Docker API round-trips and cache hit/miss rates          *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: latency histogram bucket "Nms" counts calls faster than N ms,       *
+ *        which weren't counted in the previous bucket                        *
+ ******************************************************************************/
+int     zbx_module_docker_module_stats(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_module_stats()");
+        json_t  *j, *o, *socket, *endpoints;
+        zbx_uint64_t    hits, misses, count = 0, errors = 0, bytes = 0;
+        int     i, slot, processes = 0;
+
+        if (NULL == stats)
+        {
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "Module statistics are not available"));
+            return SYSINFO_RET_FAIL;
+        }
+
+        for (slot = 0; slot < ZBX_DOCKER_STATS_SLOTS; slot++)
+        {
+            if (0 != stats[slot].pid)
+                processes++;
+            if (stats == stats_slot)
+                break;
+        }
+
+        j = json_object();
+        json_object_set_new(j, "version", json_string(m_version));
+        json_object_set_new(j, "uptime", json_integer(time(NULL) - stats_start));
+        json_object_set_new(j, "processes", json_integer(stats == stats_slot ? 1 : processes));
+
+        o = json_object();
+        for (i = 0; NULL != keys[i].key && i < ZBX_DOCKER_STATS_KEYS; i++)
+        {
+            json_object_set_new(o, keys[i].key, zbx_docker_stats_json(offsetof(zbx_docker_stats_t, keys[i]), "calls", 0));
+        }
+        json_object_set_new(j, "keys", o);
+
+        socket = json_object();
+        endpoints = json_object();
+        for (i = 0; i < ZBX_DOCKER_ENDPOINT_COUNT; i++)
+        {
+            o = zbx_docker_stats_json(offsetof(zbx_docker_stats_t, endpoints[i]), "requests", 1);
+            count += json_integer_value(json_object_get(o, "requests"));
+            errors += json_integer_value(json_object_get(o, "errors"));
+            bytes += json_integer_value(json_object_get(o, "bytes_read"));
+            json_object_set_new(endpoints, stats_endpoint_names[i], o);
+        }
+        json_object_set_new(socket, "round_trips", json_integer(count));
+        json_object_set_new(socket, "errors", json_integer(errors));
+        json_object_set_new(socket, "bytes_read", json_integer(bytes));
+        json_object_set_new(socket, "endpoints", endpoints);
+        json_object_set_new(j, "socket", socket);
+
+        o = json_object();
+        for (i = 0; i < ZBX_DOCKER_CACHE_COUNT; i++)
+        {
+            json_t  *c = json_object();
+
+            hits = misses = 0;
+            for (slot = 0; slot < ZBX_DOCKER_STATS_SLOTS; slot++)
+            {
+                hits += __atomic_load_n(&stats[slot].cache_hits[i], __ATOMIC_RELAXED);
+                misses += __atomic_load_n(&stats[slot].cache_misses[i], __ATOMIC_RELAXED);
+                if (stats == stats_slot)
+                    break;
+            }
+            json_object_set_new(c, "hits", json_integer(hits));
+            json_object_set_new(c, "misses", json_integer(misses));
+            json_object_set_new(c, "hit_rate", json_real(0 == hits + misses ? 0 : (double)hits / (hits + misses)));
+            json_object_set_new(o, stats_cache_names[i], c);
+        }
+        json_object_set_new(j, "caches", o);
+
+        SET_STR_RESULT(result, json_dumps(j, 0));
+        json_decref(j);
+        return SYSINFO_RET_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_module_docker_module_trace                                   *
+ *                                                                            *
+ * Purpose: dump trace ring of recent Docker API queries                      *
+ *                                                                            *
+ * Return value: SYSINFO_RET_FAIL - function failed, item will be marked      *
+ *                                 as not supported by zabbix                 *
+ *               SYSINFO_RET_OK - success                                     *
+ *                                                                            *
+ * Notes: only request lines and timings are recorded, not whole bodies;      *
+ *        entries are ordered from the oldest one                             *
+ ******************************************************************************/
+int     zbx_module_docker_module_trace(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+        zabbix_log(LOG_LEVEL_DEBUG, "In zbx_module_docker_module_trace()");
+        zbx_docker_trace_t      entry;
+        zbx_uint64_t            next, seq, first;
+        json_t                  *j, *a, *o;
+        char                    *param;
+        int                     count = ZBX_DOCKER_TRACE_SIZE;
+
+        if (1 < request->nparam)
+        {
+            zabbix_log(LOG_LEVEL_ERR, "Invalid number of parameters: %d",  request->nparam);
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters"));
+            return SYSINFO_RET_FAIL;
+        }
+        if (NULL != (param = get_rparam(request, 0)) && '\0' != *param &&
+                (0 >= (count = atoi(param)) || ZBX_DOCKER_TRACE_SIZE < count))
+        {
+            SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid count, it must be 1 - %d", ZBX_DOCKER_TRACE_SIZE));
+            return SYSINFO_RET_FAIL;
+        }
+        if (NULL == trace)
+        {
+            SET_MSG_RESULT(result, zbx_strdup(NULL, "Docker API trace is not available"));
+            return SYSINFO_RET_FAIL;
+        }
+
+        next = __atomic_load_n(&trace->next, __ATOMIC_ACQUIRE);
+        first = next > (zbx_uint64_t)count ? next - count + 1 : 1;
+        a = json_array();
+        for (seq = first; seq <= next; seq++)
+        {
+            const zbx_docker_trace_t        *e = &trace->entries[(seq - 1) % ZBX_DOCKER_TRACE_SIZE];
+
+            // skip entry which is being (re)written
+            if (seq != __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE))
+                continue;
+            memcpy(&entry, e, sizeof(entry));
+            // entry data must be loaded before seq is checked again
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (seq != __atomic_load_n(&e->seq, __ATOMIC_RELAXED))
+                continue;
+            entry.request[sizeof(entry.request) - 1] = '\0';
+
+            o = json_object();
+            json_object_set_new(o, "clock", json_integer(entry.clock));
+            json_object_set_new(o, "pid", json_integer(entry.pid));
+            json_object_set_new(o, "request", json_string(entry.request));
+            json_object_set_new(o, "status", json_integer(entry.status));
+            json_object_set_new(o, "error", json_integer(entry.error));
+            json_object_set_new(o, "bytes_read", json_integer(entry.bytes));
+            json_object_set_new(o, "latency_ms", json_real(entry.latency_us / 1000.0));
+            json_array_append_new(a, o);
+        }
+
+        j = json_object();
+        json_object_set_new(j, "queries", json_integer(next));
+        json_object_set_new(j, "trace", a);
+        SET_STR_RESULT(result, json_dumps(j, 0));
+        json_decref(j);
+        return SYSINFO_RET_OK;
+}
@@ -0,0 +1,665 @@
+/*
+** Zabbix module for Docker container monitoring
+** Copyright (C) 2014-2017 Jan Garaj - www.monitoringartist.com
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+** cgroup stat-file scanner: "<key> <value>\n" files (memory.stat, cpu.stat,
+** cpuacct.stat, io.stat lines) are read by a single read() into a fixed buffer,
+** newlines and spaces are located by SSE2/AVX2 (scalar fallback) and known keys
+** are resolved by a perfect hash generated by tools/stat_keys_gen.py.
+**
+** The header doesn't depend on Zabbix headers, it's used by tools/scan_bench.c.
+*/
+
+#ifndef ZABBIX_MODULE_DOCKER_SCAN_H
+#define ZABBIX_MODULE_DOCKER_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && !defined(ZBX_DOCKER_SCAN_SCALAR)
+#       include <immintrin.h>
+#       define ZBX_DOCKER_SCAN_X86
+#endif
+
+#define ZBX_DOCKER_SCAN_SIZE    8192    // max size of scanned file, multiple of 64
+#define ZBX_DOCKER_SCAN_LINES   256     // max number of scanned lines
+
+// generated by tools/stat_keys_gen.py - do not edit - begin
+enum
+{
+        ZBX_DOCKER_STAT_CACHE,
+        ZBX_DOCKER_STAT_RSS,
+        ZBX_DOCKER_STAT_RSS_HUGE,
+        ZBX_DOCKER_STAT_SHMEM,
+        ZBX_DOCKER_STAT_MAPPED_FILE,
+        ZBX_DOCKER_STAT_DIRTY,
+        ZBX_DOCKER_STAT_WRITEBACK,
+        ZBX_DOCKER_STAT_SWAP,
+        ZBX_DOCKER_STAT_PGPGIN,
+        ZBX_DOCKER_STAT_PGPGOUT,
+        ZBX_DOCKER_STAT_PGFAULT,
+        ZBX_DOCKER_STAT_PGMAJFAULT,
+        ZBX_DOCKER_STAT_INACTIVE_ANON,
+        ZBX_DOCKER_STAT_ACTIVE_ANON,
+        ZBX_DOCKER_STAT_INACTIVE_FILE,
+        ZBX_DOCKER_STAT_ACTIVE_FILE,
+        ZBX_DOCKER_STAT_UNEVICTABLE,
+        ZBX_DOCKER_STAT_TOTAL_CACHE,
+        ZBX_DOCKER_STAT_TOTAL_RSS,
+        ZBX_DOCKER_STAT_TOTAL_RSS_HUGE,
+        ZBX_DOCKER_STAT_TOTAL_SHMEM,
+        ZBX_DOCKER_STAT_TOTAL_MAPPED_FILE,
+        ZBX_DOCKER_STAT_TOTAL_DIRTY,
+        ZBX_DOCKER_STAT_TOTAL_WRITEBACK,
+        ZBX_DOCKER_STAT_TOTAL_SWAP,
+        ZBX_DOCKER_STAT_TOTAL_PGPGIN,
+        ZBX_DOCKER_STAT_TOTAL_PGPGOUT,
+        ZBX_DOCKER_STAT_TOTAL_PGFAULT,
+        ZBX_DOCKER_STAT_TOTAL_PGMAJFAULT,
+        ZBX_DOCKER_STAT_TOTAL_INACTIVE_ANON,
+        ZBX_DOCKER_STAT_TOTAL_ACTIVE_ANON,
+        ZBX_DOCKER_STAT_TOTAL_INACTIVE_FILE,
+        ZBX_DOCKER_STAT_TOTAL_ACTIVE_FILE,
+        ZBX_DOCKER_STAT_TOTAL_UNEVICTABLE,
+        ZBX_DOCKER_STAT_HIERARCHICAL_MEMORY_LIMIT,
+        ZBX_DOCKER_STAT_HIERARCHICAL_MEMSW_LIMIT,
+        ZBX_DOCKER_STAT_ANON,
+        ZBX_DOCKER_STAT_FILE,
+        ZBX_DOCKER_STAT_KERNEL,
+        ZBX_DOCKER_STAT_KERNEL_STACK,
+        ZBX_DOCKER_STAT_PAGETABLES,
+        ZBX_DOCKER_STAT_SEC_PAGETABLES,
+        ZBX_DOCKER_STAT_PERCPU,
+        ZBX_DOCKER_STAT_SOCK,
+        ZBX_DOCKER_STAT_VMALLOC,
+        ZBX_DOCKER_STAT_ZSWAP,
+        ZBX_DOCKER_STAT_ZSWAPPED,
+        ZBX_DOCKER_STAT_FILE_MAPPED,
+        ZBX_DOCKER_STAT_FILE_DIRTY,
+        ZBX_DOCKER_STAT_FILE_WRITEBACK,
+        ZBX_DOCKER_STAT_SWAPCACHED,
+        ZBX_DOCKER_STAT_ANON_THP,
+        ZBX_DOCKER_STAT_FILE_THP,
+        ZBX_DOCKER_STAT_SHMEM_THP,
+        ZBX_DOCKER_STAT_SLAB_RECLAIMABLE,
+        ZBX_DOCKER_STAT_SLAB_UNRECLAIMABLE,
+        ZBX_DOCKER_STAT_SLAB,
+        ZBX_DOCKER_STAT_WORKINGSET_REFAULT_ANON,
+        ZBX_DOCKER_STAT_WORKINGSET_REFAULT_FILE,
+        ZBX_DOCKER_STAT_WORKINGSET_ACTIVATE_ANON,
+        ZBX_DOCKER_STAT_WORKINGSET_ACTIVATE_FILE,
+        ZBX_DOCKER_STAT_WORKINGSET_RESTORE_ANON,
+        ZBX_DOCKER_STAT_WORKINGSET_RESTORE_FILE,
+        ZBX_DOCKER_STAT_WORKINGSET_NODERECLAIM,
+        ZBX_DOCKER_STAT_PGSCAN,
+        ZBX_DOCKER_STAT_PGSTEAL,
+        ZBX_DOCKER_STAT_PGSCAN_KSWAPD,
+        ZBX_DOCKER_STAT_PGSCAN_DIRECT,
+        ZBX_DOCKER_STAT_PGSCAN_KHUGEPAGED,
+        ZBX_DOCKER_STAT_PGSTEAL_KSWAPD,
+        ZBX_DOCKER_STAT_PGSTEAL_DIRECT,
+        ZBX_DOCKER_STAT_PGSTEAL_KHUGEPAGED,
+        ZBX_DOCKER_STAT_PGREFILL,
+        ZBX_DOCKER_STAT_PGACTIVATE,
+        ZBX_DOCKER_STAT_PGDEACTIVATE,
+        ZBX_DOCKER_STAT_PGLAZYFREE,
+        ZBX_DOCKER_STAT_PGLAZYFREED,
+        ZBX_DOCKER_STAT_ZSWPIN,
+        ZBX_DOCKER_STAT_ZSWPOUT,
+        ZBX_DOCKER_STAT_THP_FAULT_ALLOC,
+        ZBX_DOCKER_STAT_THP_COLLAPSE_ALLOC,
+        ZBX_DOCKER_STAT_NR_PERIODS,
+        ZBX_DOCKER_STAT_NR_THROTTLED,
+        ZBX_DOCKER_STAT_THROTTLED_TIME,
+        ZBX_DOCKER_STAT_USAGE_USEC,
+        ZBX_DOCKER_STAT_USER_USEC,
+        ZBX_DOCKER_STAT_SYSTEM_USEC,
+        ZBX_DOCKER_STAT_THROTTLED_USEC,
+        ZBX_DOCKER_STAT_NR_BURSTS,
+        ZBX_DOCKER_STAT_BURST_USEC,
+        ZBX_DOCKER_STAT_CORE_SCHED_FORCE_IDLE_USEC,
+        ZBX_DOCKER_STAT_USER,
+        ZBX_DOCKER_STAT_SYSTEM,
+        ZBX_DOCKER_STAT_RBYTES,
+        ZBX_DOCKER_STAT_WBYTES,
+        ZBX_DOCKER_STAT_RIOS,
+        ZBX_DOCKER_STAT_WIOS,
+        ZBX_DOCKER_STAT_DBYTES,
+        ZBX_DOCKER_STAT_DIOS,
+        ZBX_DOCKER_STAT_COUNT
+};
+
+static const char      *const zbx_docker_stat_names[ZBX_DOCKER_STAT_COUNT] =
+{
+        "cache", "rss", "rss_huge", "shmem", "mapped_file", "dirty", "writeback", "swap", "pgpgin", "pgpgout",
+        "pgfault", "pgmajfault", "inactive_anon", "active_anon", "inactive_file", "active_file", "unevictable",
+        "total_cache", "total_rss", "total_rss_huge", "total_shmem", "total_mapped_file", "total_dirty",
+        "total_writeback", "total_swap", "total_pgpgin", "total_pgpgout", "total_pgfault", "total_pgmajfault",
+        "total_inactive_anon", "total_active_anon", "total_inactive_file", "total_active_file",
+        "total_unevictable", "hierarchical_memory_limit", "hierarchical_memsw_limit", "anon", "file", "kernel",
+        "kernel_stack", "pagetables", "sec_pagetables", "percpu", "sock", "vmalloc", "zswap", "zswapped",
+        "file_mapped", "file_dirty", "file_writeback", "swapcached", "anon_thp", "file_thp", "shmem_thp",
+        "slab_reclaimable", "slab_unreclaimable", "slab", "workingset_refault_anon", "workingset_refault_file",
+        "workingset_activate_anon", "workingset_activate_file", "workingset_restore_anon",
+        "workingset_restore_file", "workingset_nodereclaim", "pgscan", "pgsteal", "pgscan_kswapd",
+        "pgscan_direct", "pgscan_khugepaged", "pgsteal_kswapd", "pgsteal_direct", "pgsteal_khugepaged",
+        "pgrefill", "pgactivate", "pgdeactivate", "pglazyfree", "pglazyfreed", "zswpin", "zswpout",
+        "thp_fault_alloc", "thp_collapse_alloc", "nr_periods", "nr_throttled", "throttled_time", "usage_usec",
+        "user_usec", "system_usec", "throttled_usec", "nr_bursts", "burst_usec", "core_sched.force_idle_usec",
+        "user", "system", "rbytes", "wbytes", "rios", "wios", "dbytes", "dios",
+};
+
+#define ZBX_DOCKER_STAT_HASH_SEED       0x811c9dddU
+#define ZBX_DOCKER_STAT_HASH_MASK       0x3ff
+
+// hash slot -> ZBX_DOCKER_STAT_* id, -1 for empty slot
+static const short     zbx_docker_stat_slots[ZBX_DOCKER_STAT_HASH_MASK + 1] =
+{
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, 71, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, 10, -1, 23, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, 62, -1, -1, -1, 35, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, 48, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 56, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, 55, 64, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 26, 57, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 30,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, 40, 87, 94, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 41, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, 25, -1, -1, -1, -1, -1, 9,
+        -1, -1, -1, 3, -1, -1, 7, -1, -1, -1, -1, -1, 51, -1, -1, -1,
+        -1, 73, -1, 60, 76, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 28,
+        -1, -1, -1, -1, -1, -1, 20, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 86, -1, -1, -1, -1, -1, 78, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, 36, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, 49, 70, -1, -1, -1, -1, -1, -1, 63, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, 47, -1, -1, -1, -1, 17, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 37, -1, -1, -1, -1,
+        38, 27, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 68, -1, -1, -1, -1, -1, -1, 98, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, 21, -1, 77, -1, -1, -1, -1, 46, -1, -1, 15, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 82, -1,
+        -1, -1, 89, -1, -1, -1, 42, -1, -1, -1, 13, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, 54, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, 88, -1, -1, -1, -1, -1, 59,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 84, -1, -1,
+        -1, -1, -1, 16, -1, -1, -1, -1, 81, 44, -1, -1, 93, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, 53, -1, -1, -1, -1, -1, -1, 6,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, 24, -1, -1, -1, -1, 95, -1,
+        -1, -1, -1, -1, 92, -1, -1, -1, -1, -1, -1, 1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, 80, -1, -1, -1, -1, 29, -1,
+        -1, -1, -1, -1, -1, -1, 79, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, 67, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, 12, 19, -1, -1, -1, 11, 0, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, 72, 83, -1, 39, 66, -1, 91, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, 34, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, 31, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, 33, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, 2, -1, -1, 74, -1, -1, -1, -1, -1, -1, -1, 45, -1,
+        -1, -1, -1, 32, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        50, -1, 18, -1, -1, -1, -1, 96, -1, -1, -1, -1, -1, -1, 22, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 97, 58,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 69, -1,
+        -1, -1, -1, -1, -1, -1, -1, 90, -1, -1, -1, -1, -1, 43, -1, -1,
+        61, -1, -1, -1, -1, -1, -1, -1, 75, -1, -1, 65, -1, -1, -1, 85,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 14, -1, -1, -1, -1,
+        52, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+// generated by tools/stat_keys_gen.py - end
+
+#define ZBX_DOCKER_SCAN_ISA_SCALAR      0
+#define ZBX_DOCKER_SCAN_ISA_SSE2        1
+#define ZBX_DOCKER_SCAN_ISA_AVX2        2
+
+// instruction set used by the scanner, detected on first scan (-1)
+static int      zbx_docker_scan_isa = -1;
+
+typedef struct
+{
+        const char      *key;
+        const char      *value;
+        unsigned short  key_len;
+        unsigned short  value_len;
+}
+zbx_docker_scan_line_t;
+
+typedef struct
+{
+        char                    buffer[ZBX_DOCKER_SCAN_SIZE];
+        size_t                  len;
+        int                     lines_num;
+        zbx_docker_scan_line_t  lines[ZBX_DOCKER_SCAN_LINES];
+        uint64_t                found[(ZBX_DOCKER_STAT_COUNT + 63) / 64];
+        uint64_t                values[ZBX_DOCKER_STAT_COUNT];
+}
+zbx_docker_scan_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_stat_id                                               *
+ *                                                                            *
+ * Purpose: resolve known stat-file key                                       *
+ *                                                                            *
+ * Return value: ZBX_DOCKER_STAT_* id or -1 for unknown key                   *
+ *                                                                            *
+ ******************************************************************************/
+static inline int       zbx_docker_stat_id(const char *key, size_t len)
+{
+        uint32_t        hash = ZBX_DOCKER_STAT_HASH_SEED;
+        size_t          i;
+        int             id;
+
+        for (i = 0; i < len; i++)
+        {
+                hash = (hash ^ (unsigned char)key[i]) * 0x01000193U;
+        }
+
+        if (0 > (id = zbx_docker_stat_slots[hash & ZBX_DOCKER_STAT_HASH_MASK]) ||
+                        0 != strncmp(zbx_docker_stat_names[id], key, len) || '\0' != zbx_docker_stat_names[id][len])
+        {
+                return -1;
+        }
+        return id;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_masks_scalar                                     *
+ *                                                                            *
+ * Purpose: bitmaps of '\n' and ' ' positions, one bit per buffer byte        *
+ *                                                                            *
+ ******************************************************************************/
+static inline void      zbx_docker_scan_masks_scalar(const char *buffer, size_t blocks, uint64_t *nl, uint64_t *sp)
+{
+        size_t  b, i;
+
+        for (b = 0; b < blocks; b++)
+        {
+                uint64_t        n = 0, s = 0;
+                const char      *p = buffer + b * 64;
+
+                for (i = 0; i < 64; i++)
+                {
+                        n |= (uint64_t)('\n' == p[i]) << i;
+                        s |= (uint64_t)(' ' == p[i]) << i;
+                }
+                nl[b] = n;
+                sp[b] = s;
+        }
+}
+
+#if defined(ZBX_DOCKER_SCAN_X86)
+static inline void      zbx_docker_scan_masks_sse2(const char *buffer, size_t blocks, uint64_t *nl, uint64_t *sp)
+{
+        const __m128i   vnl = _mm_set1_epi8('\n'), vsp = _mm_set1_epi8(' ');
+        size_t          b;
+        int             i;
+
+        for (b = 0; b < blocks; b++)
+        {
+                uint64_t        n = 0, s = 0;
+
+                for (i = 0; i < 4; i++)
+                {
+                        __m128i v = _mm_loadu_si128((const __m128i *)(buffer + b * 64 + i * 16));
+
+                        n |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vnl)) << (i * 16);
+                        s |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vsp)) << (i * 16);
+                }
+                nl[b] = n;
+                sp[b] = s;
+        }
+}
+
+__attribute__((target("avx2")))
+static void     zbx_docker_scan_masks_avx2(const char *buffer, size_t blocks, uint64_t *nl, uint64_t *sp)
+{
+        const __m256i   vnl = _mm256_set1_epi8('\n'), vsp = _mm256_set1_epi8(' ');
+        size_t          b;
+
+        for (b = 0; b < blocks; b++)
+        {
+                __m256i lo = _mm256_loadu_si256((const __m256i *)(buffer + b * 64));
+                __m256i hi = _mm256_loadu_si256((const __m256i *)(buffer + b * 64 + 32));
+
+                nl[b] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, vnl)) |
+                                (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, vnl)) << 32;
+                sp[b] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, vsp)) |
+                                (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, vsp)) << 32;
+        }
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_masks                                            *
+ *                                                                            *
+ * Purpose: bitmaps of '\n' and ' ' positions by the best instruction set     *
+ *                                                                            *
+ ******************************************************************************/
+static inline void      zbx_docker_scan_masks(const char *buffer, size_t blocks, uint64_t *nl, uint64_t *sp)
+{
+        if (-1 == zbx_docker_scan_isa)
+        {
+#if defined(ZBX_DOCKER_SCAN_X86)
+                __builtin_cpu_init();
+                zbx_docker_scan_isa = __builtin_cpu_supports("avx2") ? ZBX_DOCKER_SCAN_ISA_AVX2 :
+                                ZBX_DOCKER_SCAN_ISA_SSE2;
+#else
+                zbx_docker_scan_isa = ZBX_DOCKER_SCAN_ISA_SCALAR;
+#endif
+        }
+
+        switch (zbx_docker_scan_isa)
+        {
+#if defined(ZBX_DOCKER_SCAN_X86)
+                case ZBX_DOCKER_SCAN_ISA_AVX2:
+                        zbx_docker_scan_masks_avx2(buffer, blocks, nl, sp);
+                        return;
+                case ZBX_DOCKER_SCAN_ISA_SSE2:
+                        zbx_docker_scan_masks_sse2(buffer, blocks, nl, sp);
+                        return;
+#endif
+                default:
+                        zbx_docker_scan_masks_scalar(buffer, blocks, nl, sp);
+        }
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_uint64                                           *
+ *                                                                            *
+ * Purpose: parse unsigned decimal number                                     *
+ *                                                                            *
+ * Return value: 1 - value is parsed, 0 - there is no number                  *
+ *                                                                            *
+ ******************************************************************************/
+static inline int       zbx_docker_scan_uint64(const char *s, size_t len, uint64_t *value)
+{
+        uint64_t        v = 0;
+        size_t          i;
+
+        for (i = 0; i < len && ' ' == s[i]; i++)
+                ;
+        if (i == len || s[i] < '0' || s[i] > '9')
+                return 0;
+        for (; i < len && s[i] >= '0' && s[i] <= '9'; i++)
+                v = v * 10 + (uint64_t)(s[i] - '0');
+        *value = v;
+        return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_buffer                                           *
+ *                                                                            *
+ * Purpose: split scan->buffer to "<key> <value>" lines and store values of   *
+ *          known keys                                                        *
+ *                                                                            *
+ * Return value: number of lines, -1 - more than ZBX_DOCKER_SCAN_LINES lines  *
+ *               (errno is EFBIG), partial data is not returned               *
+ *                                                                            *
+ ******************************************************************************/
+static inline int       zbx_docker_scan_buffer(zbx_docker_scan_t *scan)
+{
+        uint64_t        nl[ZBX_DOCKER_SCAN_SIZE / 64], sp[ZBX_DOCKER_SCAN_SIZE / 64];
+        size_t          blocks = (scan->len + 63) / 64, b, start = 0, key_end = (size_t)-1, pos;
+
+        // bytes behind the end of file are scanned too, they must not be delimiters
+        memset(scan->buffer + scan->len, 0, blocks * 64 - scan->len);
+        memset(scan->found, 0, sizeof(scan->found));
+        scan->lines_num = 0;
+        zbx_docker_scan_masks(scan->buffer, blocks, nl, sp);
+
+        for (b = 0; b <= blocks; b++)
+        {
+                uint64_t        bits = b < blocks ? nl[b] | sp[b] : 0;
+
+                while (0 != bits || b == blocks)
+                {
+                        zbx_docker_scan_line_t  *line;
+                        int                     id;
+
+                        if (b == blocks)
+                        {
+                                // last line without '\n'
+                                if (start >= scan->len)
+                                        break;
+                                pos = scan->len;
+                        }
+                        else
+                        {
+                                pos = b * 64 + __builtin_ctzll(bits);
+                                bits &= bits - 1;
+                                if (0 == (nl[b] >> (pos % 64) & 1))
+                                {
+                                        if ((size_t)-1 == key_end)
+                                                key_end = pos;
+                                        continue;
+                                }
+                        }
+
+                        if (pos > start && ZBX_DOCKER_SCAN_LINES == scan->lines_num)
+                        {
+                                errno = EFBIG;
+                                return -1;
+                        }
+                        if (pos > start)
+                        {
+                                line = &scan->lines[scan->lines_num++];
+                                line->key = scan->buffer + start;
+                                if ((size_t)-1 == key_end)
+                                {
+                                        line->key_len = pos - start;
+                                        line->value = scan->buffer + pos;
+                                        line->value_len = 0;
+                                }
+                                else
+                                {
+                                        line->key_len = key_end - start;
+                                        line->value = scan->buffer + key_end + 1;
+                                        line->value_len = pos - key_end - 1;
+                                }
+
+                                if (0 <= (id = zbx_docker_stat_id(line->key, line->key_len)) &&
+                                                1 == zbx_docker_scan_uint64(line->value, line->value_len,
+                                                &scan->values[id]))
+                                {
+                                        scan->found[id / 64] |= (uint64_t)1 << (id % 64);
+                                }
+                        }
+                        start = pos + 1;
+                        key_end = (size_t)-1;
+                        if (b == blocks)
+                                break;
+                }
+        }
+        return scan->lines_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_file                                             *
+ *                                                                            *
+ * Purpose: read stat file by single read() and scan it                       *
+ *                                                                            *
+ * Return value: number of lines, -1 - file cannot be read (errno is set)     *
+ *                                                                            *
+ * Notes: pseudo-files bigger than ZBX_DOCKER_SCAN_SIZE - 1 bytes (e.g.       *
+ *        io.stat of many devices) fail with EFBIG instead of being truncated *
+ *                                                                            *
+ ******************************************************************************/
+static inline int       zbx_docker_scan_file(zbx_docker_scan_t *scan, const char *path)
+{
+        int             fd;
+        ssize_t         n;
+        char            c;
+
+        if (-1 == (fd = open(path, O_RDONLY | O_CLOEXEC)))
+                return -1;
+        n = read(fd, scan->buffer, ZBX_DOCKER_SCAN_SIZE - 1);
+        // full buffer, the file is complete only if nothing follows
+        if (ZBX_DOCKER_SCAN_SIZE - 1 == n && 0 != read(fd, &c, 1))
+        {
+                close(fd);
+                errno = EFBIG;
+                return -1;
+        }
+        close(fd);
+        if (0 > n)
+                return -1;
+
+        scan->len = (size_t)n;
+        return zbx_docker_scan_buffer(scan);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_fd                                               *
+ *                                                                            *
+ * Purpose: read and scan the whole file from already open descriptor         *
+ *                                                                            *
+ * Return value: number of lines, -1 - file cannot be read                    *
+ *                                                                            *
+ * Notes: reading by the same descriptor acknowledges kernfs change           *
+ *        notification, so it can be polled again (e.g. memory.events)        *
+ ******************************************************************************/
+static inline int       zbx_docker_scan_fd(zbx_docker_scan_t *scan, int fd)
+{
+        ssize_t         n;
+        char            c;
+
+        if (0 > (n = pread(fd, scan->buffer, ZBX_DOCKER_SCAN_SIZE - 1, 0)))
+                return -1;
+        if (ZBX_DOCKER_SCAN_SIZE - 1 == n && 0 != pread(fd, &c, 1, n))
+        {
+                errno = EFBIG;
+                return -1;
+        }
+
+        scan->len = (size_t)n;
+        return zbx_docker_scan_buffer(scan);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_value                                            *
+ *                                                                            *
+ * Purpose: get value of the key from scanned file                            *
+ *                                                                            *
+ * Return value: 1 - key was found, 0 - key was not found                     *
+ *                                                                            *
+ * Notes: known keys are resolved by the hash, unknown keys (e.g. new kernel  *
+ *        counters) by comparison with all lines                              *
+ ******************************************************************************/
+static inline int       zbx_docker_scan_value(const zbx_docker_scan_t *scan, const char *key, uint64_t *value)
+{
+        size_t  len = strlen(key);
+        int     id, i;
+
+        if (0 <= (id = zbx_docker_stat_id(key, len)))
+        {
+                if (0 == (scan->found[id / 64] >> (id % 64) & 1))
+                        return 0;
+                *value = scan->values[id];
+                return 1;
+        }
+
+        for (i = 0; i < scan->lines_num; i++)
+        {
+                const zbx_docker_scan_line_t    *line = &scan->lines[i];
+
+                if (line->key_len == len && 0 == memcmp(line->key, key, len))
+                        return zbx_docker_scan_uint64(line->value, line->value_len, value);
+        }
+        return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_has                                              *
+ *                                                                            *
+ * Purpose: check if known key was found in scanned file                      *
+ *                                                                            *
+ ******************************************************************************/
+static inline int       zbx_docker_scan_has(const zbx_docker_scan_t *scan, int id)
+{
+        return (int)(scan->found[id / 64] >> (id % 64) & 1);
+}
+
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_get                                              *
+ *                                                                            *
+ * Purpose: get value of known key from scanned file, 0 if it was not found   *
+ *                                                                            *
+ ******************************************************************************/
+static inline uint64_t  zbx_docker_scan_get(const zbx_docker_scan_t *scan, int id)
+{
+        return 1 == zbx_docker_scan_has(scan, id) ? scan->values[id] : 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_docker_scan_field                                            *
+ *                                                                            *
+ * Purpose: get value of "<field>=<value>" or "<field> <value>" token of the  *
+ *          line value, e.g. io.stat "8:0 rbytes=1 wbytes=2" or blkio         *
+ *          "8:0 Read 1"                                                      *
+ *                                                                            *
+ * Return value: 1 - field was found, 0 - field was not found                 *
+ *                                                                            *
+ ******************************************************************************/
+static inline int       zbx_docker_scan_field(const zbx_docker_scan_line_t *line, const char *field, uint64_t *value)
+{
+        size_t          len = strlen(field), i;
+        const char      *s = line->value;
+
+        for (i = 0; i + len < line->value_len; i++)
+        {
+                if ((0 == i || ' ' == s[i - 1]) && 0 == memcmp(s + i, field, len) &&
+                                ('=' == s[i + len] || ' ' == s[i + len]))
+                {
+                        return zbx_docker_scan_uint64(s + i + len + 1, line->value_len - i - len - 1, value);
+                }
+        }
+        return 0;
+}
+
+#endif
@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+"""
+Synthetic cgroup filesystem fixtures for zabbix_module_docker.
+
+It builds a realistic cgroup tree for many containers under a temp root, with
+a fake <root>/proc/mounts, so the module can be loaded with
+ZBX_DOCKER_ROOTFS=<root> and docker.mem/cpu/dev/up and basic docker.discovery
+can be measured without real containers.
+
+Layouts:
+
+    v1-cgroupfs     cgroup v1, <controller>/docker/<fci>/
+    v1-systemd      cgroup v1, <controller>/system.slice/docker-<fci>.scope/
+    v1-lxc          cgroup v1, <controller>/lxc/<fci>/
+    v1-libvirt-lxc  cgroup v1, <controller>/libvirt/lxc/<fci>/
+    v2-cgroupfs     cgroup v2, docker/<fci>/
+    v2-systemd      cgroup v2, system.slice/docker-<fci>.scope/
+
+Container IDs are the same as IDs of tools/docker_mock.py population with the
+same --seed. Counter values grow with time, so rerun with --update to
+refresh counters of an existing tree (e.g. before each poll of rate items).
+
+Usage:
+
+    ./tools/cgroup_fixtures.py --root /tmp/cgroup-v2 --layout v2-systemd --containers 5000
+    ZBX_DOCKER_ROOTFS=/tmp/cgroup-v2 zabbix_agentd -c zabbix_agentd.conf
+"""
+
+import argparse
+import os
+import random
+import shutil
+import sys
+import time
+
+from docker_mock import container_id
+
+LAYOUTS = {
+    "v1-cgroupfs": (1, "docker", "{}"),
+    "v1-systemd": (1, "system.slice", "docker-{}.scope"),
+    "v1-lxc": (1, "lxc", "{}"),
+    "v1-libvirt-lxc": (1, "libvirt/lxc", "{}"),
+    "v2-cgroupfs": (2, "docker", "{}"),
+    "v2-systemd": (2, "system.slice", "docker-{}.scope"),
+}
+
+V1_CONTROLLERS = ["cpuset", "cpu,cpuacct", "memory", "blkio", "devices", "pids", "freezer", "net_cls,net_prio"]
+V1_LINKS = {"cpu": "cpu,cpuacct", "cpuacct": "cpu,cpuacct", "net_cls": "net_cls,net_prio", "net_prio": "net_cls,net_prio"}
+# epoch of synthetic counters, counters are rate * (now - EPOCH)
+EPOCH = 1600000000
+PAGE = 4096
+NCPU = 8
+DEVICES = [(8, 0, "sda"), (8, 16, "sdb"), (259, 0, "nvme0n1")]
+
+
+def write(path, content):
+    with open(path, "w") as f:
+        f.write(content)
+
+
+def kv(pairs):
+    return "".join("%s %d\n" % (k, v) for k, v in pairs)
+
+
+class Container:
+    """Deterministic per-container rates, counters are computed at time t."""
+
+    def __init__(self, seed, index, t):
+        rnd = random.Random("%s-%d" % (seed, index))
+        self.index = index
+        self.fci = container_id(seed, index)
+        self.pid = 10000 + index
+        self.t = t
+        self.cpu_rate = rnd.uniform(0.01, 2.0)          # CPUs used
+        self.sys_ratio = rnd.uniform(0.1, 0.4)
+        self.anon = rnd.randint(4, 2048) * 1024 * 1024
+        self.file = rnd.randint(1, 1024) * 1024 * 1024
+        self.io_rate = rnd.randint(0, 4 * 1024 * 1024)  # bytes per second
+        self.limit = rnd.choice([0, 256, 512, 1024, 4096]) * 1024 * 1024
+        self.quota = rnd.choice([-1, -1, 50000, 100000, 200000])
+        self.cpuset = rnd.choice(["0-%d" % (NCPU - 1), "0-1", "2-3", "0"])
+        self.throttle = rnd.uniform(0, 0.3) if self.quota > 0 else 0
+        self.tasks = [self.pid + 100000 * i for i in range(rnd.randint(1, 4))]
+
+    def elapsed(self):
+        return max(1.0, self.t - EPOCH)
+
+    def cpu_ns(self):
+        return int(self.cpu_rate * self.elapsed() * 1e9)
+
+    def user_ns(self):
+        return int(self.cpu_ns() * (1 - self.sys_ratio))
+
+    def system_ns(self):
+        return self.cpu_ns() - self.user_ns()
+
+    def periods(self):
+        return int(self.elapsed() * 10) if self.quota > 0 else 0
+
+    def io(self):
+        """(device, read bytes, write bytes, read ios, write ios)"""
+        total = int(self.io_rate * self.elapsed())
+        result = []
+        for n, (major, minor, name) in enumerate(DEVICES[:1 + self.index % len(DEVICES)]):
+            share = total >> n
+            result.append((major, minor, share * 2 // 3, share // 3, share // 6144, share // 12288))
+        return result
+
+    def faults(self):
+        return int(self.elapsed() * 50), int(self.elapsed() / 10)
+
+    # cgroup v1 files
+    def v1_memory_stat(self):
+        pgfault, pgmajfault = self.faults()
+        local = [
+            ("cache", self.file), ("rss", self.anon), ("rss_huge", 0), ("shmem", 0),
+            ("mapped_file", self.file // 4), ("dirty", PAGE * 3), ("writeback", 0), ("swap", 0),
+            ("pgpgin", pgfault * 2), ("pgpgout", pgfault), ("pgfault", pgfault), ("pgmajfault", pgmajfault),
+            ("inactive_anon", self.anon // 4), ("active_anon", self.anon - self.anon // 4),
+            ("inactive_file", self.file // 2), ("active_file", self.file - self.file // 2), ("unevictable", 0),
+        ]
+        limit = self.limit or 9223372036854771712
+        return kv(local + [("hierarchical_memory_limit", limit), ("hierarchical_memsw_limit", 9223372036854771712)]
+                  + [("total_" + k, v) for k, v in local])
+
+    def v1_files(self, controller):
+        tasks = "".join("%d\n" % t for t in self.tasks)
+        if controller == "cpuset":
+            return {
+                "cpuset.cpus": self.cpuset + "\n",
+                "cpuset.mems": "0\n",
+                "tasks": tasks,
+                "cgroup.procs": "%d\n" % self.pid,
+            }
+        if controller == "cpu,cpuacct":
+            hz = 100
+            percpu = [self.cpu_ns() // NCPU] * NCPU
+            return {
+                "cpuacct.stat": "user %d\nsystem %d\n" % (self.user_ns() * hz // 10 ** 9, self.system_ns() * hz // 10 ** 9),
+                "cpuacct.usage": "%d\n" % self.cpu_ns(),
+                "cpuacct.usage_percpu": " ".join(str(v) for v in percpu) + " \n",
+                "cpuacct.usage_user": "%d\n" % self.user_ns(),
+                "cpuacct.usage_sys": "%d\n" % self.system_ns(),
+                "cpu.stat": kv([("nr_periods", self.periods()), ("nr_throttled", int(self.periods() * self.throttle)),
+                                ("throttled_time", int(self.periods() * self.throttle * 5e6))]),
+                "cpu.cfs_quota_us": "%d\n" % self.quota,
+                "cpu.cfs_period_us": "100000\n",
+                "cpu.shares": "1024\n",
+                "tasks": tasks,
+                "cgroup.procs": "%d\n" % self.pid,
+            }
+        if controller == "memory":
+            usage = self.anon + self.file
+            return {
+                "memory.stat": self.v1_memory_stat(),
+                "memory.usage_in_bytes": "%d\n" % usage,
+                "memory.max_usage_in_bytes": "%d\n" % (usage + 1024 * 1024),
+                "memory.limit_in_bytes": "%d\n" % (self.limit or 9223372036854771712),
+                "memory.failcnt": "0\n",
+                "memory.oom_control": "oom_kill_disable 0\nunder_oom 0\noom_kill 0\n",
+                "memory.numa_stat": "total=%d N0=%d\nfile=%d N0=%d\nanon=%d N0=%d\nunevictable=0 N0=0\n" % (
+                    usage // PAGE, usage // PAGE, self.file // PAGE, self.file // PAGE, self.anon // PAGE, self.anon // PAGE),
+                "tasks": tasks,
+                "cgroup.procs": "%d\n" % self.pid,
+            }
+        if controller == "blkio":
+            def per_device(values):
+                lines, total = [], 0
+                for (major, minor, r, w) in values:
+                    for op, v in (("Read", r), ("Write", w), ("Sync", r + w), ("Async", 0), ("Discard", 0), ("Total", r + w)):
+                        lines.append("%d:%d %s %d\n" % (major, minor, op, v))
+                    total += r + w
+                return "".join(lines) + "Total %d\n" % total
+            io = self.io()
+            byte_values = [(a, b, r, w) for (a, b, r, w, _, _) in io]
+            ios_values = [(a, b, ri, wi) for (a, b, _, _, ri, wi) in io]
+            time_values = [(a, b, ri * 150000, wi * 400000) for (a, b, _, _, ri, wi) in io]
+            wait_values = [(a, b, ri * 50000, wi * 200000) for (a, b, _, _, ri, wi) in io]
+            files = {
+                "blkio.throttle.io_service_bytes": per_device(byte_values),
+                "blkio.throttle.io_serviced": per_device(ios_values),
+                "blkio.io_service_bytes": per_device(byte_values),
+                "blkio.io_serviced": per_device(ios_values),
+                "blkio.io_service_time": per_device(time_values),
+                "blkio.io_wait_time": per_device(wait_values),
+                "blkio.io_queued": per_device([(a, b, 0, 0) for (a, b, _, _) in byte_values]),
+                "blkio.sectors": "".join("%d:%d %d\n" % (a, b, (r + w) // 512) for (a, b, r, w) in byte_values),
+                "tasks": tasks,
+            }
+            # CFQ/BFQ kernels expose the hierarchical counterparts as well
+            for name in ("io_service_bytes", "io_serviced", "io_service_time", "io_wait_time", "io_queued", "sectors"):
+                files["blkio.%s_recursive" % name] = files["blkio." + name]
+            return files
+        if controller == "pids":
+            return {"pids.current": "%d\n" % len(self.tasks), "pids.max": "max\n", "tasks": tasks}
+        return {"tasks": tasks, "cgroup.procs": "%d\n" % self.pid}
+
+    # cgroup v2 files
+    def v2_files(self):
+        pgfault, pgmajfault = self.faults()
+        usage = self.anon + self.file
+        memory_stat = kv([
+            ("anon", self.anon), ("file", self.file), ("kernel", 2 * 1024 * 1024), ("kernel_stack", 65536),
+            ("pagetables", 262144), ("sec_pagetables", 0), ("percpu", 8192), ("sock", 0), ("vmalloc", 0),
+            ("shmem", 0), ("zswap", 0), ("zswapped", 0), ("file_mapped", self.file // 4), ("file_dirty", PAGE * 3),
+            ("file_writeback", 0), ("swapcached", 0), ("anon_thp", 0), ("file_thp", 0), ("shmem_thp", 0),
+            ("inactive_anon", self.anon // 4), ("active_anon", self.anon - self.anon // 4),
+            ("inactive_file", self.file // 2), ("active_file", self.file - self.file // 2), ("unevictable", 0),
+            ("slab_reclaimable", 524288), ("slab_unreclaimable", 262144), ("slab", 786432),
+            ("workingset_refault_anon", 0), ("workingset_refault_file", pgmajfault), ("workingset_activate_anon", 0),
+            ("workingset_activate_file", 0), ("workingset_restore_anon", 0), ("workingset_restore_file", 0),
+            ("workingset_nodereclaim", 0), ("pgscan", 0), ("pgsteal", 0), ("pgscan_kswapd", 0), ("pgscan_direct", 0),
+            ("pgsteal_kswapd", 0), ("pgsteal_direct", 0), ("pgfault", pgfault), ("pgmajfault", pgmajfault),
+            ("pgrefill", 0), ("pgactivate", pgfault // 10), ("pgdeactivate", 0), ("pglazyfree", 0),
+            ("pglazyfreed", 0), ("thp_fault_alloc", 0), ("thp_collapse_alloc", 0),
+        ])
+        usec = self.cpu_ns() // 1000
+        user = self.user_ns() // 1000
+        throttled = int(self.periods() * self.throttle)
+        cpus = self.cpuset
+        io_stat = "".join("%d:%d rbytes=%d wbytes=%d rios=%d wios=%d dbytes=0 dios=0\n" % io for io in self.io())
+        pressure = "some avg10=%.2f avg60=%.2f avg300=%.2f total=%d\nfull avg10=%.2f avg60=%.2f avg300=%.2f total=%d\n"
+        cpu_some = self.throttle * 100
+        return {
+            "cgroup.controllers": "cpuset cpu io memory hugetlb pids rdma misc\n",
+            "cgroup.procs": "%d\n" % self.pid,
+            "cgroup.threads": "".join("%d\n" % t for t in self.tasks),
+            "cgroup.events": "populated 1\nfrozen 0\n",
+            "cpu.stat": kv([("usage_usec", usec), ("user_usec", user), ("system_usec", usec - user),
+                            ("core_sched.force_idle_usec", 0), ("nr_periods", self.periods()),
+                            ("nr_throttled", throttled), ("throttled_usec", int(throttled * 5000)),
+                            ("nr_bursts", 0), ("burst_usec", 0)]),
+            "cpu.max": ("max" if self.quota < 0 else str(self.quota)) + " 100000\n",
+            "cpu.weight": "100\n",
+            "cpuset.cpus": cpus + "\n",
+            "cpuset.cpus.effective": cpus + "\n",
+            "cpuset.mems.effective": "0\n",
+            "memory.stat": memory_stat,
+            "memory.current": "%d\n" % usage,
+            "memory.peak": "%d\n" % (usage + 1024 * 1024),
+            "memory.max": ("%d\n" % self.limit) if self.limit else "max\n",
+            "memory.high": "max\n",
+            "memory.swap.current": "0\n",
+            "memory.events": "low 0\nhigh 0\nmax 0\noom 0\noom_kill 0\noom_group_kill 0\n",
+            "memory.numa_stat": "anon N0=%d\nfile N0=%d\nkernel_stack N0=65536\nshmem N0=0\nfile_mapped N0=%d\n" % (
+                self.anon, self.file, self.file // 4),
+            "io.stat": io_stat,
+            "pids.current": "%d\n" % len(self.tasks),
+            "pids.max": "max\n",
+            "cpu.pressure": pressure % (cpu_some, cpu_some, cpu_some, usec // 50, 0, 0, 0, 0),
+            "memory.pressure": pressure % (0, 0, 0, 0, 0, 0, 0, 0),
+            "io.pressure": pressure % (0.5, 0.3, 0.2, usec // 200, 0.1, 0.1, 0.1, usec // 1000),
+        }
+
+
+def mounts(root, version):
+    cgroup = os.path.join(root, "sys/fs/cgroup")
+    lines = ["sysfs /sys sysfs rw,nosuid,nodev,noexec,relatime 0 0",
+             "proc /proc proc rw,nosuid,nodev,noexec,relatime 0 0",
+             "/dev/sda1 / ext4 rw,relatime 0 0"]
+    if version == 2:
+        lines.append("cgroup2 /sys/fs/cgroup cgroup2 rw,nosuid,nodev,noexec,relatime,nsdelegate,memory_recursiveprot 0 0")
+    else:
+        lines.append("tmpfs /sys/fs/cgroup tmpfs ro,nosuid,nodev,noexec,mode=755 0 0")
+        lines.append("cgroup2 /sys/fs/cgroup/unified cgroup2 rw,nosuid,nodev,noexec,relatime,nsdelegate 0 0")
+        for controller in V1_CONTROLLERS:
+            lines.append("cgroup /sys/fs/cgroup/%s cgroup rw,nosuid,nodev,noexec,relatime,%s 0 0" % (controller, controller))
+    os.makedirs(os.path.join(root, "proc"), exist_ok=True)
+    write(os.path.join(root, "proc/mounts"), "\n".join(lines) + "\n")
+    os.makedirs(cgroup, exist_ok=True)
+    if version == 1:
+        for controller in V1_CONTROLLERS:
+            os.makedirs(os.path.join(cgroup, controller), exist_ok=True)
+        os.makedirs(os.path.join(cgroup, "unified"), exist_ok=True)
+        for link, target in V1_LINKS.items():
+            if not os.path.lexists(os.path.join(cgroup, link)):
+                os.symlink(target, os.path.join(cgroup, link))
+    return cgroup
+
+
+def generate(opts):
+    version, driver, dirname = LAYOUTS[opts.layout]
+    if not opts.update and os.path.exists(opts.root):
+        if not os.path.exists(os.path.join(opts.root, "proc/mounts")):
+            sys.exit("%s exists and it isn't a fixture root, refusing to overwrite it" % opts.root)
+        shutil.rmtree(opts.root)
+    cgroup = mounts(opts.root, version)
+    t = opts.time or time.time()
+
+    if version == 2:
+        # systemd creates other units in system.slice too, discovery must skip them
+        for other in ("system.slice/ssh.service", "system.slice/containerd.service", "user.slice"):
+            os.makedirs(os.path.join(cgroup, other), exist_ok=True)
+            write(os.path.join(cgroup, other, "cgroup.procs"), "1\n")
+
+    for i in range(opts.containers):
+        c = Container(opts.seed, i, t)
+        name = dirname.format(c.fci)
+        if version == 2:
+            groups = {"": c.v2_files()}
+        else:
+            groups = {controller: c.v1_files(controller) for controller in V1_CONTROLLERS}
+        for controller, files in groups.items():
+            path = os.path.join(cgroup, controller, driver, name)
+            os.makedirs(path, exist_ok=True)
+            for filename, content in files.items():
+                write(os.path.join(path, filename), content)
+    return opts.containers
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Synthetic cgroup fixtures for zabbix_module_docker")
+    parser.add_argument("--root", required=True, help="fixture root, use it as ZBX_DOCKER_ROOTFS")
+    parser.add_argument("--layout", choices=sorted(LAYOUTS), default="v1-cgroupfs", help="cgroup layout (default %(default)s)")
+    parser.add_argument("--containers", type=int, default=100, help="number of containers (default %(default)s)")
+    parser.add_argument("--seed", default="zabbix", help="population seed, same as docker_mock.py (default %(default)s)")
+    parser.add_argument("--time", type=float, default=0, help="timestamp of counter values (default now)")
+    parser.add_argument("--update", action="store_true", help="rewrite files of existing fixture root")
+    opts = parser.parse_args()
+    started = time.time()
+    count = generate(opts)
+    print("%s: %d containers (%s) in %.1fs" % (opts.root, count, opts.layout, time.time() - started), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,544 @@
+#!/usr/bin/env python3
+"""
+Mock Docker daemon for offline testing of zabbix_module_docker.
+
+It serves the subset of Docker Engine API used by the module on a unix socket:
+
+    GET /_ping
+    GET /info
+    GET /containers/json?all=0|1
+    GET /containers/<id|name>/json
+    GET /containers/<id|name>/stats[?stream=0]
+    GET /events
+    GET /images/json[?filters={"dangling":["true"]}]
+    GET /volumes[?filters={"dangling":["true"]}]
+
+Container population is generated from --seed, so container IDs are stable
+between runs and match cgroup trees generated by cgroup_fixtures.py with the
+same --seed/--containers values.
+
+Failure injection:
+
+    --latency/--jitter       delay before the response is sent
+    --endpoint-latency       per endpoint delay, e.g. --endpoint-latency info=800
+    --dribble/--dribble-delay  send response in small chunks with delay
+    --disconnect-rate        probability of a connection drop in the middle
+                             of the response (or before any byte is sent)
+
+Usage:
+
+    ./tools/docker_mock.py --socket /tmp/docker-mock.sock --containers 1000
+    DOCKER_HOST=unix:///tmp/docker-mock.sock zabbix_agentd -c zabbix_agentd.conf
+    zabbix_get -s 127.0.0.1 -k docker.cstatus[All]
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import random
+import signal
+import socketserver
+import sys
+import threading
+import time
+import urllib.parse
+
+API_VERSION = "1.41"
+NCPU = 8
+MEM_TOTAL = 64 * 1024 * 1024 * 1024
+
+
+def container_id(seed, index):
+    """Full 64 character container ID of container <index>."""
+    return hashlib.sha256(("%s-container-%d" % (seed, index)).encode()).hexdigest()
+
+
+def container_name(index):
+    return "mock-%05d" % index
+
+
+class Population:
+    """Deterministic set of containers, images and volumes."""
+
+    def __init__(self, args):
+        rnd = random.Random(args.seed)
+        self.started = time.time()
+        self.containers = []
+        self.by_key = {}
+        for i in range(args.containers):
+            roll = rnd.random()
+            if roll < args.running:
+                state = "running"
+            elif roll < args.running + args.paused:
+                state = "paused"
+            elif roll < args.running + args.paused + args.crashed:
+                state = "crashed"
+            else:
+                state = "exited"
+            c = {
+                "index": i,
+                "id": container_id(args.seed, i),
+                "name": container_name(i),
+                "image": "mock/image-%d:latest" % (i % max(1, args.images)),
+                "state": state,
+                "pid": 10000 + i if state in ("running", "paused") else 0,
+                "exit_code": rnd.randint(1, 255) if state == "crashed" else 0,
+                "created": int(self.started) - rnd.randint(3600, 30 * 86400),
+                "cpu_rate": rnd.uniform(0.01, 2.0),
+                "mem_base": rnd.randint(16, 2048) * 1024 * 1024,
+                "ports": rnd.random() < 0.3,
+            }
+            self.containers.append(c)
+            self.by_key[c["id"]] = c
+            self.by_key[c["name"]] = c
+        self.images = ["sha256:" + hashlib.sha256(("%s-image-%d" % (args.seed, i)).encode()).hexdigest()
+                       for i in range(args.images)]
+        self.dangling_images = max(0, args.images // 10)
+        self.volumes = ["mock-volume-%04d" % i for i in range(args.volumes)]
+        self.dangling_volumes = max(0, args.volumes // 5)
+
+    def find(self, key):
+        c = self.by_key.get(key)
+        if c is not None:
+            return c
+        # short ID prefix lookup like dockerd does
+        if len(key) >= 4:
+            for c in self.containers:
+                if c["id"].startswith(key):
+                    return c
+        return None
+
+    def running(self, c):
+        return c["state"] in ("running", "paused")
+
+    def status_text(self, c):
+        if c["state"] == "running":
+            return "Up 2 hours"
+        if c["state"] == "paused":
+            return "Up 2 hours (Paused)"
+        return "Exited (%d) 5 minutes ago" % c["exit_code"]
+
+    def summary(self, c):
+        ports = []
+        if c["ports"]:
+            ports.append({"IP": "0.0.0.0", "PrivatePort": 80, "PublicPort": 8000 + c["index"] % 1000, "Type": "tcp"})
+        return {
+            "Id": c["id"],
+            "Names": ["/" + c["name"]],
+            "Image": c["image"],
+            "ImageID": self.images[c["index"] % len(self.images)] if self.images else "",
+            "Command": "/bin/sh -c 'sleep infinity'",
+            "Created": c["created"],
+            "Ports": ports,
+            "Labels": {"com.example.mock": "1", "index": str(c["index"])},
+            "State": "exited" if c["state"] == "crashed" else c["state"],
+            "Status": self.status_text(c),
+            "HostConfig": {"NetworkMode": "default"},
+        }
+
+    def inspect(self, c):
+        running = self.running(c)
+        port_bindings = {}
+        if c["ports"]:
+            port_bindings["80/tcp"] = [{"HostIp": "", "HostPort": str(8000 + c["index"] % 1000)}]
+        ip = "172.17.%d.%d" % ((c["index"] // 250) % 256, c["index"] % 250 + 2)
+        return {
+            "Id": c["id"],
+            "Created": time.strftime("%Y-%m-%dT%H:%M:%S.000000000Z", time.gmtime(c["created"])),
+            "Path": "/bin/sh",
+            "Args": ["-c", "sleep infinity"],
+            "State": {
+                "Status": "exited" if c["state"] == "crashed" else c["state"],
+                "Running": running,
+                "Paused": c["state"] == "paused",
+                "Restarting": False,
+                "OOMKilled": False,
+                "Dead": False,
+                "Pid": c["pid"],
+                "ExitCode": c["exit_code"],
+                "Error": "",
+                "StartedAt": time.strftime("%Y-%m-%dT%H:%M:%S.000000000Z", time.gmtime(self.started)),
+                "FinishedAt": "0001-01-01T00:00:00Z",
+            },
+            "Image": self.images[c["index"] % len(self.images)] if self.images else "",
+            "Name": "/" + c["name"],
+            "RestartCount": 0,
+            "Driver": "overlay2",
+            "HostConfig": {
+                "PortBindings": port_bindings,
+                "Memory": 0,
+                "NanoCpus": 0,
+                "CpuQuota": 0,
+                "CpuPeriod": 0,
+                "CpusetCpus": "",
+                "RestartPolicy": {"Name": "no", "MaximumRetryCount": 0},
+            },
+            "Mounts": [],
+            "Config": {
+                "Hostname": c["id"][:12],
+                "Env": ["PATH=/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin",
+                        "MESOS_TASK_ID=mock-task-%05d" % c["index"],
+                        "ENV=mock"],
+                "Cmd": ["sleep", "infinity"],
+                "Image": c["image"],
+                "Labels": {"com.example.mock": "1", "index": str(c["index"])},
+            },
+            "NetworkSettings": {
+                "IPAddress": ip if running else "",
+                "MacAddress": "02:42:ac:11:00:02",
+                "Networks": {
+                    "bridge": {
+                        "IPAddress": ip if running else "",
+                        "Gateway": "172.17.0.1",
+                        "IPPrefixLen": 16,
+                        "MacAddress": "02:42:ac:11:00:02",
+                    }
+                },
+            },
+        }
+
+    def stats(self, c, now, delta):
+        """Stats document - counters grow with wall clock time.
+
+        precpu_stats is the sample delta seconds before, dockerd leaves it empty
+        (delta None) in the first frame of a stream and primes it for stream=0.
+        """
+        uptime = now - self.started + 3600
+        total = int(c["cpu_rate"] * uptime * 1e9)
+        percpu = [total // NCPU] * NCPU
+        system = int(uptime * NCPU * 1e9) + 10 ** 15
+        mem_usage = c["mem_base"] + int((uptime * 4096) % (64 * 1024 * 1024))
+        cache = mem_usage // 4
+        io = int(uptime * 1024 * (c["index"] % 7 + 1))
+
+        def cpu(delta):
+            if delta is None:
+                return {"cpu_usage": {"total_usage": 0, "usage_in_kernelmode": 0, "usage_in_usermode": 0},
+                        "throttling_data": {"periods": 0, "throttled_periods": 0, "throttled_time": 0}}
+            return {
+                "cpu_usage": {
+                    "total_usage": max(0, total - int(delta * c["cpu_rate"] * 1e9)),
+                    "percpu_usage": [max(0, p - int(delta * c["cpu_rate"] * 1e9 / NCPU)) for p in percpu],
+                    "usage_in_kernelmode": total // 3,
+                    "usage_in_usermode": total - total // 3,
+                },
+                "system_cpu_usage": system - int(delta * NCPU * 1e9),
+                "online_cpus": NCPU,
+                "throttling_data": {"periods": int(uptime * 10), "throttled_periods": int(uptime) // 7,
+                                    "throttled_time": int(uptime * 1e6)},
+            }
+
+        return {
+            "read": time.strftime("%Y-%m-%dT%H:%M:%S.000000000Z", time.gmtime(now)),
+            "preread": "0001-01-01T00:00:00Z" if delta is None else
+                       time.strftime("%Y-%m-%dT%H:%M:%S.000000000Z", time.gmtime(now - delta)),
+            "id": c["id"],
+            "name": "/" + c["name"],
+            "pids_stats": {"current": 1 + c["index"] % 20},
+            "blkio_stats": {
+                "io_service_bytes_recursive": [
+                    {"major": 8, "minor": 0, "op": "Read", "value": io},
+                    {"major": 8, "minor": 0, "op": "Write", "value": io // 2},
+                    {"major": 8, "minor": 0, "op": "Sync", "value": io},
+                    {"major": 8, "minor": 0, "op": "Async", "value": io // 2},
+                    {"major": 8, "minor": 0, "op": "Total", "value": io + io // 2},
+                ],
+                "io_serviced_recursive": [
+                    {"major": 8, "minor": 0, "op": "Read", "value": io // 4096},
+                    {"major": 8, "minor": 0, "op": "Write", "value": io // 8192},
+                    {"major": 8, "minor": 0, "op": "Total", "value": io // 4096 + io // 8192},
+                ],
+            },
+            "cpu_stats": cpu(0),
+            "precpu_stats": cpu(delta),
+            "memory_stats": {
+                "usage": mem_usage,
+                "max_usage": mem_usage + 1024 * 1024,
+                "limit": MEM_TOTAL,
+                "stats": {
+                    "cache": cache,
+                    "rss": mem_usage - cache,
+                    "mapped_file": cache // 8,
+                    "inactive_file": cache // 2,
+                    "active_file": cache - cache // 2,
+                    "pgfault": int(uptime * 100),
+                    "pgmajfault": int(uptime),
+                    "total_cache": cache,
+                    "total_rss": mem_usage - cache,
+                    "total_inactive_file": cache // 2,
+                },
+            },
+            "networks": {
+                "eth0": {
+                    "rx_bytes": int(uptime * 2048), "rx_packets": int(uptime * 20), "rx_errors": 0, "rx_dropped": 0,
+                    "tx_bytes": int(uptime * 1024), "tx_packets": int(uptime * 10), "tx_errors": 0, "tx_dropped": 0,
+                }
+            },
+        }
+
+    def info(self):
+        running = sum(1 for c in self.containers if c["state"] == "running")
+        paused = sum(1 for c in self.containers if c["state"] == "paused")
+        return {
+            "ID": "MOCK:DAEMON:0000",
+            "Containers": len(self.containers),
+            "ContainersRunning": running,
+            "ContainersPaused": paused,
+            "ContainersStopped": len(self.containers) - running - paused,
+            "Images": len(self.images),
+            "Driver": "overlay2",
+            "DriverStatus": [["Backing Filesystem", "extfs"], ["Supports d_type", "true"]],
+            "Plugins": {"Volume": ["local"], "Network": ["bridge", "host", "none"]},
+            "MemoryLimit": True,
+            "SwapLimit": True,
+            "CpuCfsPeriod": True,
+            "CpuCfsQuota": True,
+            "CgroupDriver": "cgroupfs",
+            "CgroupVersion": "1",
+            "NCPU": NCPU,
+            "MemTotal": MEM_TOTAL,
+            "Name": "docker-mock",
+            "ServerVersion": "20.10.99-mock",
+            "KernelVersion": os.uname().release,
+            "OperatingSystem": "Docker mock daemon",
+            "OSType": "linux",
+            "Architecture": "x86_64",
+            "DockerRootDir": "/var/lib/docker",
+            "Swarm": {"NodeID": "", "LocalNodeState": "inactive", "ControlAvailable": False},
+            "Labels": [],
+        }
+
+
+class Handler(socketserver.StreamRequestHandler):
+
+    def read_request(self):
+        # the module terminates request by "\r\n\n", curl by "\r\n\r\n"
+        data = b""
+        while b"\n\n" not in data and b"\r\n\r\n" not in data:
+            chunk = self.request.recv(4096)
+            if not chunk:
+                break
+            data += chunk
+            if len(data) > 65536:
+                break
+        line = data.split(b"\n", 1)[0].decode("latin-1").strip()
+        parts = line.split(" ")
+        if len(parts) < 2:
+            return None, None, {}
+        url = urllib.parse.urlsplit(parts[1])
+        path = url.path
+        # strip /v1.41 like API version prefix
+        if path.startswith("/v1.") and path.count("/") > 1:
+            path = "/" + path.split("/", 2)[2]
+        return parts[0], path, urllib.parse.parse_qs(url.query)
+
+    def delay(self, endpoint):
+        opts = self.server.opts
+        ms = opts.latency + (random.uniform(0, opts.jitter) if opts.jitter else 0)
+        ms += opts.endpoint_latency.get(endpoint, 0)
+        if ms > 0:
+            time.sleep(ms / 1000.0)
+
+    def send(self, data):
+        """Send bytes, honouring dribble/disconnect options. False = connection dropped."""
+        opts = self.server.opts
+        if opts.disconnect_rate and random.random() < opts.disconnect_rate:
+            cut = random.randint(0, len(data))
+            self.server.stat("disconnects")
+            try:
+                self.wfile.write(data[:cut])
+                self.wfile.flush()
+            except OSError:
+                pass
+            return False
+        try:
+            if opts.dribble > 0:
+                for i in range(0, len(data), opts.dribble):
+                    self.wfile.write(data[i:i + opts.dribble])
+                    self.wfile.flush()
+                    if opts.dribble_delay:
+                        time.sleep(opts.dribble_delay / 1000.0)
+            else:
+                self.wfile.write(data)
+                self.wfile.flush()
+        except OSError:
+            return False
+        return True
+
+    def headers(self, status, content_type="application/json", length=None):
+        reason = {200: "OK", 404: "Not Found", 400: "Bad Request", 409: "Conflict"}.get(status, "OK")
+        h = "HTTP/1.0 %d %s\r\nApi-Version: %s\r\nContent-Type: %s\r\nServer: Docker/mock (linux)\r\n" % (
+            status, reason, API_VERSION, content_type)
+        h += "Date: %s\r\n" % time.strftime("%a, %d %b %Y %H:%M:%S GMT", time.gmtime())
+        if length is not None:
+            h += "Content-Length: %d\r\n" % length
+        return (h + "\r\n").encode()
+
+    def reply(self, status, body, content_type="application/json"):
+        if not isinstance(body, bytes):
+            body = (json.dumps(body, separators=(",", ":")) + "\n").encode()
+        self.send(self.headers(status, content_type, len(body)) + body)
+
+    def not_found(self, what):
+        self.reply(404, {"message": "No such %s" % what})
+
+    def handle(self):
+        method, path, query = self.read_request()
+        if method is None:
+            return
+        pop = self.server.population
+        parts = [p for p in path.split("/") if p]
+        endpoint = parts[0].lstrip("_") if parts else ""
+        if len(parts) == 3 and parts[0] == "containers":
+            endpoint = parts[2]
+        self.server.stat(endpoint or "unknown")
+        self.delay(endpoint)
+
+        if method != "GET":
+            self.reply(400, {"message": "only GET is supported by mock"})
+        elif path == "/_ping":
+            self.reply(200, b"OK", "text/plain; charset=utf-8")
+        elif path == "/info":
+            self.reply(200, pop.info())
+        elif path == "/containers/json":
+            all_ = query.get("all", ["0"])[0] in ("1", "true", "True")
+            rows = [pop.summary(c) for c in pop.containers if all_ or pop.running(c)]
+            self.reply(200, rows)
+        elif len(parts) == 3 and parts[0] == "containers" and parts[2] == "json":
+            c = pop.find(parts[1])
+            if c is None:
+                self.not_found("container: %s" % parts[1])
+            else:
+                self.reply(200, pop.inspect(c))
+        elif len(parts) == 3 and parts[0] == "containers" and parts[2] == "stats":
+            c = pop.find(parts[1])
+            if c is None:
+                self.not_found("container: %s" % parts[1])
+            else:
+                self.stats(c, query.get("stream", ["1"])[0] not in ("0", "false", "False"))
+        elif path == "/events":
+            self.events()
+        elif path == "/images/json":
+            images = pop.images
+            if "dangling" in query.get("filters", [""])[0] or query.get("dangling", [""])[0] == "true":
+                images = images[:pop.dangling_images]
+            self.reply(200, [{"Id": i, "RepoTags": ["<none>:<none>"], "Size": 1024 * 1024} for i in images])
+        elif path == "/volumes":
+            volumes = pop.volumes
+            if "dangling" in query.get("filters", [""])[0]:
+                volumes = volumes[:pop.dangling_volumes]
+            self.reply(200, {"Volumes": [{"Name": v, "Driver": "local", "Mountpoint": "/var/lib/docker/volumes/%s/_data" % v}
+                                         for v in volumes], "Warnings": None})
+        else:
+            self.reply(404, b"404 page not found\n", "text/plain; charset=utf-8")
+
+    def stats(self, c, stream):
+        opts = self.server.opts
+        # dockerd waits for the second sample before the first stats document
+        if opts.stats_delay:
+            time.sleep(opts.stats_delay / 1000.0)
+        if not self.send(self.headers(200)):
+            return
+        # stream=0 is primed by the second sample, the first frame of a stream has no pre-stats
+        delta = None if stream else 1
+        while True:
+            body = (json.dumps(self.server.population.stats(c, time.time(), delta), separators=(",", ":")) + "\n").encode()
+            if not self.send(body) or not stream:
+                return
+            time.sleep(opts.stats_interval)
+            delta = opts.stats_interval
+
+    def events(self):
+        opts = self.server.opts
+        pop = self.server.population
+        if not self.send(self.headers(200)):
+            return
+        rnd = random.Random()
+        while pop.containers:
+            time.sleep(opts.events_interval)
+            c = rnd.choice(pop.containers)
+            action = rnd.choice(["start", "die", "oom", "health_status: healthy"])
+            now = time.time()
+            event = {"status": action, "id": c["id"], "from": c["image"], "Type": "container", "Action": action,
+                     "Actor": {"ID": c["id"], "Attributes": {"image": c["image"], "name": c["name"]}},
+                     "scope": "local", "time": int(now), "timeNano": int(now * 1e9)}
+            if not self.send((json.dumps(event, separators=(",", ":")) + "\n").encode()):
+                return
+
+
+class Server(socketserver.ThreadingMixIn, socketserver.UnixStreamServer):
+    daemon_threads = True
+
+    def __init__(self, path, opts, population):
+        self.opts = opts
+        self.population = population
+        self.counters = {}
+        self.lock = threading.Lock()
+        socketserver.UnixStreamServer.__init__(self, path, Handler)
+
+    def stat(self, name):
+        with self.lock:
+            self.counters[name] = self.counters.get(name, 0) + 1
+
+
+def endpoint_latency(values):
+    result = {}
+    for v in values or []:
+        name, _, ms = v.partition("=")
+        result[name.strip("/")] = float(ms)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Mock Docker daemon for zabbix_module_docker testing")
+    parser.add_argument("--socket", default="/tmp/docker-mock.sock", help="unix socket path (default %(default)s)")
+    parser.add_argument("--containers", type=int, default=10, help="container population, 10 - 10000 (default %(default)s)")
+    parser.add_argument("--running", type=float, default=0.8, help="ratio of running containers (default %(default)s)")
+    parser.add_argument("--paused", type=float, default=0.05, help="ratio of paused containers (default %(default)s)")
+    parser.add_argument("--crashed", type=float, default=0.05, help="ratio of exited != 0 containers (default %(default)s)")
+    parser.add_argument("--images", type=int, default=20, help="number of images (default %(default)s)")
+    parser.add_argument("--volumes", type=int, default=10, help="number of volumes (default %(default)s)")
+    parser.add_argument("--seed", default="zabbix", help="population seed (default %(default)s)")
+    parser.add_argument("--latency", type=float, default=0, help="response latency in ms")
+    parser.add_argument("--jitter", type=float, default=0, help="random latency jitter in ms")
+    parser.add_argument("--endpoint-latency", action="append", metavar="ENDPOINT=MS",
+                        help="extra latency for endpoint: ping, info, json, stats, events, images, volumes")
+    parser.add_argument("--dribble", type=int, default=0, help="send responses in chunks of N bytes")
+    parser.add_argument("--dribble-delay", type=float, default=0, help="delay between dribbled chunks in ms")
+    parser.add_argument("--disconnect-rate", type=float, default=0, help="probability of dropped connection, 0 - 1")
+    parser.add_argument("--stats-delay", type=float, default=0, help="delay before first stats document in ms")
+    parser.add_argument("--stats-interval", type=float, default=1.0, help="stats stream interval in s")
+    parser.add_argument("--events-interval", type=float, default=1.0, help="events stream interval in s")
+    parser.add_argument("--list", action="store_true", help="print container population and exit")
+    opts = parser.parse_args()
+    opts.endpoint_latency = endpoint_latency(opts.endpoint_latency)
+
+    if not 10 <= opts.containers <= 10000:
+        parser.error("--containers must be 10 - 10000")
+    population = Population(opts)
+
+    if opts.list:
+        for c in population.containers:
+            print("%s %s %s" % (c["id"], c["name"], c["state"]))
+        return 0
+
+    if os.path.exists(opts.socket):
+        os.unlink(opts.socket)
+    server = Server(opts.socket, opts, population)
+    os.chmod(opts.socket, 0o666)
+    signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+    print("docker mock: %d containers on unix://%s" % (len(population.containers), opts.socket), file=sys.stderr)
+    try:
+        server.serve_forever()
+    except (KeyboardInterrupt, SystemExit):
+        pass
+    finally:
+        server.server_close()
+        os.unlink(opts.socket)
+        print("docker mock: requests %s" % json.dumps(server.counters, sort_keys=True), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,184 @@
+/*
+** Microbenchmark of cgroup stat-file parsing in zabbix_module_docker
+**
+** Compares the former per-item parser (fopen, fgets into MAX_STRING_LEN
+** buffer, strncmp against every line, sscanf) with the scanner of
+** zabbix_module_docker_scan.h (single read, SIMD newline/space scan, perfect
+** hash of known keys) for scalar, SSE2 and AVX2 masks:
+**
+**   gcc -O2 -Wall -I src/modules/zabbix_module_docker -o scan_bench tools/scan_bench.c
+**   ./tools/cgroup_fixtures.py --root /tmp/cgroup-v2 --layout v2-cgroupfs --containers 1
+**   ./scan_bench /tmp/cgroup-v2/sys/fs/cgroup/docker/<id>/memory.stat 20000
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include "zabbix_module_docker_scan.h"
+
+#define MAX_STRING_LEN  2048
+
+static double   now(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// former parser, it's called for every item
+static int      stdio_lookup(FILE *file, const char *metric, uint64_t *value)
+{
+        char    line[MAX_STRING_LEN], metric2[256];
+
+        snprintf(metric2, sizeof(metric2), "%s ", metric);
+        while (NULL != fgets(line, sizeof(line), file))
+        {
+                if (0 != strncmp(line, metric2, strlen(metric2)))
+                        continue;
+                if (1 == sscanf(line, "%*s %" SCNu64, value))
+                        return 1;
+        }
+        return 0;
+}
+
+static int      stdio_file(const char *path, const char *metric, uint64_t *value)
+{
+        FILE    *file;
+        int     ret;
+
+        if (NULL == (file = fopen(path, "r")))
+                return 0;
+        ret = stdio_lookup(file, metric, value);
+        fclose(file);
+        return ret;
+}
+
+static void     report(const char *name, double seconds, long ops, double base)
+{
+        double  ns = seconds * 1e9 / ops;
+
+        if (0 == base)
+                printf("%-40s %10.1f ns/op\n", name, ns);
+        else
+                printf("%-40s %10.1f ns/op %8.2fx\n", name, ns, base / ns);
+}
+
+int     main(int argc, char **argv)
+{
+        static zbx_docker_scan_t        scan;
+        const char      *isa_names[] = {"scalar", "sse2", "avx2"};
+        char            **metrics, name[128];
+        int             nmetrics, i, isa, iterations = argc > 2 ? atoi(argv[2]) : 10000;
+        long            n;
+        double          start, base_lookup, base_all, base_parse;
+        uint64_t        value, check = 0, check2 = 0;
+
+        if (argc < 2)
+        {
+                fprintf(stderr, "usage: %s <stat file> [iterations]\n", argv[0]);
+                return 1;
+        }
+        if (0 > zbx_docker_scan_file(&scan, argv[1]))
+        {
+                perror(argv[1]);
+                return 1;
+        }
+
+        // every key of the file is one metric (item)
+        nmetrics = scan.lines_num;
+        metrics = malloc(sizeof(char *) * nmetrics);
+        for (i = 0; i < nmetrics; i++)
+                metrics[i] = strndup(scan.lines[i].key, scan.lines[i].key_len);
+        printf("%s: %zu bytes, %d lines, %d iterations, detected %s\n\n", argv[1], scan.len, nmetrics, iterations,
+                        isa_names[zbx_docker_scan_isa]);
+
+        // one item = one file read and one lookup
+        start = now();
+        for (n = 0; n < iterations; n++)
+        {
+                for (i = 0; i < nmetrics; i++)
+                {
+                        if (1 == stdio_file(argv[1], metrics[i], &value))
+                                check += value;
+                }
+        }
+        report("item: fopen+fgets+strncmp+sscanf", base_lookup = now() - start, (long)iterations * nmetrics, 0);
+
+        start = now();
+        for (n = 0; n < iterations; n++)
+        {
+                for (i = 0; i < nmetrics; i++)
+                {
+                        if (0 <= zbx_docker_scan_file(&scan, argv[1]) && 1 == zbx_docker_scan_value(&scan, metrics[i],
+                                        &value))
+                                check2 += value;
+                }
+        }
+        report("item: read+scan+hash", now() - start, (long)iterations * nmetrics, base_lookup * 1e9 /
+                        ((long)iterations * nmetrics));
+
+        // all metrics of one container, e.g. bulk or background collection
+        start = now();
+        for (n = 0; n < iterations; n++)
+        {
+                FILE    *file = fopen(argv[1], "r");
+
+                for (i = 0; i < nmetrics; i++)
+                {
+                        rewind(file);
+                        stdio_lookup(file, metrics[i], &value);
+                }
+                fclose(file);
+        }
+        report("container: fopen, fgets pass per metric", base_all = now() - start, iterations, 0);
+
+        start = now();
+        for (n = 0; n < iterations; n++)
+        {
+                zbx_docker_scan_file(&scan, argv[1]);
+                for (i = 0; i < nmetrics; i++)
+                        zbx_docker_scan_value(&scan, metrics[i], &value);
+        }
+        report("container: read+scan, hash lookups", now() - start, iterations, base_all * 1e9 / iterations);
+
+        // parsing only, file is in memory
+        printf("\n");
+        start = now();
+        for (n = 0; n < iterations; n++)
+        {
+                FILE    *file = fmemopen(scan.buffer, scan.len, "r");
+
+                while (NULL != fgets(name, sizeof(name), file))
+                        sscanf(name, "%*s %" SCNu64, &value);
+                fclose(file);
+        }
+        report("parse: fgets+sscanf all lines", base_parse = now() - start, iterations, 0);
+
+        for (isa = ZBX_DOCKER_SCAN_ISA_SCALAR; isa <= ZBX_DOCKER_SCAN_ISA_AVX2; isa++)
+        {
+#if !defined(ZBX_DOCKER_SCAN_X86)
+                if (ZBX_DOCKER_SCAN_ISA_SCALAR != isa)
+                        break;
+#else
+                __builtin_cpu_init();
+                if (ZBX_DOCKER_SCAN_ISA_AVX2 == isa && !__builtin_cpu_supports("avx2"))
+                        break;
+#endif
+                zbx_docker_scan_isa = isa;
+                start = now();
+                for (n = 0; n < iterations; n++)
+                        zbx_docker_scan_buffer(&scan);
+                snprintf(name, sizeof(name), "parse: scan (%s) all lines", isa_names[isa]);
+                report(name, now() - start, iterations, base_parse * 1e9 / iterations);
+        }
+
+        if (check != check2)
+                printf("\nWARNING: parsers returned different values\n");
+        for (i = 0; i < nmetrics; i++)
+                free(metrics[i]);
+        free(metrics);
+        return 0;
+}
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Perfect hash generator of cgroup stat-file keys for zabbix_module_docker.
+
+Known keys of memory.stat (v1 and v2), cpu.stat, cpuacct.stat and io.stat are
+mapped to ZBX_DOCKER_STAT_* ids by a collision-free FNV-1a hash, so the
+scanner in zabbix_module_docker_scan.h resolves every parsed line with one
+hash, one table load and one memcmp. The generated block of the header is
+replaced in place:
+
+    ./tools/stat_keys_gen.py src/modules/zabbix_module_docker/zabbix_module_docker_scan.h
+
+Add new kernel keys to the lists below and rerun it. Unknown keys still work
+in the module, they are only looked up by slower string comparison.
+"""
+
+import re
+import sys
+
+# memory.stat v1, local and hierarchical (total_) counters
+MEMORY_V1 = ["cache", "rss", "rss_huge", "shmem", "mapped_file", "dirty", "writeback", "swap", "pgpgin",
+             "pgpgout", "pgfault", "pgmajfault", "inactive_anon", "active_anon", "inactive_file", "active_file",
+             "unevictable"]
+MEMORY_V1 = MEMORY_V1 + ["total_" + k for k in MEMORY_V1] + ["hierarchical_memory_limit", "hierarchical_memsw_limit"]
+
+# memory.stat v2
+MEMORY_V2 = ["anon", "file", "kernel", "kernel_stack", "pagetables", "sec_pagetables", "percpu", "sock", "vmalloc",
+             "shmem", "zswap", "zswapped", "file_mapped", "file_dirty", "file_writeback", "swapcached", "anon_thp",
+             "file_thp", "shmem_thp", "inactive_anon", "active_anon", "inactive_file", "active_file", "unevictable",
+             "slab_reclaimable", "slab_unreclaimable", "slab", "workingset_refault_anon", "workingset_refault_file",
+             "workingset_activate_anon", "workingset_activate_file", "workingset_restore_anon",
+             "workingset_restore_file", "workingset_nodereclaim", "pgscan", "pgsteal", "pgscan_kswapd",
+             "pgscan_direct", "pgscan_khugepaged", "pgsteal_kswapd", "pgsteal_direct", "pgsteal_khugepaged",
+             "pgfault", "pgmajfault", "pgrefill", "pgactivate", "pgdeactivate", "pglazyfree", "pglazyfreed",
+             "zswpin", "zswpout", "thp_fault_alloc", "thp_collapse_alloc"]
+
+# cpu.stat v1 and v2, cpuacct.stat v1
+CPU = ["nr_periods", "nr_throttled", "throttled_time", "usage_usec", "user_usec", "system_usec", "throttled_usec",
+       "nr_bursts", "burst_usec", "core_sched.force_idle_usec", "user", "system"]
+
+# io.stat v2 fields (<major>:<minor> rbytes=N wbytes=N ...)
+IO = ["rbytes", "wbytes", "rios", "wios", "dbytes", "dios"]
+
+BEGIN = "// generated by tools/stat_keys_gen.py - do not edit - begin"
+END = "// generated by tools/stat_keys_gen.py - end"
+FNV_PRIME = 0x01000193
+
+
+def keys():
+    result = []
+    for k in MEMORY_V1 + MEMORY_V2 + CPU + IO:
+        if k not in result:
+            result.append(k)
+    return result
+
+
+def fnv1a(seed, key):
+    h = seed
+    for c in key.encode():
+        h = ((h ^ c) * FNV_PRIME) & 0xffffffff
+    return h
+
+
+def search(names, bits):
+    size = 1 << bits
+    for seed in range(0x811c9dc5, 0x811c9dc5 + 20000):
+        slots = {}
+        for index, name in enumerate(names):
+            slot = fnv1a(seed, name) & (size - 1)
+            if slot in slots:
+                break
+            slots[slot] = index
+        else:
+            return seed, slots
+    return None, None
+
+
+def generate():
+    names = keys()
+    for bits in range(8, 13):
+        seed, slots = search(names, bits)
+        if seed is not None:
+            break
+    else:
+        sys.exit("cannot find perfect hash")
+    size = 1 << bits
+    out = [BEGIN]
+    out.append("enum")
+    out.append("{")
+    for name in names:
+        out.append("        ZBX_DOCKER_STAT_%s," % re.sub(r"[^A-Za-z0-9]", "_", name).upper())
+    out.append("        ZBX_DOCKER_STAT_COUNT")
+    out.append("};")
+    out.append("")
+    out.append("static const char      *const zbx_docker_stat_names[ZBX_DOCKER_STAT_COUNT] =")
+    out.append("{")
+    line = "       "
+    for name in names:
+        item = ' "%s",' % name
+        if len(line) + len(item) > 112:
+            out.append(line)
+            line = "       "
+        line += item
+    out.append(line)
+    out.append("};")
+    out.append("")
+    out.append("#define ZBX_DOCKER_STAT_HASH_SEED       0x%08xU" % seed)
+    out.append("#define ZBX_DOCKER_STAT_HASH_MASK       0x%x" % (size - 1))
+    out.append("")
+    out.append("// hash slot -> ZBX_DOCKER_STAT_* id, -1 for empty slot")
+    out.append("static const short     zbx_docker_stat_slots[ZBX_DOCKER_STAT_HASH_MASK + 1] =")
+    out.append("{")
+    table = [str(slots.get(i, -1)) for i in range(size)]
+    for i in range(0, size, 16):
+        out.append("        " + ", ".join(table[i:i + 16]) + ",")
+    out.append("};")
+    out.append(END)
+    return "\n".join(out)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: %s <zabbix_module_docker_scan.h>" % sys.argv[0])
+    with open(sys.argv[1]) as f:
+        header = f.read()
+    begin, end = header.find(BEGIN), header.find(END)
+    if begin < 0 or end < 0:
+        sys.exit("generated block markers not found in %s" % sys.argv[1])
+    header = header[:begin] + generate() + header[end + len(END):]
+    with open(sys.argv[1], "w") as f:
+        f.write(header)
+    print("%s: %d keys" % (sys.argv[1], len(keys())))
+
+
+if __name__ == "__main__":
+    main()